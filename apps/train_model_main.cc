@@ -1,19 +1,1178 @@
 #include <iostream>
 
 #include <algorithm>
+#include <core/cascade_classifier.h>
+#include <core/dataset_reader.h>
+#include <core/directory_loader.h>
+#include <core/embedded_model.h>
+#include <core/evaluator.h>
+#include <core/feature_counts.h>
+#include <core/memory_accounting.h>
+#include <core/metrics.h>
 #include <core/model.h>
+#include <core/parallel.h>
+#include <core/progressive_evaluator.h>
+#include <core/pruned_table.h>
+#include <core/sketch_grid.h>
+#include <core/stream_classifier.h>
+#include <core/stroke_log.h>
+#include <core/tracer.h>
 #include <fstream>
+#include <string>
+#include <vector>
 
-int main() {
+/**
+ * Removes a flag and its value from the command line arguments
+ *
+ * @param args the command line arguments
+ * @param flag the name of the flag
+ * @param value populated with the value of the flag, if it was passed
+ * @return whether the flag was passed
+ */
+bool ExtractFlag(std::vector<std::string> &args, const std::string &flag,
+                 std::string &value) {
+  auto flag_itr = std::find(args.begin(), args.end(), flag);
+
+  if (flag_itr == args.end() || flag_itr + 1 == args.end()) {
+    return false;
+  }
+
+  value = *(flag_itr + 1);
+  args.erase(flag_itr, flag_itr + 2);
+
+  return true;
+}
+
+/**
+ * Removes a flag without a value from the command line arguments
+ *
+ * @param args the command line arguments
+ * @param flag the name of the flag
+ * @return whether the flag was passed
+ */
+bool ExtractSwitch(std::vector<std::string> &args, const std::string &flag) {
+  auto flag_itr = std::find(args.begin(), args.end(), flag);
+
+  if (flag_itr == args.end()) {
+    return false;
+  }
+
+  args.erase(flag_itr);
+
+  return true;
+}
+
+/**
+ * Parses a non-negative whole number passed on the command line
+ *
+ * @param value the text of the number
+ * @param name the name of the argument, for the error message
+ * @return the parsed number
+ * @throws std::invalid_argument if the text is not a whole number
+ */
+size_t ParseCount(const std::string &value, const std::string &name) {
+  size_t parsed_length = 0;
+  unsigned long long number = 0;
+
+  try {
+    if (!value.empty() && value[0] != '-') {
+      number = std::stoull(value, &parsed_length);
+    }
+  } catch (const std::logic_error &) {
+    parsed_length = 0;
+  }
+
+  if (parsed_length == 0 || parsed_length != value.length()) {
+    throw std::invalid_argument("Invalid " + name + ": " + value);
+  }
+
+  return size_t(number);
+}
+
+/**
+ * Parses a number passed on the command line
+ *
+ * @param value the text of the number
+ * @param name the name of the argument, for the error message
+ * @return the parsed number
+ * @throws std::invalid_argument if the text is not a number
+ */
+double ParseNumber(const std::string &value, const std::string &name) {
+  size_t parsed_length = 0;
+  double number = 0.0;
+
+  try {
+    number = std::stod(value, &parsed_length);
+  } catch (const std::logic_error &) {
+    parsed_length = 0;
+  }
+
+  if (parsed_length == 0 || parsed_length != value.length()) {
+    throw std::invalid_argument("Invalid " + name + ": " + value);
+  }
+
+  return number;
+}
+
+/**
+ * Opens a file for reading, reporting the path if it cannot be opened
+ *
+ * @param stream the stream to open
+ * @param path the path of the file
+ * @param mode the mode to open the file in
+ * @return whether the file was opened
+ */
+bool OpenInput(std::ifstream &stream, const std::string &path,
+               std::ios::openmode mode = std::ios::in) {
+  stream.open(path, mode);
+
+  if (!stream) {
+    std::cerr << "Cannot open " << path << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Opens a file for writing, reporting the path if it cannot be opened
+ *
+ * @param stream the stream to open
+ * @param path the path of the file
+ * @return whether the file was opened
+ */
+bool OpenOutput(std::ofstream &stream, const std::string &path) {
+  stream.open(path);
+
+  if (!stream) {
+    std::cerr << "Cannot write " << path << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Loads a saved model, reporting the path if it cannot be opened. Model::Load
+ * would otherwise fail on the empty stream with no mention of the file
+ *
+ * @param model the model to load into
+ * @param path the path of the saved model
+ * @return whether the file was opened
+ * @throws std::invalid_argument if the file is not a valid model
+ */
+bool LoadModel(naivebayes::Model &model, const std::string &path) {
+  std::ifstream model_stream;
+
+  if (!OpenInput(model_stream, path)) {
+    return false;
+  }
+
+  model.Load(path);
+  return true;
+}
+
+/**
+ * Counts the images of a training dataset in parallel and saves the raw counts
+ * so that they can later be merged with the counts of other shards. The
+ * dataset is either a single file of images or a directory of .txt files that
+ * each hold one image
+ *
+ * usage: train-model count <dataset> <output counts>
+ * [--counting scalar|bitsliced]
+ */
+int CountDataset(std::vector<std::string> args) {
+  std::string backend_name = "bitsliced";
+  ExtractFlag(args, "--counting", backend_name);
+
+  if (args.size() != 2 ||
+      (backend_name != "scalar" && backend_name != "bitsliced")) {
+    std::cerr << "usage: train-model count <dataset> <output counts> "
+                 "[--counting scalar|bitsliced]"
+              << std::endl;
+    return 1;
+  }
+
+  naivebayes::CountingBackend backend =
+      backend_name == "scalar" ? naivebayes::CountingBackend::kScalar
+                               : naivebayes::CountingBackend::kBitSliced;
+  naivebayes::FeatureCounts counts;
+
+  if (naivebayes::DirectoryLoader::IsDirectory(args[0])) {
+    counts = naivebayes::DirectoryLoader(args[0]).CountFeatures(0, backend);
+  } else {
+    counts = naivebayes::DatasetReader(args[0]).CountFeatures(0, backend);
+  }
+
+  std::ofstream counts_stream;
+
+  if (!OpenOutput(counts_stream, args[1])) {
+    return 1;
+  }
+
+  counts_stream << counts;
+
+  return counts_stream ? 0 : 1;
+}
+
+/**
+ * Sums any number of saved count shards into a single counts file
+ *
+ * usage: train-model merge <output counts> <shard> [<shard> ...]
+ */
+int MergeCounts(const std::vector<std::string> &args) {
+  if (args.size() < 2) {
+    std::cerr << "usage: train-model merge <output counts> <shard> "
+                 "[<shard> ...]"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<naivebayes::FeatureCounts> shards(args.size() - 1);
+
+  for (size_t shard = 0; shard < shards.size(); ++shard) {
+    std::ifstream shard_stream;
+
+    if (!OpenInput(shard_stream, args[shard + 1])) {
+      return 1;
+    }
+
+    shard_stream >> shards[shard];
+  }
+
+  std::ofstream counts_stream;
+
+  if (!OpenOutput(counts_stream, args[0])) {
+    return 1;
+  }
+
+  counts_stream << naivebayes::FeatureCounts::Merge(shards);
+
+  return counts_stream ? 0 : 1;
+}
+
+/**
+ * Compiles a saved counts file into a model that can be loaded for inference
+ *
+ * usage: train-model compile <counts> <output model>
+ */
+int CompileCounts(const std::vector<std::string> &args) {
+  if (args.size() != 2) {
+    std::cerr << "usage: train-model compile <counts> <output model>"
+              << std::endl;
+    return 1;
+  }
+
+  naivebayes::FeatureCounts counts;
+
+  std::ifstream counts_stream;
+
+  if (!OpenInput(counts_stream, args[0])) {
+    return 1;
+  }
+
+  counts_stream >> counts;
 
   naivebayes::Model model;
+  model.Train(counts);
 
-  std::ifstream training_image_stream(
-      "../data/datasets/trainingimagesandlabels.txt");
+  std::ofstream model_stream;
+
+  if (!OpenOutput(model_stream, args[1])) {
+    return 1;
+  }
+
+  model_stream << model;
+
+  return model_stream ? 0 : 1;
+}
+
+/**
+ * Runs a k-fold cross validation over a training dataset and prints the
+ * accuracy of every fold
+ *
+ * usage: train-model crossvalidate <dataset> <number of folds>
+ */
+int CrossValidateDataset(const std::vector<std::string> &args) {
+  if (args.size() != 2) {
+    std::cerr << "usage: train-model crossvalidate <dataset> <number of folds>"
+              << std::endl;
+    return 1;
+  }
+
+  size_t num_folds = ParseCount(args[1], "number of folds");
+  naivebayes::Model model;
+  std::ifstream training_image_stream;
+
+  if (!OpenInput(training_image_stream, args[0])) {
+    return 1;
+  }
 
   training_image_stream >> model;
 
-  model.Train();
+  naivebayes::CrossValidationReport report = model.CrossValidate(num_folds);
+
+  std::cout << "Fold  |  Images  |  Accuracy" << std::endl;
+
+  for (size_t fold = 0; fold < report.folds.size(); ++fold) {
+    std::cout << fold << "  |  " << report.folds[fold].num_images << "  |  "
+              << report.folds[fold].accuracy << std::endl;
+  }
+
+  std::cout << "Mean accuracy: " << report.mean_accuracy << " +/- "
+            << report.accuracy_std_dev << std::endl;
+  std::cout << "Pooled accuracy: " << report.pooled_accuracy << std::endl;
+
+  return 0;
+}
+
+/**
+ * Compiles one model per Laplace smoothing value from a single count of a
+ * training dataset and prints the accuracy of each against a testing dataset
+ *
+ * usage: train-model sweep <training dataset> <testing dataset> <laplace>
+ * [<laplace> ...]
+ */
+int SweepLaplace(const std::vector<std::string> &args) {
+  if (args.size() < 3) {
+    std::cerr << "usage: train-model sweep <training dataset> "
+                 "<testing dataset> <laplace> [<laplace> ...]"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<float> laplace_values;
+
+  for (size_t arg = 2; arg < args.size(); ++arg) {
+    double laplace = ParseNumber(args[arg], "laplace value");
+
+    if (!(laplace > 0.0)) {
+      throw std::invalid_argument("Laplace values must be positive: " +
+                                  args[arg]);
+    }
+
+    laplace_values.push_back(float(laplace));
+  }
+
+  std::ifstream testing_stream;
+
+  if (!OpenInput(testing_stream, args[1])) {
+    return 1;
+  }
+
+  naivebayes::DatasetReader training_reader(args[0]);
+
+  std::vector<naivebayes::ModelEvaluation> evaluations =
+      naivebayes::Evaluator().SweepLaplace(training_reader.CountFeatures(),
+                                           laplace_values, testing_stream);
+
+  std::cout << "Laplace  |  Accuracy" << std::endl;
+
+  for (size_t value = 0; value < laplace_values.size(); ++value) {
+    std::cout << laplace_values[value] << "  |  "
+              << evaluations[value].accuracy << std::endl;
+  }
+
+  return 0;
+}
+
+/**
+ * Counts a training dataset once, compiling a model at each checkpoint number
+ * of training images, and writes the accuracy of every checkpoint against a
+ * testing dataset as CSV
+ *
+ * usage: train-model curve <training dataset> <testing dataset> <checkpoint>
+ * [<checkpoint> ...] [--laplace <value>] [--output <csv>]
+ */
+int LearningCurve(std::vector<std::string> args) {
+  std::string laplace = "1";
+  std::string output_path;
+  ExtractFlag(args, "--laplace", laplace);
+  bool has_output = ExtractFlag(args, "--output", output_path);
+
+  if (args.size() < 3) {
+    std::cerr << "usage: train-model curve <training dataset> "
+                 "<testing dataset> <checkpoint> [<checkpoint> ...] "
+                 "[--laplace <value>] [--output <csv>]"
+              << std::endl;
+    return 1;
+  }
+
+  float laplace_value = float(ParseNumber(laplace, "laplace value"));
+  std::vector<size_t> checkpoints;
+
+  for (size_t arg = 2; arg < args.size(); ++arg) {
+    checkpoints.push_back(ParseCount(args[arg], "checkpoint"));
+  }
+
+  std::ifstream training_stream;
+  std::ifstream testing_stream;
+  std::ofstream output_stream;
+
+  if (!OpenInput(training_stream, args[0]) ||
+      !OpenInput(testing_stream, args[1]) ||
+      (has_output && !OpenOutput(output_stream, output_path))) {
+    return 1;
+  }
+
+  std::vector<naivebayes::LearningCurvePoint> curve =
+      naivebayes::Evaluator().LearningCurve(training_stream, checkpoints,
+                                            testing_stream, laplace_value);
+
+  if (has_output) {
+    naivebayes::Evaluator::WriteLearningCurve(output_stream, curve);
+    return output_stream ? 0 : 1;
+  }
+
+  naivebayes::Evaluator::WriteLearningCurve(std::cout, curve);
+
+  return 0;
+}
+
+/**
+ * Scores several saved models against a testing dataset in a single pass and
+ * prints a side by side comparison against the first model
+ *
+ * usage: train-model compare <testing dataset> <model> [<model> ...]
+ */
+int CompareModels(const std::vector<std::string> &args) {
+  if (args.size() < 2) {
+    std::cerr << "usage: train-model compare <testing dataset> <model> "
+                 "[<model> ...]"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> model_paths(args.begin() + 1, args.end());
+  std::vector<naivebayes::LogProbTable> tables;
+
+  for (const std::string &model_path : model_paths) {
+    naivebayes::Model model;
+
+    if (!LoadModel(model, model_path)) {
+      return 1;
+    }
+
+    tables.emplace_back(*model.GetTrainer());
+  }
+
+  std::vector<const naivebayes::LogProbTable *> table_pointers;
+
+  for (const naivebayes::LogProbTable &table : tables) {
+    table_pointers.push_back(&table);
+  }
+
+  std::ifstream testing_stream;
+
+  if (!OpenInput(testing_stream, args[0])) {
+    return 1;
+  }
+
+  naivebayes::ComparisonReport report =
+      naivebayes::Evaluator().Compare(testing_stream, table_pointers);
+
+  naivebayes::Evaluator::PrintComparison(std::cout, report, model_paths);
+
+  return 0;
+}
+
+/**
+ * Classifies a testing dataset with a saved model using branch and bound early
+ * exits, and reports how much scoring work was skipped
+ *
+ * usage: train-model earlyexit <model> <testing dataset>
+ */
+int EarlyExitReport(const std::vector<std::string> &args) {
+  if (args.size() != 2) {
+    std::cerr << "usage: train-model earlyexit <model> <testing dataset>"
+              << std::endl;
+    return 1;
+  }
+
+  naivebayes::Model model;
+  std::ifstream testing_stream;
+
+  if (!LoadModel(model, args[0]) || !OpenInput(testing_stream, args[1])) {
+    return 1;
+  }
+
+  naivebayes::LogProbTable table(*model.GetTrainer());
+  naivebayes::Image image;
+  naivebayes::EarlyExitStats stats = {0, 0, 0};
+  size_t num_mismatches = 0;
+
+  while (naivebayes::DatasetReader::ReadImage(testing_stream, image)) {
+    if (table.ClassifyEarlyExit(image, &stats) != table.Classify(image)) {
+      ++num_mismatches;
+    }
+  }
+
+  float skipped = 0.0f;
+
+  if (stats.features_total > 0) {
+    skipped = 1.0f - float(stats.features_scored) / float(stats.features_total);
+  }
+
+  std::cout << "Images: " << stats.num_images << std::endl;
+  std::cout << "Features scored: " << stats.features_scored << " of "
+            << stats.features_total << std::endl;
+  std::cout << "Work skipped: " << skipped * 100.0f << "%" << std::endl;
+  std::cout << "Mismatches with exhaustive scoring: " << num_mismatches
+            << std::endl;
+
+  return num_mismatches == 0 ? 0 : 1;
+}
+
+/**
+ * Reads every image of a dataset file into memory
+ *
+ * @param path the path of the dataset
+ * @param images populated with the images of the dataset
+ * @return whether the file was opened
+ * @throws std::invalid_argument if the dataset is malformed
+ */
+bool ReadAllImages(const std::string &path,
+                   std::vector<naivebayes::Image> &images) {
+  std::ifstream input;
+
+  if (!OpenInput(input, path)) {
+    return false;
+  }
+
+  naivebayes::Image image;
+
+  while (naivebayes::DatasetReader::ReadImage(input, image)) {
+    images.push_back(image);
+  }
+
+  return true;
+}
+
+/**
+ * Trains a downsampled companion to a saved model on the first 90% of a
+ * training dataset, calibrates its margin threshold on the remaining 10% and
+ * reports how a coarse to fine cascade of the two models classifies a testing
+ * dataset
+ *
+ * usage: train-model cascade <model> <training dataset> <testing dataset>
+ * [--pool <factor>] [--agreement <fraction>]
+ */
+int CascadeEvaluation(std::vector<std::string> args) {
+  std::string pool_factor = "2";
+  std::string agreement = "0.999";
+  ExtractFlag(args, "--pool", pool_factor);
+  ExtractFlag(args, "--agreement", agreement);
+
+  if (args.size() != 3) {
+    std::cerr << "usage: train-model cascade <model> <training dataset> "
+                 "<testing dataset> [--pool <factor>] "
+                 "[--agreement <fraction>]"
+              << std::endl;
+    return 1;
+  }
+
+  size_t pool = ParseCount(pool_factor, "pool factor");
+  double agreement_target = ParseNumber(agreement, "agreement");
+
+  naivebayes::Model model;
+  std::vector<naivebayes::Image> training_images;
+  std::vector<naivebayes::Image> testing_images;
+
+  if (!LoadModel(model, args[0]) || !ReadAllImages(args[1], training_images) ||
+      !ReadAllImages(args[2], testing_images)) {
+    return 1;
+  }
+
+  naivebayes::LogProbTable full_table(*model.GetTrainer());
+
+  auto calibration_begin =
+      training_images.begin() + training_images.size() * 9 / 10;
+  std::vector<naivebayes::Image> calibration_images(calibration_begin,
+                                                    training_images.end());
+  training_images.erase(calibration_begin, training_images.end());
+
+  naivebayes::LogProbTable coarse_table =
+      naivebayes::CascadeClassifier::TrainCoarseTable(training_images, pool);
+  naivebayes::CascadeClassifier cascade(full_table, coarse_table, pool);
+  float threshold = cascade.Calibrate(calibration_images, agreement_target);
+
+  std::cout << "Margin threshold: " << threshold << std::endl;
+  naivebayes::CascadeClassifier::PrintReport(std::cout,
+                                             cascade.Evaluate(testing_images));
+
+  return 0;
+}
+
+/**
+ * Scores a testing dataset against a saved model in a random order, stopping
+ * at a checkpoint once the confidence interval of the accuracy is narrower
+ * than a width or the model is statistically worse than a baseline model.
+ * Checkpoints start at the minimum number of images and double from there
+ *
+ * usage: train-model progressive <model> <testing dataset>
+ * [--baseline <model>] [--width <width>] [--confidence <level>]
+ * [--min-images <count>] [--seed <seed>] [--unstratified]
+ */
+int EvaluateProgressively(std::vector<std::string> args) {
+  std::string baseline_path;
+  bool has_baseline = ExtractFlag(args, "--baseline", baseline_path);
+  std::string width = "0.01";
+  std::string confidence = "0.95";
+  std::string min_images = "100";
+  std::string seed = "0";
+  ExtractFlag(args, "--width", width);
+  ExtractFlag(args, "--confidence", confidence);
+  ExtractFlag(args, "--min-images", min_images);
+  ExtractFlag(args, "--seed", seed);
+  bool is_stratified = !ExtractSwitch(args, "--unstratified");
+
+  if (args.size() != 2) {
+    std::cerr << "usage: train-model progressive <model> <testing dataset> "
+                 "[--baseline <model>] [--width <width>] "
+                 "[--confidence <level>] [--min-images <count>] "
+                 "[--seed <seed>] [--unstratified]"
+              << std::endl;
+    return 1;
+  }
+
+  naivebayes::ProgressiveEvaluator evaluator(
+      {ParseNumber(confidence, "confidence"), ParseNumber(width, "width"),
+       ParseCount(min_images, "minimum images"), is_stratified,
+       ParseCount(seed, "seed")});
+
+  naivebayes::Model model;
+
+  if (!LoadModel(model, args[0])) {
+    return 1;
+  }
+
+  naivebayes::LogProbTable table(*model.GetTrainer());
+  naivebayes::LogProbTable baseline_table;
+
+  if (has_baseline) {
+    naivebayes::Model baseline_model;
+
+    if (!LoadModel(baseline_model, baseline_path)) {
+      return 1;
+    }
+
+    baseline_table = naivebayes::LogProbTable(*baseline_model.GetTrainer());
+  }
+
+  std::vector<naivebayes::Image> testing_images;
+
+  if (!ReadAllImages(args[1], testing_images)) {
+    return 1;
+  }
+
+  naivebayes::ProgressiveEvaluation evaluation = evaluator.Evaluate(
+      testing_images, table, has_baseline ? &baseline_table : nullptr);
+
+  naivebayes::ProgressiveEvaluator::PrintEvaluation(std::cout, evaluation);
+
+  return evaluation.stop == naivebayes::ProgressiveStop::kWorseThanBaseline
+             ? 1
+             : 0;
+}
+
+/**
+ * Removes the pixel ranking flag from the command line arguments
+ *
+ * @param args the command line arguments
+ * @param ranking populated with the ranking, if the flag was passed
+ * @return false if the flag names an unknown ranking
+ */
+bool ExtractRanking(std::vector<std::string> &args,
+                    naivebayes::PixelRanking &ranking) {
+  std::string ranking_name = "mi";
+  ExtractFlag(args, "--ranking", ranking_name);
+
+  if (ranking_name == "mi") {
+    ranking = naivebayes::PixelRanking::kMutualInformation;
+  } else if (ranking_name == "divergence") {
+    ranking = naivebayes::PixelRanking::kMaxDivergence;
+  } else {
+    std::cerr << "Unknown pixel ranking: " << ranking_name << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Prunes a saved model to the pixels that best tell its labels apart and saves
+ * the pruned model
+ *
+ * usage: train-model prune <model> <number of pixels> <output pruned model>
+ * [--ranking mi|divergence]
+ */
+int PruneModel(std::vector<std::string> args) {
+  naivebayes::PixelRanking ranking;
+
+  if (!ExtractRanking(args, ranking)) {
+    return 1;
+  }
+
+  if (args.size() != 3) {
+    std::cerr << "usage: train-model prune <model> <number of pixels> "
+                 "<output pruned model> [--ranking mi|divergence]"
+              << std::endl;
+    return 1;
+  }
+
+  size_t num_pixels = ParseCount(args[1], "number of pixels");
+  naivebayes::Model model;
+
+  if (!LoadModel(model, args[0])) {
+    return 1;
+  }
+
+  naivebayes::LogProbTable table(*model.GetTrainer());
+  naivebayes::PrunedTable pruned(table, num_pixels, ranking);
+  std::ofstream output_stream;
+
+  if (!OpenOutput(output_stream, args[2])) {
+    return 1;
+  }
+
+  output_stream << pruned;
+
+  return output_stream ? 0 : 1;
+}
+
+/**
+ * Prints the accuracy of a saved model pruned to each number of pixels
+ * against a testing dataset, next to the unpruned model
+ *
+ * usage: train-model prunereport <model> <testing dataset> <number of pixels>
+ * [<number of pixels> ...] [--ranking mi|divergence]
+ */
+int PruningReport(std::vector<std::string> args) {
+  naivebayes::PixelRanking ranking;
+
+  if (!ExtractRanking(args, ranking)) {
+    return 1;
+  }
+
+  if (args.size() < 3) {
+    std::cerr << "usage: train-model prunereport <model> <testing dataset> "
+                 "<number of pixels> [<number of pixels> ...] "
+                 "[--ranking mi|divergence]"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<size_t> pruned_counts;
+
+  for (size_t arg = 2; arg < args.size(); ++arg) {
+    pruned_counts.push_back(ParseCount(args[arg], "number of pixels"));
+  }
+
+  naivebayes::Model model;
+  std::ifstream testing_stream;
+
+  if (!LoadModel(model, args[0]) || !OpenInput(testing_stream, args[1])) {
+    return 1;
+  }
+
+  naivebayes::LogProbTable table(*model.GetTrainer());
+
+  size_t num_pixels = table.GetImageSize() * table.GetImageSize();
+  // The unpruned model is always the first row, to compare the others with
+  std::vector<size_t> pixel_counts{num_pixels};
+  pixel_counts.insert(pixel_counts.end(), pruned_counts.begin(),
+                      pruned_counts.end());
+
+  std::vector<naivebayes::PruningPoint> points =
+      naivebayes::PrunedTable::EvaluatePruning(table, testing_stream,
+                                               pixel_counts, ranking);
+
+  std::cout << "Pixels  |  Fraction scored  |  Accuracy  |  Delta  |  "
+               "Disagreements"
+            << std::endl;
+
+  for (const naivebayes::PruningPoint &point : points) {
+    std::cout << point.num_pixels << "  |  "
+              << float(point.num_pixels) / float(num_pixels) << "  |  "
+              << point.accuracy << "  |  "
+              << point.accuracy - points.front().accuracy << "  |  "
+              << point.num_disagreements << std::endl;
+  }
+
+  return 0;
+}
+
+/**
+ * Generates a C++ source that compiles the log probabilities of a saved model
+ * into a program, so that it can classify without loading a model file
+ *
+ * usage: train-model embed <model> <output source> [<function name>]
+ */
+int EmbedModel(const std::vector<std::string> &args) {
+  if (args.size() != 2 && args.size() != 3) {
+    std::cerr << "usage: train-model embed <model> <output source> "
+                 "[<function name>]"
+              << std::endl;
+    return 1;
+  }
+
+  naivebayes::Model model;
+
+  if (!LoadModel(model, args[0])) {
+    return 1;
+  }
+
+  naivebayes::LogProbTable table(*model.GetTrainer());
+  std::ofstream source_stream;
+
+  if (!OpenOutput(source_stream, args[1])) {
+    return 1;
+  }
+
+  naivebayes::WriteEmbeddedModel(
+      table, args.size() == 3 ? args[2] : "GetEmbeddedModel", source_stream);
+
+  return source_stream ? 0 : 1;
+}
+
+/**
+ * Prints the latency distribution of one kind of sketchpad event
+ *
+ * @param name the name of the kind of event
+ * @param latency the latencies of the events in nanoseconds
+ */
+void PrintLatency(const std::string &name,
+                  const naivebayes::Histogram &latency) {
+  std::cout << name << ": " << latency.GetCount() << " events, p50 "
+            << latency.Quantile(0.5) << " ns, p99 " << latency.Quantile(0.99)
+            << " ns, max " << latency.Quantile(1.0) << " ns" << std::endl;
+}
+
+/**
+ * Replays a recorded sketchpad session through the brush, predictions and
+ * clears without a window, and reports the latency of each kind of event
+ *
+ * usage: train-model replay <model> <stroke log> [<repetitions>]
+ */
+int ReplayStrokes(const std::vector<std::string> &args) {
+  if (args.size() != 2 && args.size() != 3) {
+    std::cerr << "usage: train-model replay <model> <stroke log> "
+                 "[<repetitions>]"
+              << std::endl;
+    return 1;
+  }
+
+  size_t repetitions =
+      args.size() == 3 ? ParseCount(args[2], "number of repetitions") : 1;
+
+  if (repetitions == 0) {
+    std::cerr << "Repetitions must be at least 1" << std::endl;
+    return 1;
+  }
+
+  naivebayes::Model model;
+  std::ifstream stroke_stream;
+
+  if (!LoadModel(model, args[0]) || !OpenInput(stroke_stream, args[1])) {
+    return 1;
+  }
+
+  std::vector<naivebayes::StrokeEvent> events =
+      naivebayes::ReadStrokeLog(stroke_stream);
+  naivebayes::SketchGrid grid(model.GetTrainer()->GetImageSize());
+  naivebayes::StrokeReplayer replayer(grid, model);
+
+  for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+    replayer.Replay(events);
+    grid.Clear();
+  }
+
+  std::cout << "Events replayed: " << events.size() * repetitions << std::endl;
+  PrintLatency("Brush",
+               replayer.GetLatency(naivebayes::StrokeEventType::kBrushDown));
+  PrintLatency("Predict",
+               replayer.GetLatency(naivebayes::StrokeEventType::kPredict));
+  PrintLatency("Clear",
+               replayer.GetLatency(naivebayes::StrokeEventType::kClear));
+
+  std::string predictions = replayer.GetPredictions();
+  std::cout << "Predictions: "
+            << predictions.substr(0, predictions.size() / repetitions)
+            << std::endl;
+
+  return 0;
+}
+
+/**
+ * Classifies every image file of a directory, writing the file name and the
+ * predicted label of each image to stdout in sorted file name order
+ *
+ * @param table the scoring table of the model
+ * @param directory_path the directory of image files
+ * @param num_threads the number of threads to load and classify with
+ */
+void ClassifyDirectory(const naivebayes::LogProbTable &table,
+                       const std::string &directory_path, size_t num_threads) {
+  naivebayes::DirectoryLoader loader(directory_path);
+  std::vector<naivebayes::Image> images = loader.LoadImages(num_threads);
+  std::vector<char> predictions(images.size());
+
+  naivebayes::ParallelFor(images.size(), num_threads,
+                          [&](size_t, size_t begin, size_t end) {
+                            for (size_t image = begin; image < end; ++image) {
+                              predictions[image] =
+                                  table.Classify(images[image]);
+                            }
+                          });
+
+  for (size_t image = 0; image < images.size(); ++image) {
+    std::cout << loader.GetFilePaths()[image] << '\t' << predictions[image]
+              << '\n';
+  }
+}
+
+/**
+ * Classifies a stream of images with a saved model, writing one predicted
+ * label per line in input order, optionally followed by the log likelihood of
+ * every label. Images are read from a file, or from stdin if the input is -
+ * or not given. If the input is a directory of .txt files that each hold one
+ * image, every line is instead the file name and its predicted label. With
+ * --pruned, the model is one saved by prune and the input an ascii dataset
+ *
+ * usage: train-model classify <model> [<input>|-] [--scores] [--pruned]
+ * [--format ascii|packed] [--threads <count>] [--batch <images>]
+ */
+int ClassifyStream(std::vector<std::string> args) {
+  std::string format_name = "ascii";
+  std::string num_threads = "0";
+  std::string batch_size = "4096";
+
+  bool write_scores = ExtractSwitch(args, "--scores");
+  bool is_pruned = ExtractSwitch(args, "--pruned");
+  ExtractFlag(args, "--format", format_name);
+  ExtractFlag(args, "--threads", num_threads);
+  ExtractFlag(args, "--batch", batch_size);
+
+  if (args.empty() || args.size() > 2 ||
+      (format_name != "ascii" && format_name != "packed") ||
+      (is_pruned && format_name != "ascii")) {
+    std::cerr << "usage: train-model classify <model> [<input>|-] [--scores] "
+                 "[--pruned] [--format ascii|packed] [--threads <count>] "
+                 "[--batch <images>]"
+              << std::endl;
+    return 1;
+  }
+
+  naivebayes::StreamFormat format = format_name == "packed"
+                                        ? naivebayes::StreamFormat::kPacked
+                                        : naivebayes::StreamFormat::kAscii;
+
+  // Loaded without a Model so that nothing but predictions reaches stdout
+  std::ifstream model_stream;
+
+  if (!OpenInput(model_stream, args[0])) {
+    return 1;
+  }
+
+  std::ios::sync_with_stdio(false);
+
+  try {
+    size_t thread_count = ParseCount(num_threads, "thread count");
+    size_t batch_images = ParseCount(batch_size, "batch size");
+
+    bool is_directory =
+        args.size() == 2 && naivebayes::DirectoryLoader::IsDirectory(args[1]);
+    bool is_stdin = args.size() == 1 || args[1] == "-";
+    std::ifstream input_stream;
+
+    if (!is_directory && !is_stdin &&
+        !OpenInput(input_stream, args[1], std::ios::binary)) {
+      return 1;
+    }
+
+    std::istream &input = is_stdin ? std::cin : input_stream;
+
+    if (is_pruned) {
+      if (is_directory) {
+        throw std::invalid_argument("Pruned models only classify datasets");
+      }
+
+      naivebayes::PrunedTable pruned;
+      model_stream >> pruned;
+      pruned.Classify(input, std::cout, write_scores);
+      return 0;
+    }
+
+    naivebayes::Trainer trainer;
+    model_stream >> trainer;
+    naivebayes::LogProbTable table(trainer);
+    naivebayes::StreamClassifier classifier(table, thread_count, batch_images);
+
+    if (is_directory) {
+      ClassifyDirectory(table, args[1], thread_count);
+    } else {
+      classifier.Classify(input, std::cout, format, write_scores);
+    }
+  } catch (const std::logic_error &error) {
+    std::cout.flush();
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * Sums the allocations of every subsystem
+ *
+ * @return the total number of allocations and bytes allocated so far
+ */
+std::pair<uint64_t, uint64_t> TotalAllocations() {
+  std::pair<uint64_t, uint64_t> total(0, 0);
+
+  for (const auto &usage : naivebayes::AllocationTracker::GetSnapshot()) {
+    total.first += usage.allocations;
+    total.second += usage.bytes_allocated;
+  }
+
+  return total;
+}
+
+/**
+ * Prints the allocations made by an operation
+ *
+ * @param name the name of the operation
+ * @param before the total allocations before the operation
+ * @param num_runs the number of times the operation ran
+ */
+void PrintOperationAllocations(const std::string &name,
+                               const std::pair<uint64_t, uint64_t> &before,
+                               size_t num_runs) {
+  std::pair<uint64_t, uint64_t> after = TotalAllocations();
+  num_runs = std::max<size_t>(1, num_runs);
+
+  std::cout << name << "  |  " << (after.first - before.first) / num_runs
+            << "  |  " << (after.second - before.second) / num_runs
+            << std::endl;
+}
+
+/**
+ * Runs each stage of the pipeline once and reports the heap allocations of
+ * each, the heap usage of every subsystem and the peak resident set size.
+ * Allocations are only counted when built with NAIVEBAYES_TRACK_ALLOCATIONS
+ *
+ * usage: train-model memory <training dataset> <testing dataset>
+ */
+int MemoryReport(const std::vector<std::string> &args) {
+  if (args.size() != 2) {
+    std::cerr << "usage: train-model memory <training dataset> "
+                 "<testing dataset>"
+              << std::endl;
+    return 1;
+  }
+
+  std::ifstream testing_stream;
+
+  if (!OpenInput(testing_stream, args[1])) {
+    return 1;
+  }
+
+  std::cout << "-----------Allocations per operation-----------" << std::endl;
+  std::cout << "Operation  |  Allocations  |  Bytes" << std::endl;
+
+  std::pair<uint64_t, uint64_t> before = TotalAllocations();
+  naivebayes::FeatureCounts counts =
+      naivebayes::DatasetReader(args[0]).CountFeatures();
+  PrintOperationAllocations("count", before, 1);
+
+  naivebayes::Model model;
+  before = TotalAllocations();
+  model.Train(counts);
+  PrintOperationAllocations("train", before, 1);
+
+  std::vector<naivebayes::Image> images;
+  naivebayes::Image image;
+
+  while (images.size() < 100 &&
+         naivebayes::DatasetReader::ReadImage(testing_stream, image)) {
+    images.push_back(image);
+  }
+
+  before = TotalAllocations();
+
+  for (const naivebayes::Image &testing_image : images) {
+    model.Predict(testing_image.GetPixels());
+  }
+
+  PrintOperationAllocations("predict", before, images.size());
+
+  naivebayes::LogProbTable table(*model.GetTrainer());
+  testing_stream.clear();
+  testing_stream.seekg(0);
+  before = TotalAllocations();
+  naivebayes::Evaluator().Evaluate(testing_stream, {&table});
+  PrintOperationAllocations("evaluate", before, 1);
+
+  naivebayes::AllocationTracker::PrintReport(std::cout);
+
+  return 0;
+}
+
+/**
+ * Runs a subcommand, or trains and tests on the full dataset without one
+ *
+ * @param args the command line arguments after the program name
+ * @return the exit code of the program
+ */
+int RunCommand(std::vector<std::string> args) {
+  if (!args.empty()) {
+    std::string command = args[0];
+    args.erase(args.begin());
+
+    if (command == "count") {
+      return CountDataset(args);
+    } else if (command == "merge") {
+      return MergeCounts(args);
+    } else if (command == "compile") {
+      return CompileCounts(args);
+    } else if (command == "crossvalidate") {
+      return CrossValidateDataset(args);
+    } else if (command == "sweep") {
+      return SweepLaplace(args);
+    } else if (command == "curve") {
+      return LearningCurve(args);
+    } else if (command == "compare") {
+      return CompareModels(args);
+    } else if (command == "earlyexit") {
+      return EarlyExitReport(args);
+    } else if (command == "memory") {
+      return MemoryReport(args);
+    } else if (command == "cascade") {
+      return CascadeEvaluation(args);
+    } else if (command == "progressive") {
+      return EvaluateProgressively(args);
+    } else if (command == "prune") {
+      return PruneModel(args);
+    } else if (command == "prunereport") {
+      return PruningReport(args);
+    } else if (command == "embed") {
+      return EmbedModel(args);
+    } else if (command == "replay") {
+      return ReplayStrokes(args);
+    } else if (command == "classify") {
+      return ClassifyStream(args);
+    }
+
+    std::cerr << "Unknown command: " << command << std::endl;
+    return 1;
+  }
+
+  naivebayes::Model model;
+
+  naivebayes::DatasetReader training_reader(
+      "../data/datasets/trainingimagesandlabels.txt");
+
+  model.Train(training_reader.CountFeatures());
 
   std::cout << model.GetAccuracy("../data/datasets/testimagesandlabels.txt");
 
@@ -21,3 +1180,68 @@ int main() {
 
   return 0;
 }
+
+/**
+ * Writes every metric recorded while running to a file, or to stdout if the
+ * path is -
+ *
+ * @param path the file to write to
+ * @param format the text format to write
+ */
+void ExportMetrics(const std::string &path, naivebayes::MetricsFormat format) {
+  naivebayes::MetricsRegistry &registry = naivebayes::MetricsRegistry::Global();
+
+  if (path == "-") {
+    registry.Export(std::cout, format);
+    return;
+  }
+
+  std::ofstream metrics_stream(path);
+  registry.Export(metrics_stream, format);
+}
+
+/**
+ * usage: train-model [--metrics-json <path|->] [--metrics-prometheus <path|->]
+ *                    [--trace <path>] [<command> <args>...]
+ */
+int main(int argc, char **argv) {
+  std::vector<std::string> args(argv + std::min(argc, 1), argv + argc);
+  std::string json_path;
+  std::string prometheus_path;
+  std::string trace_path;
+
+  bool export_json = ExtractFlag(args, "--metrics-json", json_path);
+  bool export_prometheus =
+      ExtractFlag(args, "--metrics-prometheus", prometheus_path);
+  bool export_trace = ExtractFlag(args, "--trace", trace_path);
+
+  if (export_trace) {
+    naivebayes::Tracer::Global().Enable();
+  }
+
+  int exit_code = 1;
+
+  // Malformed datasets, models and arguments are reported rather than
+  // terminating the program
+  try {
+    exit_code = RunCommand(args);
+  } catch (const std::exception &error) {
+    std::cout.flush();
+    std::cerr << "train-model: " << error.what() << std::endl;
+  }
+
+  if (export_trace) {
+    std::ofstream trace_stream(trace_path);
+    naivebayes::Tracer::Global().WriteChromeTrace(trace_stream);
+  }
+
+  if (export_json) {
+    ExportMetrics(json_path, naivebayes::MetricsFormat::kJson);
+  }
+
+  if (export_prometheus) {
+    ExportMetrics(prometheus_path, naivebayes::MetricsFormat::kPrometheus);
+  }
+
+  return exit_code;
+}
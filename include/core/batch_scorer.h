@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "log_prob_table.h"
+
+namespace naivebayes {
+
+/**
+ * Scores many images at once as a matrix product between the one hot shades
+ * of the images and a LogProbTable. The table is copied into blocks of 16
+ * labels padded with zeros, and images are scored a tile at a time against a
+ * few rows of the table, so that the rows being added stay in L1 while every
+ * image of the tile streams through them. Each image accumulates its pixels
+ * in the same order as LogProbTable::Score, so the scores are identical
+ */
+class BatchScorer {
+
+public:
+  /**
+   * Instantiates a scorer for a compiled model
+   *
+   * @param table the compiled model to score with
+   * @param image_tile the number of images scored against a tile of the table
+   * before moving to the next tile
+   * @param row_tile the number of image rows in each tile of the table
+   */
+  explicit BatchScorer(const LogProbTable &table, size_t image_tile = 64,
+                       size_t row_tile = 4);
+
+  /**
+   * Calculates the log likelihood of every label for a batch of images stored
+   * as one shade per byte in a caller owned buffer
+   *
+   * @param pixels the first byte of the first image
+   * @param num_images the number of images in the batch
+   * @param row_stride the number of bytes between the starts of rows of an
+   * image
+   * @param image_stride the number of bytes between the starts of images
+   * @param scores populated with the likelihood of each label of each image,
+   * image by image in the order of GetLabels()
+   * @throws std::invalid_argument if a byte is not a shade of the table
+   */
+  void Score(const uint8_t *pixels, size_t num_images, size_t row_stride,
+             size_t image_stride, std::vector<float> &scores) const;
+
+  /**
+   * Predicts the classification of a batch of images as dense label indices,
+   * breaking ties towards the first label like LogProbTable::ClassifyIndex
+   *
+   * @param pixels the first byte of the first image
+   * @param num_images the number of images in the batch
+   * @param row_stride the number of bytes between the starts of rows
+   * @param image_stride the number of bytes between the starts of images
+   * @param scores scratch space for the likelihoods of every image
+   * @param predictions populated with the index in GetLabelSet() of the most
+   * likely label of each image
+   * @throws std::invalid_argument if a byte is not a shade of the table
+   */
+  void ClassifyIndices(const uint8_t *pixels, size_t num_images,
+                       size_t row_stride, size_t image_stride,
+                       std::vector<float> &scores,
+                       std::vector<size_t> &predictions) const;
+
+  /**
+   * Finds the first image of a batch with a byte that is not a shade of the
+   * table
+   *
+   * @param pixels the first byte of the first image
+   * @param num_images the number of images in the batch
+   * @param row_stride the number of bytes between the starts of rows
+   * @param image_stride the number of bytes between the starts of images
+   * @return the index of the first invalid image, or num_images if every
+   * image can be scored
+   */
+  size_t FindInvalidImage(const uint8_t *pixels, size_t num_images,
+                          size_t row_stride, size_t image_stride) const;
+
+  const LabelSet &GetLabelSet() const;
+
+  size_t GetImageSize() const;
+
+private:
+  /**
+   * Adds a tile of table rows to the scores of a tile of images for one
+   * block of labels
+   *
+   * @param pixels the first byte of the first image of the tile
+   * @param num_images the number of images in the tile
+   * @param row_stride the number of bytes between the starts of rows
+   * @param image_stride the number of bytes between the starts of images
+   * @param row_begin the first row of the tile
+   * @param row_end the row after the last row of the tile
+   * @param block_features the padded features of the block of labels
+   * @param tile_scores the running scores of the tile, one padded block of
+   * labels per image
+   */
+  void AddRowTile(const uint8_t *pixels, size_t num_images, size_t row_stride,
+                  size_t image_stride, size_t row_begin, size_t row_end,
+                  const float *block_features, float *tile_scores) const;
+
+  size_t image_size_;
+  size_t num_shades_;
+  size_t image_tile_;
+  size_t row_tile_;
+  LabelSet labels_;
+  std::vector<float> log_priors_;
+  // Indexed by label block, pixel, shade and label within the block
+  std::vector<float> block_features_;
+};
+} // namespace naivebayes
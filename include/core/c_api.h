@@ -0,0 +1,116 @@
+#pragma once
+
+/*
+ * A C interface to load a trained model and classify images held in caller
+ * owned byte buffers, for programs that are not built on the C++ types of
+ * this library. Every image is a square of image size by image size bytes,
+ * one byte per pixel, where 0 is unshaded, 1 is partially shaded and 2 is
+ * shaded. No function throws; failures return a status and leave a message
+ * for naivebayes_last_error
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(NAIVEBAYES_BUILDING_LIBRARY)
+#define NAIVEBAYES_API __declspec(dllexport)
+#elif defined(NAIVEBAYES_SHARED_LIBRARY)
+#define NAIVEBAYES_API __declspec(dllimport)
+#else
+#define NAIVEBAYES_API
+#endif
+#else
+#define NAIVEBAYES_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A loaded model, which can classify images from many threads at once */
+typedef struct naivebayes_model naivebayes_model;
+
+typedef enum naivebayes_status {
+  NAIVEBAYES_OK = 0,
+  /* A null pointer, a bad stride or a byte that is not a shade was passed */
+  NAIVEBAYES_INVALID_ARGUMENT = 1,
+  /* The model file could not be opened */
+  NAIVEBAYES_IO_ERROR = 2,
+  /* The model file or buffer is not a valid saved model */
+  NAIVEBAYES_INVALID_MODEL = 3,
+  /* Memory could not be allocated or an unexpected error occurred */
+  NAIVEBAYES_INTERNAL_ERROR = 4
+} naivebayes_status;
+
+/*
+ * Loads a model saved by train-model.
+ *
+ * path: the path of the saved model
+ * model: populated with the loaded model, which must be freed with
+ *        naivebayes_model_free
+ */
+NAIVEBAYES_API naivebayes_status
+naivebayes_model_load(const char *path, naivebayes_model **model);
+
+/*
+ * Loads a saved model from the contents of a model file already in memory.
+ *
+ * data: the text of the saved model, which is not kept after the call
+ * size: the number of bytes of data
+ * model: populated with the loaded model
+ */
+NAIVEBAYES_API naivebayes_status naivebayes_model_load_buffer(
+    const char *data, size_t size, naivebayes_model **model);
+
+/* Frees a loaded model. Passing null does nothing */
+NAIVEBAYES_API void naivebayes_model_free(naivebayes_model *model);
+
+/* Gets the number of pixels in one row or column of the model's images */
+NAIVEBAYES_API size_t
+naivebayes_model_image_size(const naivebayes_model *model);
+
+/* Gets the number of labels the model can predict */
+NAIVEBAYES_API size_t
+naivebayes_model_num_labels(const naivebayes_model *model);
+
+/* Gets a label of the model by its index, from 0 to num_labels - 1 */
+NAIVEBAYES_API char naivebayes_model_label(const naivebayes_model *model,
+                                           size_t index);
+
+/*
+ * Classifies a single image without copying it.
+ *
+ * pixels: the first byte of the image
+ * row_stride: the number of bytes from the start of one row to the start of
+ *             the next, at least the image size
+ * label: populated with the predicted label
+ */
+NAIVEBAYES_API naivebayes_status
+naivebayes_predict(const naivebayes_model *model, const uint8_t *pixels,
+                   size_t row_stride, char *label);
+
+/*
+ * Classifies a batch of images laid out at a fixed distance from each other,
+ * such as a contiguous array of images or a strided tensor. Stops at the first
+ * invalid image, leaving the labels of the images before it.
+ *
+ * pixels: the first byte of the first image
+ * num_images: the number of images in the batch
+ * row_stride: the number of bytes between the starts of rows of an image
+ * image_stride: the number of bytes between the starts of images
+ * labels: populated with one predicted label per image
+ */
+NAIVEBAYES_API naivebayes_status naivebayes_predict_batch(
+    const naivebayes_model *model, const uint8_t *pixels, size_t num_images,
+    size_t row_stride, size_t image_stride, char *labels);
+
+/*
+ * Gets a description of the last failure on the calling thread, which stays
+ * valid until the next call that fails on the thread.
+ */
+NAIVEBAYES_API const char *naivebayes_last_error(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+#include "image.h"
+#include "log_prob_table.h"
+
+namespace naivebayes {
+
+/**
+ * How a cascade resolved a set of images, compared against the full model
+ */
+struct CascadeReport {
+  size_t num_images;
+  // The number of images whose prediction came from the coarse model
+  size_t num_coarse;
+  // The number of images that fell through to the full model
+  size_t num_full;
+  size_t num_cascade_correct;
+  size_t num_full_correct;
+  // The number of images the cascade predicted differently from the full
+  // model alone
+  size_t num_disagreements;
+};
+
+/**
+ * Classifies with a cheap model trained on pooled images first, and only runs
+ * the full model when the margin between the best two labels of the cheap
+ * model is below a threshold. Most images are resolved by the cheap model, so
+ * the full price is only paid for the hard ones
+ */
+class CascadeClassifier {
+
+public:
+  /**
+   * Instantiates a cascade from a full model and a coarse companion model
+   *
+   * @param full_table the compiled full size model, which must outlive the
+   * cascade
+   * @param coarse_table the compiled model of pooled images, with the same
+   * labels as the full model, which must outlive the cascade
+   * @param pool_factor the number of full size pixels along each side of one
+   * pooled pixel
+   * @param margin_threshold the smallest coarse margin that is trusted
+   * without running the full model
+   * @throws std::invalid_argument if the sizes or labels of the models do not
+   * match the pool factor
+   */
+  CascadeClassifier(const LogProbTable &full_table,
+                    const LogProbTable &coarse_table, size_t pool_factor,
+                    float margin_threshold = 0.0f);
+
+  /**
+   * Pools each square of pixels of an image into one pixel holding their
+   * average shade, rounded to the nearest shade
+   *
+   * @param image the image to pool
+   * @param pool_factor the number of pixels along each side of a square
+   * @return the pooled image, with the label of the image
+   * @throws std::invalid_argument if the pool factor does not divide the
+   * image size
+   */
+  static Image Downsample(const Image &image, size_t pool_factor);
+
+  /**
+   * Trains the coarse companion model of a cascade from full size images
+   *
+   * @param images the full size training images
+   * @param pool_factor the number of pixels along each side of a square
+   * @param laplace the Laplace smoothing added to every count
+   * @return the compiled model of the pooled images
+   * @throws std::invalid_argument if there are no images or the pool factor
+   * does not divide their size
+   */
+  static LogProbTable TrainCoarseTable(const std::vector<Image> &images,
+                                       size_t pool_factor,
+                                       float laplace = 1.0f);
+
+  /**
+   * Picks the smallest margin threshold at which the cascade agrees with the
+   * full model on at least a fraction of a set of calibration images, and
+   * uses it from then on
+   *
+   * @param images held out images to calibrate on
+   * @param agreement the fraction of images whose cascade prediction must
+   * match the full model
+   * @return the new margin threshold
+   */
+  float Calibrate(const std::vector<Image> &images, double agreement);
+
+  /**
+   * Predicts the classification of an image
+   *
+   * @param image the full size image to classify
+   * @param is_coarse set to whether the coarse model made the prediction, if
+   * not null
+   * @return the predicted label
+   * @throws std::invalid_argument if the image size does not match the model
+   */
+  char Classify(const Image &image, bool *is_coarse = nullptr) const;
+
+  /**
+   * Classifies every image with both the cascade and the full model alone
+   *
+   * @param images the labeled images to evaluate
+   * @return how the cascade resolved the images and how its accuracy compares
+   * to the full model
+   */
+  CascadeReport Evaluate(const std::vector<Image> &images) const;
+
+  /**
+   * Writes a cascade report: the fraction of images resolved by each stage
+   * and the accuracy of the cascade against the full model
+   *
+   * @param output the output stream to write to
+   * @param report the report to write
+   */
+  static void PrintReport(std::ostream &output, const CascadeReport &report);
+
+  float GetMarginThreshold() const;
+
+  size_t GetPoolFactor() const;
+
+private:
+  /**
+   * Scores an image with the coarse model
+   *
+   * @param image the full size image
+   * @param scores populated with the coarse likelihood of each label
+   * @return the margin between the best and the second best label
+   */
+  float ScoreCoarse(const Image &image, std::vector<float> &scores) const;
+
+  const LogProbTable &full_table_;
+  const LogProbTable &coarse_table_;
+  size_t pool_factor_;
+  float margin_threshold_;
+};
+} // namespace naivebayes
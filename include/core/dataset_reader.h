@@ -0,0 +1,109 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "feature_counts.h"
+
+namespace naivebayes {
+
+/**
+ * Reads an ascii dataset file of labeled images in parallel by splitting the
+ * file into byte ranges. Each range is resynchronized to the first label line
+ * at or after its start, and owns every image whose label line begins inside
+ * of it, so the ranges together cover each image exactly once
+ */
+class DatasetReader {
+
+public:
+  /**
+   * Instantiates a reader for a dataset file
+   *
+   * @param file_path the path of the dataset file
+   * @param image_size the size of the images in the dataset, or 0 to read it
+   * from the first image of the file
+   * @throws std::invalid_argument if the file cannot be opened
+   */
+  explicit DatasetReader(const std::string &file_path, size_t image_size = 0);
+
+  /**
+   * Parses and counts every image in the dataset, splitting the file into one
+   * byte range per thread and merging the partial counts in file order
+   *
+   * @param num_threads the number of ranges to count concurrently, or 0 to use
+   * every available core
+   * @param backend the way to count the parsed images
+   * @return the counts of every image in the dataset
+   * @throws std::invalid_argument if the dataset is malformed
+   */
+  FeatureCounts
+  CountFeatures(size_t num_threads = 0,
+                CountingBackend backend = CountingBackend::kBitSliced) const;
+
+  /**
+   * Splits the file into byte ranges of roughly equal size
+   *
+   * @param num_ranges the number of ranges to split the file into
+   * @return the [begin, end) byte offsets of each range
+   */
+  std::vector<std::pair<size_t, size_t>> SplitRanges(size_t num_ranges) const;
+
+  /**
+   * Reads the next labeled image from a stream of an ascii dataset, taking the
+   * image size from the length of the image's first row
+   *
+   * @param input the input stream positioned at a label line
+   * @param image populated with the next image of the stream
+   * @return false once the stream has no more images
+   * @throws std::invalid_argument if the image is malformed
+   */
+  static bool ReadImage(std::istream &input, Image &image);
+
+  size_t GetImageSize() const;
+
+  size_t GetFileSize() const;
+
+private:
+  /**
+   * Reads the size of the images from the first image of the file
+   *
+   * @return the length of the first row of the first image
+   */
+  size_t DetectImageSize() const;
+
+  /**
+   * Positions a stream at the first label line starting at or after an offset
+   *
+   * @param file the stream of the dataset file
+   * @param offset the byte offset to start searching from
+   * @return the byte offset of the label line
+   */
+  size_t SeekRecordStart(std::ifstream &file, size_t offset) const;
+
+  /**
+   * Checks whether the line just read from a stream is a label line by
+   * checking that it is followed by a full image
+   *
+   * @param file the stream positioned after a candidate label line
+   * @return true if a whole image and then a label line or the end of the
+   * file follow
+   */
+  bool IsRecordAt(std::ifstream &file) const;
+
+  /**
+   * Parses and counts the images whose label lines start inside a byte range
+   *
+   * @param begin the first byte of the range
+   * @param end the byte after the last byte of the range
+   * @param backend the way to count the parsed images
+   * @return the counts of the images in the range
+   */
+  FeatureCounts CountRange(size_t begin, size_t end,
+                           CountingBackend backend) const;
+
+  std::string file_path_;
+  size_t image_size_;
+  size_t file_size_;
+};
+} // namespace naivebayes
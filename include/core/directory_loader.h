@@ -0,0 +1,132 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "feature_counts.h"
+#include "image.h"
+
+namespace naivebayes {
+
+/**
+ * The ways a DirectoryLoader can read files
+ */
+enum class IoBackend {
+  // Batched asynchronous reads through io_uring where the platform supports
+  // it, otherwise a pool of threads
+  kAuto,
+  // Blocking reads spread over a pool of threads
+  kThreadPool
+};
+
+// Reads files through io_uring where the platform supports it
+class IoUring;
+
+/**
+ * Loads a directory of files that each hold a single labeled ascii image, in
+ * the format read by operator>>(std::istream &, Image &). Files are read in
+ * batches, each batch read concurrently and then decoded in parallel, and
+ * images are delivered in the order of their sorted file names
+ */
+class DirectoryLoader {
+
+public:
+  /**
+   * Instantiates a loader for every file with an extension in a directory
+   *
+   * @param directory_path the directory of image files, which is not searched
+   * recursively
+   * @param extension the extension of the image files, or empty for every file
+   * @param backend the way to read the files
+   * @param batch_size the number of files read before they are decoded
+   * @throws std::invalid_argument if the directory cannot be opened
+   */
+  explicit DirectoryLoader(const std::string &directory_path,
+                           const std::string &extension = ".txt",
+                           IoBackend backend = IoBackend::kAuto,
+                           size_t batch_size = 256);
+
+  /**
+   * Reads and decodes every image of the directory
+   *
+   * @param num_threads the number of threads to read and decode with, or 0 to
+   * use every available core
+   * @return the images in the order of GetFilePaths()
+   * @throws std::invalid_argument if a file cannot be read or is not a valid
+   * image
+   */
+  std::vector<Image> LoadImages(size_t num_threads = 0) const;
+
+  /**
+   * Reads and counts every image of the directory without keeping the images,
+   * so that directories larger than memory can be trained on
+   *
+   * @param num_threads the number of threads to read and count with, or 0 to
+   * use every available core
+   * @param backend the way to count the decoded images
+   * @return the counts of every image
+   * @throws std::invalid_argument if a file cannot be read or is not a valid
+   * image
+   */
+  FeatureCounts
+  CountFeatures(size_t num_threads = 0,
+                CountingBackend backend = CountingBackend::kBitSliced) const;
+
+  /**
+   * Decodes the contents of a single image file
+   *
+   * @param contents the text of the file
+   * @return the labeled image
+   * @throws std::invalid_argument if the contents are not a square image
+   */
+  static Image DecodeImage(const std::string &contents);
+
+  /**
+   * Checks whether a path names a directory
+   *
+   * @param path the path to check
+   * @return true if the path exists and is a directory
+   */
+  static bool IsDirectory(const std::string &path);
+
+  /**
+   * Checks whether files can be read through io_uring on this machine
+   *
+   * @return true if the kernel accepts an io_uring
+   */
+  static bool IsIoUringAvailable();
+
+  const std::vector<std::string> &GetFilePaths() const;
+
+private:
+  /**
+   * Reads the whole contents of a range of the files
+   *
+   * @param begin the index of the first file to read
+   * @param end the index after the last file to read
+   * @param num_threads the number of threads for the thread pool backend
+   * @param ring the ring to read through, shared by every batch of a load, or
+   * nullptr to use the thread pool. Reset to nullptr if the kernel does not
+   * support the reads, so later batches go straight to the thread pool
+   * @param contents populated with the contents of each file in the range
+   * @throws std::invalid_argument if a file cannot be read
+   */
+  void ReadBatch(size_t begin, size_t end, size_t num_threads, IoUring *&ring,
+                 std::vector<std::string> &contents) const;
+
+  /**
+   * Reads and decodes the files batch by batch, passing each decoded batch to
+   * a consumer in file order
+   *
+   * @param num_threads the number of threads to read and decode with
+   * @param consume called as consume(begin, images) with the index of the
+   * first file of the batch and its images
+   */
+  template <typename Consumer>
+  void ForEachBatch(size_t num_threads, Consumer consume) const;
+
+  std::vector<std::string> file_paths_;
+  IoBackend backend_;
+  size_t batch_size_;
+};
+} // namespace naivebayes
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+namespace naivebayes {
+
+class LogProbTable;
+
+/**
+ * Represents the log probabilities of a trained model compiled into the
+ * program as static tables, so that it can classify without reading or
+ * parsing a model file. The tables use the same layout as a LogProbTable
+ */
+struct EmbeddedModel {
+  size_t image_size;
+  size_t num_shades;
+  size_t num_labels;
+  // The labels of the model in sorted order
+  const char *labels;
+  // The log prior of each label
+  const float *log_priors;
+  // The log feature probabilities in row, column, shade, label order
+  const float *log_features;
+};
+
+/**
+ * Writes a C++ source file defining a function that returns the log
+ * probabilities of a table as an EmbeddedModel. The tables are constexpr and
+ * cache line aligned, so they are placed in read only data by the compiler
+ *
+ * @param table the compiled log probabilities to embed
+ * @param function_name the name of the function to define in the naivebayes
+ * namespace
+ * @param output the output stream to write the source to
+ * @throws std::invalid_argument if the table has no labels or the function
+ * name is not a valid identifier
+ */
+void WriteEmbeddedModel(const LogProbTable &table,
+                        const std::string &function_name,
+                        std::ostream &output);
+
+/**
+ * Gets the model embedded at build time. Only defined when a generated model
+ * source is linked in, which the build does when NAIVEBAYES_EMBEDDED_MODEL is
+ * set
+ *
+ * @return the embedded log probabilities
+ */
+const EmbeddedModel &GetEmbeddedModel();
+
+} // namespace naivebayes
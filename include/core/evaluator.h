@@ -0,0 +1,149 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "feature_counts.h"
+#include "log_prob_table.h"
+
+namespace naivebayes {
+
+/**
+ * The accuracy of a single model over a testing dataset
+ */
+struct ModelEvaluation {
+  size_t num_images;
+  size_t num_correct;
+  float accuracy;
+  // The number of correct and wrong predictions of each label
+  std::map<char, std::map<bool, size_t>> confusion_matrix;
+};
+
+/**
+ * The side by side results of scoring several models against the same testing
+ * dataset
+ */
+struct ComparisonReport {
+  std::vector<ModelEvaluation> models;
+  // The number of images two models predicted differently, indexed by the
+  // positions of the two models
+  std::vector<std::vector<size_t>> disagreements;
+};
+
+/**
+ * The accuracy of a model trained on the first images of a training dataset
+ */
+struct LearningCurvePoint {
+  size_t num_training_images;
+  ModelEvaluation evaluation;
+};
+
+/**
+ * Scores the images of a testing dataset against any number of compiled
+ * models in a single pass. Images are decoded once, in batches, and each batch
+ * is scored against every model in parallel across the images
+ */
+class Evaluator {
+
+public:
+  /**
+   * Instantiates an evaluator
+   *
+   * @param num_threads the number of threads to score each batch with, or 0
+   * to use every available core
+   * @param batch_size the number of images decoded before they are scored
+   */
+  explicit Evaluator(size_t num_threads = 0, size_t batch_size = 1024);
+
+  /**
+   * Scores every image of a testing dataset against every model
+   *
+   * @param testing_stream the ascii dataset of testing images
+   * @param tables the compiled models to score the images against
+   * @return the evaluation of each model, in the order of the tables
+   * @throws std::invalid_argument if the dataset is malformed or does not
+   * match the size of the models
+   */
+  std::vector<ModelEvaluation>
+  Evaluate(std::istream &testing_stream,
+           const std::vector<const LogProbTable *> &tables) const;
+
+  /**
+   * Scores every image of a testing dataset against every model, also
+   * tracking how often each pair of models disagrees
+   *
+   * @param testing_stream the ascii dataset of testing images
+   * @param tables the compiled models to score the images against
+   * @return the evaluation of each model and their disagreements
+   * @throws std::invalid_argument if the dataset is malformed or does not
+   * match the size of the models
+   */
+  ComparisonReport
+  Compare(std::istream &testing_stream,
+          const std::vector<const LogProbTable *> &tables) const;
+
+  /**
+   * Writes a side by side report of compared models: the accuracy of each
+   * label and overall, the difference of each from the first model, and the
+   * number of images each model predicted differently from the first model
+   *
+   * @param output the output stream to write to
+   * @param report the compared models
+   * @param model_names the name to show for each model
+   */
+  static void PrintComparison(std::ostream &output,
+                              const ComparisonReport &report,
+                              const std::vector<std::string> &model_names);
+
+  /**
+   * Compiles one model per Laplace smoothing value from a single set of
+   * counts and scores all of them in one pass over a testing dataset
+   *
+   * @param counts the raw counts of the training images
+   * @param laplace_values the smoothing values to compile models with
+   * @param testing_stream the ascii dataset of testing images
+   * @return the evaluation of each smoothing value, in the order given
+   */
+  std::vector<ModelEvaluation>
+  SweepLaplace(const FeatureCounts &counts,
+               const std::vector<float> &laplace_values,
+               std::istream &testing_stream) const;
+
+  /**
+   * Counts a training dataset in a single pass, compiling a model from the
+   * running counts each time a checkpoint is reached, and scores every one of
+   * those models in one pass over a testing dataset. The training images are
+   * taken in the order of the stream, so a dataset sorted by label should be
+   * shuffled first
+   *
+   * @param training_stream the ascii dataset of training images
+   * @param checkpoints the numbers of training images to compile models at;
+   * checkpoints past the end of the training dataset are skipped
+   * @param testing_stream the ascii dataset of testing images
+   * @param laplace the smoothing value to compile every model with
+   * @return the evaluation of each checkpoint in increasing order, followed
+   * by the whole training dataset if it is not a checkpoint itself
+   * @throws std::invalid_argument if a checkpoint is zero, the smoothing
+   * value is not positive or a dataset is malformed
+   */
+  std::vector<LearningCurvePoint>
+  LearningCurve(std::istream &training_stream,
+                const std::vector<size_t> &checkpoints,
+                std::istream &testing_stream, float laplace = 1.0f) const;
+
+  /**
+   * Writes a learning curve as CSV with a header row, one row per point
+   *
+   * @param output the output stream to write to
+   * @param curve the points of the learning curve
+   */
+  static void WriteLearningCurve(std::ostream &output,
+                                 const std::vector<LearningCurvePoint> &curve);
+
+private:
+  size_t num_threads_;
+  size_t batch_size_;
+};
+} // namespace naivebayes
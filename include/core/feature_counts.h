@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "image.h"
+#include "label_set.h"
+
+namespace naivebayes {
+
+/**
+ * The ways FeatureCounts can count a batch of images, which give identical
+ * counts
+ */
+enum class CountingBackend {
+  // Increments one count per pixel of each image
+  kScalar,
+  // Transposes up to 64 images of a label into one bit per image for each
+  // pixel and shade, then counts every pixel with a popcount per word
+  kBitSliced
+};
+
+/**
+ * Represents the raw sufficient statistics of a training set: how many images
+ * of each label have each shade at each pixel, along with the number of
+ * images of each label. Unlike a Trainer, counts from separately trained
+ * shards can be summed together before being compiled into probabilities
+ */
+class FeatureCounts {
+
+public:
+  /**
+   * Default Constructor
+   */
+  FeatureCounts();
+
+  /**
+   * Initializes an empty set of counts with the given dimensions
+   *
+   * @param image_size the size of the images being counted
+   * @param num_shades the number of shades a pixel can take
+   * @param labels all of the labels the counts will track
+   */
+  FeatureCounts(size_t image_size, size_t num_shades,
+                const std::vector<char> &labels);
+
+  /**
+   * Adds the pixels of a single image to the counts, tracking the image's
+   * label if it has not been seen before
+   *
+   * @param image the labeled image to count
+   * @throws std::invalid_argument if the image size does not match the counts
+   */
+  void AddImage(const Image &image);
+
+  /**
+   * Adds the pixels of a batch of images to the counts, tracking any labels
+   * that have not been seen before
+   *
+   * @param images the labeled images to count
+   * @param backend the way to count the images
+   * @throws std::invalid_argument if an image size does not match the counts
+   * or an image is not square
+   */
+  void AddImages(const std::vector<const Image *> &images,
+                 CountingBackend backend = CountingBackend::kBitSliced);
+
+  /**
+   * Sums the counts of another shard into the current counts
+   *
+   * @param source the counts to add
+   * @return the current instance of the counts
+   * @throws std::invalid_argument if the dimensions of the shards differ
+   */
+  FeatureCounts &operator+=(const FeatureCounts &source);
+
+  /**
+   * Removes the counts of a subset of the images, such as a held out fold,
+   * from the current counts
+   *
+   * @param source the counts to remove
+   * @return the current instance of the counts
+   * @throws std::invalid_argument if the source counts are not a subset of the
+   * current counts
+   */
+  FeatureCounts &operator-=(const FeatureCounts &source);
+
+  /**
+   * Sums any number of shards into a single set of counts
+   *
+   * @param shards the counts to merge
+   * @return the merged counts
+   */
+  static FeatureCounts Merge(const std::vector<FeatureCounts> &shards);
+
+  /**
+   * Overrides ostream for FeatureCounts to write the raw counts to an output
+   * stream
+   *
+   * @param output the output stream to write to
+   * @param counts the counts to output to the stream
+   * @return the output stream
+   */
+  friend std::ostream &operator<<(std::ostream &output,
+                                  const FeatureCounts &counts);
+
+  /**
+   * Overrides istream for FeatureCounts to load serialized counts
+   *
+   * @param input the input stream to read in
+   * @param counts the counts to populate
+   * @return the input stream
+   * @throws std::invalid_argument if the stream is not a valid counts file
+   */
+  friend std::istream &operator>>(std::istream &input, FeatureCounts &counts);
+
+  /**
+   * Gets the number of images of a label with a shade at a pixel location
+   *
+   * @param label the label of the images
+   * @param row the row position in the image
+   * @param col the column position in the image
+   * @param shade the shade of the pixel
+   * @return the number of matching images
+   */
+  size_t GetCount(char label, size_t row, size_t col, size_t shade) const;
+
+  /**
+   * Gets the number of images counted for a label
+   *
+   * @param label the label of the images
+   * @return the number of images with the label
+   */
+  size_t GetLabelTotal(char label) const;
+
+  size_t GetTotal() const;
+
+  size_t GetImageSize() const;
+
+  size_t GetNumShades() const;
+
+  /**
+   * Gets the number of images of a label with a shade at a pixel location by
+   * the dense index of the label, without bounds checks
+   *
+   * @param label_index the index of the label in GetLabelSet()
+   * @param pixel the row major position of the pixel
+   * @param shade the shade of the pixel
+   * @return the number of matching images
+   */
+  size_t GetCountByIndex(size_t label_index, size_t pixel, size_t shade) const;
+
+  /**
+   * Gets the number of images counted for a label by its dense index
+   *
+   * @param label_index the index of the label in GetLabelSet()
+   * @return the number of images with the label
+   */
+  size_t GetLabelTotalByIndex(size_t label_index) const;
+
+  const std::vector<char> &GetLabels() const;
+
+  const LabelSet &GetLabelSet() const;
+
+private:
+
+  /**
+   * Starts tracking a new label, keeping the labels sorted
+   *
+   * @param label the label to add
+   */
+  void AddLabel(char label);
+
+  /**
+   * Counts up to 64 images of a single label with one bit per image
+   *
+   * @param images the images to count, which all have the label
+   * @param num_images the number of images, at most 64
+   * @param label_index the index of the label of the images
+   * @param planes scratch space for one word per pixel and nonzero shade
+   * @param plane_counts scratch space for the popcount of every plane
+   */
+  void AddBitSlicedBlock(const Image *const *images, size_t num_images,
+                         size_t label_index, std::vector<uint64_t> &planes,
+                         std::vector<uint32_t> &plane_counts);
+
+  /**
+   * Computes the flat index of a count
+   *
+   * @param pixel the row major position of the pixel
+   * @param shade the shade of the pixel
+   * @param label_index the index of the label
+   * @return the index into counts_
+   */
+  size_t CountIndex(size_t pixel, size_t shade, size_t label_index) const;
+
+  size_t image_size_;
+  size_t num_shades_;
+  LabelSet labels_;
+  std::vector<size_t> label_totals_;
+  // Stored in row, column, shade, label order like the Trainer features
+  std::vector<size_t> counts_;
+};
+} // namespace naivebayes
@@ -64,6 +64,17 @@ public:
   Image(size_t image_size, char image_label,
         const std::vector<std::vector<Pixel>> &pixels);
 
+  /**
+   * Instantiates a Training Image by taking ownership of already decoded
+   * pixels rather than copying them
+   *
+   * @param image_size the size of the Training Image
+   * @param image_label the label the Training Image represents
+   * @param pixels the status of each of the pixels, left empty afterwards
+   */
+  Image(size_t image_size, char image_label,
+        std::vector<std::vector<Pixel>> &&pixels);
+
   /**
    * Instantiates a Training Image by parsing the necessary information from a
    * string based representation of the Training Image
@@ -96,12 +107,15 @@ public:
 
   char GetLabel() const;
 
-  std::vector<std::vector<Pixel>> GetPixels() const;
+  /**
+   * Gets a read only view of the pixels of the Training Image, which stays
+   * valid until the image is modified, moved from or destroyed
+   *
+   * @return the status of each of the pixels, indexed by row then column
+   */
+  const std::vector<std::vector<Pixel>> &GetPixels() const;
 
 private:
-  const char kShadedChar = '#';
-  const char kPartiallyShadedChar = '+';
-
   size_t image_size_{};
   char image_label_{};
   std::vector<std::vector<Pixel>> pixels_;
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace naivebayes {
+
+/**
+ * Maps the external char labels of a model to dense indices 0..N-1 so that
+ * every internal table can be a flat array indexed by label. Labels are kept
+ * in sorted order, matching the order they are serialized in, and looking up
+ * the index of a label is a single array access
+ */
+class LabelSet {
+
+public:
+  /**
+   * Default Constructor
+   */
+  LabelSet();
+
+  /**
+   * Instantiates a label set from a list of labels, ignoring duplicates
+   *
+   * @param labels the labels to index
+   */
+  explicit LabelSet(const std::vector<char> &labels);
+
+  /**
+   * Adds a label to the set in its sorted position. The indices of any labels
+   * after it shift up by one
+   *
+   * @param label the label to add
+   * @return the index of the label
+   */
+  size_t Add(char label);
+
+  /**
+   * Checks whether a label is part of the set
+   *
+   * @param label the label to check
+   * @return true if the label has an index
+   */
+  bool Contains(char label) const;
+
+  /**
+   * Gets the dense index of a label
+   *
+   * @param label the label to look up
+   * @return the index of the label
+   * @throws std::out_of_range if the label is not part of the set
+   */
+  size_t IndexOf(char label) const;
+
+  /**
+   * Gets the label at a dense index
+   *
+   * @param index the index of the label
+   * @return the external label
+   * @throws std::out_of_range if the index is not part of the set
+   */
+  char LabelAt(size_t index) const;
+
+  size_t Size() const;
+
+  bool Empty() const;
+
+  const std::vector<char> &GetLabels() const;
+
+  /**
+   * Compares the labels of two sets
+   *
+   * @param other the set to compare to
+   * @return true if both sets hold the same labels
+   */
+  bool operator==(const LabelSet &other) const;
+
+  // Marks a char that has no index in the lookup table
+  static const size_t kNoIndex = size_t(-1);
+
+private:
+  /**
+   * Rebuilds the char to index lookup table from the sorted labels
+   */
+  void BuildIndex();
+
+  std::vector<char> labels_;
+  std::array<size_t, 256> indices_;
+};
+} // namespace naivebayes
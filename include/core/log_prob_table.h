@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "embedded_model.h"
+#include "image.h"
+#include "label_set.h"
+#include "trainer.h"
+
+namespace naivebayes {
+
+/**
+ * The amount of scoring work done by early exit classifications, summed over
+ * every image they are passed for
+ */
+struct EarlyExitStats {
+  size_t num_images;
+  // The number of per label feature additions performed
+  size_t features_scored;
+  // The number of per label feature additions an exhaustive scoring performs
+  size_t features_total;
+};
+
+/**
+ * Represents a Trainer compiled for inference: the log of every feature and
+ * prior probability stored in flat arrays, so that scoring an image is a
+ * sequence of additions with no lookups or copies. A table is never modified
+ * after construction, so it can score images from many threads at once
+ */
+class LogProbTable {
+
+public:
+  /**
+   * Default Constructor
+   */
+  LogProbTable();
+
+  /**
+   * Compiles the probabilities of a trained Trainer into log probabilities
+   *
+   * @param trainer the trained Trainer to compile
+   */
+  explicit LogProbTable(const Trainer &trainer);
+
+  /**
+   * Builds a table from log probabilities compiled into the program, so that
+   * nothing has to be read or parsed
+   *
+   * @param model the embedded log probabilities to copy
+   * @throws std::invalid_argument if the embedded model has no labels or is
+   * missing any of its tables
+   */
+  explicit LogProbTable(const EmbeddedModel &model);
+
+  /**
+   * Calculates the log likelihood of an image for every label
+   *
+   * @param image the image to score
+   * @param scores populated with the likelihood of each label, in the order of
+   * GetLabels()
+   * @throws std::invalid_argument if the image size does not match the table
+   */
+  void Score(const Image &image, std::vector<float> &scores) const;
+
+  /**
+   * Calculates the log likelihood of a grid of pixels for every label
+   *
+   * @param pixel_grid the pixels of the image to score
+   * @param scores populated with the likelihood of each label, in the order of
+   * GetLabels()
+   * @throws std::invalid_argument if the grid is not square or its size does
+   * not match the table
+   */
+  void Score(const std::vector<std::vector<Pixel>> &pixel_grid,
+             std::vector<float> &scores) const;
+
+  /**
+   * Calculates the log likelihood of an image stored as one shade per byte in
+   * a caller owned buffer, without copying it
+   *
+   * @param pixels the shade of each pixel, row by row, where each byte is a
+   * Pixel value
+   * @param row_stride the number of bytes from the start of one row to the
+   * start of the next
+   * @param scores populated with the likelihood of each label, in the order of
+   * GetLabels()
+   * @throws std::invalid_argument if a byte is not a shade of the table
+   */
+  void Score(const uint8_t *pixels, size_t row_stride,
+             std::vector<float> &scores) const;
+
+  /**
+   * Predicts the classification of an image
+   *
+   * @param image the image to classify
+   * @return the label with the highest likelihood
+   */
+  char Classify(const Image &image) const;
+
+  /**
+   * Predicts the classification of an image as a dense label index
+   *
+   * @param image the image to classify
+   * @return the index in GetLabelSet() of the most likely label
+   */
+  size_t ClassifyIndex(const Image &image) const;
+
+  /**
+   * Predicts the classification of a grid of pixels as a dense label index.
+   * Nothing is allocated once scores has room for every label, so callers
+   * can reuse the same scratch across predictions
+   *
+   * @param pixel_grid the pixels of the image to classify
+   * @param scores scratch space for the likelihood of each label
+   * @return the index in GetLabelSet() of the most likely label
+   * @throws std::invalid_argument if the grid is not square or its size does
+   * not match the table
+   */
+  size_t ClassifyIndex(const std::vector<std::vector<Pixel>> &pixel_grid,
+                       std::vector<float> &scores) const;
+
+  /**
+   * Predicts the classification of an image stored as one shade per byte in
+   * a caller owned buffer as a dense label index. Like the pixel grid
+   * overload, nothing is allocated once scores has room for every label
+   *
+   * @param pixels the shade of each pixel, row by row
+   * @param row_stride the number of bytes between the starts of rows
+   * @param scores scratch space for the likelihood of each label
+   * @return the index in GetLabelSet() of the most likely label
+   * @throws std::invalid_argument if a byte is not a shade of the table
+   */
+  size_t ClassifyIndex(const uint8_t *pixels, size_t row_stride,
+                       std::vector<float> &scores) const;
+
+  /**
+   * Predicts the classification of an image with branch and bound. The label
+   * leading after the first row is scored completely, then every other label
+   * stops being scored as soon as its partial likelihood plus the best score
+   * its remaining rows could reach falls below the leader. The prediction is
+   * always the same as Classify
+   *
+   * @param image the image to classify
+   * @param stats if not null, the work done is added to it
+   * @return the label with the highest likelihood
+   * @throws std::invalid_argument if the image size does not match the table
+   */
+  char ClassifyEarlyExit(const Image &image,
+                         EarlyExitStats *stats = nullptr) const;
+
+  const std::vector<char> &GetLabels() const;
+
+  const LabelSet &GetLabelSet() const;
+
+  size_t GetImageSize() const;
+
+  size_t GetNumShades() const;
+
+  const std::vector<float> &GetLogPriors() const;
+
+  /**
+   * Gets the log of every feature probability
+   *
+   * @return the log probabilities in row, column, shade, label order
+   */
+  const std::vector<float> &GetLogFeatures() const;
+
+private:
+  /**
+   * Computes the remaining row bounds and their tolerance from the log
+   * features, for early exit classification
+   */
+  void BuildBounds();
+  /**
+   * Adds up the log likelihood of every label over the pixels of an image
+   *
+   * @param pixel_at returns the shade of the pixel at a row and column
+   * @param scores populated with the likelihood of each label
+   * @throws std::invalid_argument if a shade is not part of the table
+   */
+  template <typename PixelAt>
+  void ScorePixels(PixelAt pixel_at, std::vector<float> &scores) const;
+
+  /**
+   * Finds the most likely label, preferring the first label on ties like
+   * Model::Predict
+   *
+   * @param scores the likelihood of each label
+   * @return the index of the most likely label
+   */
+  size_t ArgMax(const std::vector<float> &scores) const;
+
+  /**
+   * Adds the features of one row of an image to the likelihood of a label, in
+   * the same order as Score so that the sums match exactly
+   *
+   * @param shades the shade of every pixel of the image in row major order
+   * @param row the row of the image to add
+   * @param label the index of the label
+   * @param score the likelihood of the label so far
+   * @return the likelihood including the row
+   */
+  float AddRow(const std::vector<size_t> &shades, size_t row, size_t label,
+               float score) const;
+
+  size_t image_size_;
+  size_t num_shades_;
+  LabelSet labels_;
+  std::vector<float> log_priors_;
+  // Stored in row, column, shade, label order like the Trainer features
+  std::vector<float> log_features_;
+  // The highest score each label can gain from a row to the end of the image,
+  // stored in row, label order with a trailing row of zeros
+  std::vector<double> remaining_bounds_;
+  // The relative error float accumulation over a whole image can introduce,
+  // which the bounds are widened by to keep early exits exact
+  double bound_tolerance_;
+};
+} // namespace naivebayes
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+
+namespace naivebayes {
+
+/**
+ * The parts of the core that heap allocations are attributed to
+ */
+enum class Subsystem {
+  kOther,
+  kDataset,
+  kTrainer,
+  kModel,
+  kEvaluator,
+  kNumSubsystems
+};
+
+/**
+ * The heap usage of one subsystem
+ */
+struct SubsystemAllocations {
+  uint64_t allocations;
+  uint64_t deallocations;
+  uint64_t bytes_allocated;
+  int64_t live_bytes;
+  int64_t peak_live_bytes;
+};
+
+/**
+ * Attributes heap allocations to the subsystem running on the allocating
+ * thread. Allocations are only seen when the process is built with the
+ * allocation hooks, which replace the global operator new and delete; see
+ * the NAIVEBAYES_TRACK_ALLOCATIONS CMake option. Otherwise every count stays
+ * at zero and tracking costs nothing
+ */
+class AllocationTracker {
+
+public:
+  typedef std::array<SubsystemAllocations, size_t(Subsystem::kNumSubsystems)>
+      Snapshot;
+
+  /**
+   * Counts an allocation against a subsystem
+   *
+   * @param subsystem the subsystem that allocated
+   * @param bytes the number of bytes allocated
+   */
+  static void RecordAllocation(Subsystem subsystem, size_t bytes);
+
+  /**
+   * Counts a deallocation against the subsystem that made the allocation
+   *
+   * @param subsystem the subsystem that allocated the memory
+   * @param bytes the number of bytes freed
+   */
+  static void RecordDeallocation(Subsystem subsystem, size_t bytes);
+
+  /**
+   * Gets the subsystem running on the calling thread
+   *
+   * @return the innermost subsystem scope of the thread
+   */
+  static Subsystem GetCurrentSubsystem();
+
+  /**
+   * Gets the heap usage of every subsystem so far
+   *
+   * @return the usage, indexed by subsystem
+   */
+  static Snapshot GetSnapshot();
+
+  /**
+   * Records that the allocation hooks were linked into the process
+   */
+  static void MarkHooksInstalled();
+
+  static bool AreHooksInstalled();
+
+  /**
+   * Gets the most memory the process has had resident at once
+   *
+   * @return the peak resident set size in bytes, or 0 if the platform does
+   * not report it
+   */
+  static uint64_t GetPeakRss();
+
+  /**
+   * Prints the heap usage of every subsystem and the peak resident set size
+   *
+   * @param output the stream to write to
+   */
+  static void PrintReport(std::ostream &output);
+
+  /**
+   * Gets the name of a subsystem for reports
+   *
+   * @param subsystem the subsystem
+   * @return the name of the subsystem
+   */
+  static const char *GetSubsystemName(Subsystem subsystem);
+
+private:
+  friend class SubsystemScope;
+
+  static thread_local Subsystem current_subsystem_;
+};
+
+/**
+ * Attributes the allocations of the calling thread to a subsystem until it
+ * is destroyed, then restores the previous subsystem
+ */
+class SubsystemScope {
+
+public:
+  explicit SubsystemScope(Subsystem subsystem);
+
+  ~SubsystemScope();
+
+private:
+  Subsystem previous_subsystem_;
+};
+} // namespace naivebayes
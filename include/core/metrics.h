@@ -0,0 +1,200 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace naivebayes {
+
+/**
+ * A monotonically increasing count, such as the number of predictions served
+ */
+class Counter {
+
+public:
+  Counter();
+
+  /**
+   * Adds to the count
+   *
+   * @param amount the amount to add
+   */
+  void Increment(uint64_t amount = 1);
+
+  uint64_t Get() const;
+
+private:
+  std::atomic<uint64_t> value_;
+};
+
+/**
+ * A value that can go up and down, such as the number of labels in a model
+ */
+class Gauge {
+
+public:
+  Gauge();
+
+  void Set(int64_t value);
+
+  /**
+   * Adds to the value, which may be negative
+   *
+   * @param amount the amount to add
+   */
+  void Add(int64_t amount);
+
+  int64_t Get() const;
+
+private:
+  std::atomic<int64_t> value_;
+};
+
+/**
+ * A distribution of non negative values, such as latencies in nanoseconds.
+ * Values are counted in log-linear buckets: every power of two is split into
+ * kSubBuckets equal buckets, so quantiles are accurate to within 1 /
+ * kSubBuckets of their value while recording stays a single atomic increment
+ */
+class Histogram {
+
+public:
+  static const size_t kSubBuckets = 16;
+  static const size_t kNumBuckets = kSubBuckets + 60 * kSubBuckets;
+
+  Histogram();
+
+  /**
+   * Records a single value
+   *
+   * @param value the value to record
+   */
+  void Record(uint64_t value);
+
+  /**
+   * Estimates a quantile of the recorded values
+   *
+   * @param quantile the quantile, from 0 to 1
+   * @return the upper bound of the bucket the quantile falls in, or 0 if
+   * nothing has been recorded
+   */
+  uint64_t Quantile(double quantile) const;
+
+  uint64_t GetCount() const;
+
+  uint64_t GetSum() const;
+
+  /**
+   * Finds the bucket a value is counted in
+   *
+   * @param value the value to find the bucket of
+   * @return the index of the bucket
+   */
+  static size_t BucketIndex(uint64_t value);
+
+  /**
+   * Finds the largest value counted in a bucket
+   *
+   * @param index the index of the bucket
+   * @return the upper bound of the bucket
+   */
+  static uint64_t BucketUpperBound(size_t index);
+
+private:
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_;
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+};
+
+/**
+ * The text formats the metrics can be exported in
+ */
+enum class MetricsFormat { kJson, kPrometheus };
+
+/**
+ * Holds every metric of the process by name. Looking a metric up takes a
+ * lock, so call sites look their metrics up once and keep the reference;
+ * updating a metric never takes a lock
+ */
+class MetricsRegistry {
+
+public:
+  /**
+   * Gets the registry shared by the whole process
+   *
+   * @return the global registry
+   */
+  static MetricsRegistry &Global();
+
+  /**
+   * Gets a counter by name, creating it if it does not exist yet
+   *
+   * @param name the name of the counter
+   * @param help a description of the counter for the exported metrics
+   * @return the counter, which lives as long as the registry
+   */
+  Counter &GetCounter(const std::string &name, const std::string &help = "");
+
+  /**
+   * Gets a gauge by name, creating it if it does not exist yet
+   *
+   * @param name the name of the gauge
+   * @param help a description of the gauge for the exported metrics
+   * @return the gauge, which lives as long as the registry
+   */
+  Gauge &GetGauge(const std::string &name, const std::string &help = "");
+
+  /**
+   * Gets a histogram by name, creating it if it does not exist yet
+   *
+   * @param name the name of the histogram
+   * @param help a description of the histogram for the exported metrics
+   * @return the histogram, which lives as long as the registry
+   */
+  Histogram &GetHistogram(const std::string &name,
+                          const std::string &help = "");
+
+  /**
+   * Writes the current value of every metric. Histograms are exported as
+   * their count, sum and p50, p99 and p999
+   *
+   * @param output the stream to write to
+   * @param format the text format to write
+   */
+  void Export(std::ostream &output, MetricsFormat format) const;
+
+private:
+  mutable std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Counter>> counters_;
+  std::map<std::string, std::unique_ptr<Gauge>> gauges_;
+  std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+  std::map<std::string, std::string> help_;
+};
+
+/**
+ * Records the nanoseconds between its construction and destruction into a
+ * histogram
+ */
+class ScopedTimer {
+
+public:
+  /**
+   * Starts timing
+   *
+   * @param histogram the histogram to record the duration in
+   */
+  explicit ScopedTimer(Histogram &histogram);
+
+  ~ScopedTimer();
+
+private:
+  Histogram &histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+} // namespace naivebayes
@@ -1,13 +1,40 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "embedded_model.h"
+#include "feature_counts.h"
 #include "image.h"
+#include "log_prob_table.h"
+#include "prediction_cache.h"
 #include "trainer.h"
 
 namespace naivebayes {
 
+/**
+ * The result of scoring one held out fold of a cross validation
+ */
+struct FoldResult {
+  size_t num_images;
+  size_t num_correct;
+  float accuracy;
+};
+
+/**
+ * The per fold and aggregate results of a k-fold cross validation
+ */
+struct CrossValidationReport {
+  std::vector<FoldResult> folds;
+  float mean_accuracy;
+  float accuracy_std_dev;
+  float pooled_accuracy;
+  // The number of correct and wrong held out predictions of each label
+  std::map<char, std::map<bool, size_t>> confusion_matrix;
+};
+
 /**
  * Represents the Naive Bayes Model to predict numbers for
  */
@@ -57,10 +84,31 @@ public:
    * Trains the current Model with the passed in data through the >> operator
    * override
    *
+   * @param backend the way to count the training images
    * @throws std::exception if the model's training data has not been
    * instantiated
    */
-  void Train();
+  void Train(CountingBackend backend = CountingBackend::kBitSliced);
+
+  /**
+   * Trains the current Model from precomputed counts, such as the merged
+   * counts of several separately trained shards
+   *
+   * @param counts the raw counts to compile into probabilities
+   * @param laplace the Laplace smoothing added to every count
+   * @throws std::invalid_argument if the counts contain no images
+   */
+  void Train(const FeatureCounts &counts, float laplace = 1.0f);
+
+  /**
+   * Counts the shades of every pixel of the training images passed in through
+   * the >> operator
+   *
+   * @param backend the way to count the training images
+   * @return the raw counts of the training images
+   */
+  FeatureCounts
+  CountFeatures(CountingBackend backend = CountingBackend::kBitSliced) const;
 
   /**
    * Predicts the classification for an ascii image
@@ -71,13 +119,27 @@ public:
   char Predict(const std::vector<std::string> &ascii_image);
 
   /**
-   * Predicts the classification for an ascii image
+   * Predicts the classification for an ascii image. Scores are written into
+   * scratch kept per thread, so once a thread has made a prediction, later
+   * predictions make no heap allocations unless they are added to the
+   * prediction cache
    *
    * @param pixel_grid the pixel based representation of an image
    * @return the classification of the image
+   * @throws std::invalid_argument if the grid is not square or does not match
+   * the size of the model
    */
   char Predict(const std::vector<std::vector<Pixel>> &pixel_grid);
 
+  /**
+   * Caches the predictions of the model so that repeated images are not
+   * scored again. Cached predictions are invalidated whenever the model is
+   * retrained or reloaded
+   *
+   * @param capacity the maximum number of predictions to keep
+   */
+  void EnablePredictionCache(size_t capacity);
+
   /**
    * Deserializes a file back into a Model object
    *
@@ -85,6 +147,16 @@ public:
    */
   void Load(const std::string &model_file_path);
 
+  /**
+   * Loads log probabilities compiled into the program, with no file I/O or
+   * parsing. The model can then predict and measure accuracy, but has no
+   * Trainer, so it cannot be saved or report raw likelihoods
+   *
+   * @param embedded_model the embedded log probabilities
+   * @throws std::invalid_argument if the embedded model is incomplete
+   */
+  void Load(const EmbeddedModel &embedded_model);
+
   /**
    * Overrides istream for Model to allow model to be instantiated through the
    * >> operator
@@ -132,32 +204,105 @@ public:
    */
   float CalculateLikelihood(char label, const Image &image) const;
 
+  /**
+   * Runs a k-fold cross validation over the training images passed in through
+   * the >> operator. Every fold is counted once, and each fold's model is
+   * compiled from the total counts minus that fold's counts rather than being
+   * retrained. Images are dealt out to the folds round robin in label order
+   *
+   * @param num_folds the number of folds to split the images into
+   * @param num_threads the number of threads to score each held out fold
+   * with, or 0 to use every available core
+   * @return the accuracy of every fold and across all of the folds
+   * @throws std::invalid_argument if there are fewer images than folds or
+   * fewer than 2 folds
+   */
+  CrossValidationReport CrossValidate(size_t num_folds,
+                                      size_t num_threads = 0) const;
+
   Trainer *GetTrainer() const;
 
+  /**
+   * Gets the prediction cache of the model
+   *
+   * @return the cache, or nullptr if caching has not been enabled
+   */
+  PredictionCache *GetPredictionCache() const;
+
+  /**
+   * Gets the version of the model, which changes every time it is trained or
+   * loaded and is unique across every Model in the process
+   *
+   * @return the version of the model, or 0 if it has not been trained
+   */
+  uint64_t GetVersion() const;
+
+  /**
+   * Builds a map from each label to its training images. The images are
+   * shared rather than copied, but the map itself is built on every call, so
+   * prefer GetTrainingImages for reads
+   *
+   * @return the training images of every label
+   */
   std::map<char, std::vector<Image *>> GetTrainingImageMap() const;
+
+  /**
+   * Gets a read only view of the training images of a label, which stays
+   * valid until images are added to the model or it is cleared
+   *
+   * @param label the label of the images
+   * @return the training images with the label
+   * @throws std::out_of_range if the model has no images of the label
+   */
+  const std::vector<Image *> &GetTrainingImages(char label) const;
+
+  const LabelSet &GetLabelSet() const;
   
   void PrintConfusionMatrix() const;
 
 private:
   /**
-   * Updates the labels of the training map by instantiating the map with the
-   * passed key and an empty vector if the passed label is not part of the map
+   * Starts tracking a label with no training images if the passed label is
+   * not already part of the model
    *
-   * @param label the label to update the map with
+   * @param label the label to add
+   * @return the dense index of the label in labels_
    */
-  void UpdateTrainingImageMap(char label);
+  size_t AddLabel(char label);
+
+  /**
+   * Calculates the Likelihood value for a singular image corresponding to the
+   * dense index of a label in the Trainer
+   *
+   * @param label_index the index of the label in the Trainer's LabelSet
+   * @param image the image to calculate the likelihood for
+   * @return the value of the calculated likelihood
+   */
+  float CalculateLabelLikelihood(size_t label_index, const Image &image) const;
 
   /**
    * Deletes and clears the data from the current Model object
    */
   void ClearModel();
 
-  std::vector<char> GetLabels() const;
+  /**
+   * Gives the model a new version after it is trained or loaded, compiling
+   * the new probabilities of the Trainer, if there is one, for Predict and
+   * dropping any cached predictions of the previous version
+   */
+  void UpdateVersion();
 
-  std::map<char, std::vector<Image *>> label_image_map_;
+  LabelSet labels_;
+  // The training images of each label, indexed by the label's index in labels_
+  std::vector<std::vector<Image *>> label_images_;
   Trainer *model_trainer_;
+  // The trainer's probabilities compiled for Predict, rebuilt with the trainer
+  LogProbTable prediction_table_;
   size_t total_num_images_;
-  std::map<char, std::map<bool, float>> confusion_matrix_;
+  PredictionCache *prediction_cache_;
+  uint64_t version_;
+  // Incorrect and correct predictions, indexed by the Trainer's label index
+  std::vector<std::array<size_t, 2>> confusion_matrix_;
 };
 
 } // namespace naivebayes
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace naivebayes {
+
+/**
+ * Resolves a requested number of threads, where 0 means every available core
+ *
+ * @param num_threads the requested number of threads
+ * @return the number of threads to use, at least 1
+ */
+inline size_t ResolveNumThreads(size_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+
+  return std::max<size_t>(1, num_threads);
+}
+
+/**
+ * Splits the items [0, num_items) into contiguous chunks and runs a function
+ * over each chunk on its own thread. Exceptions thrown by a chunk are rethrown
+ * on the calling thread after every chunk has finished
+ *
+ * @param num_items the number of items to process
+ * @param num_threads the number of chunks to split the items into, or 0 to
+ * use every available core
+ * @param body called as body(chunk, begin, end) for each chunk
+ * @return the number of chunks the items were split into
+ */
+template <typename Function>
+size_t ParallelFor(size_t num_items, size_t num_threads, Function body) {
+  size_t num_chunks =
+      std::max<size_t>(1, std::min(ResolveNumThreads(num_threads), num_items));
+
+  if (num_chunks == 1) {
+    body(size_t(0), size_t(0), num_items);
+    return num_chunks;
+  }
+
+  std::vector<std::future<void>> chunks;
+
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    chunks.push_back(std::async(std::launch::async, body, chunk,
+                                num_items * chunk / num_chunks,
+                                num_items * (chunk + 1) / num_chunks));
+  }
+
+  for (auto &chunk : chunks) {
+    chunk.get();
+  }
+
+  return num_chunks;
+}
+} // namespace naivebayes
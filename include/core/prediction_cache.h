@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "image.h"
+
+namespace naivebayes {
+
+/**
+ * A bounded, least recently used cache of predictions, keyed by the packed
+ * pixels of an image together with the version of the model that predicted
+ * it. Retraining or reloading a model gives it a new version, so predictions
+ * of an older model can never be returned. Every method may be called from
+ * several threads at once
+ */
+class PredictionCache {
+
+public:
+  /**
+   * Instantiates an empty cache
+   *
+   * @param capacity the maximum number of predictions to keep
+   */
+  explicit PredictionCache(size_t capacity);
+
+  /**
+   * Looks up the cached prediction of an image, marking it as the most
+   * recently used prediction
+   *
+   * @param model_version the version of the model predicting the image
+   * @param pixel_grid the pixels of the image
+   * @param prediction populated with the cached prediction, if there is one
+   * @return whether the prediction was cached
+   */
+  bool Lookup(uint64_t model_version,
+              const std::vector<std::vector<Pixel>> &pixel_grid,
+              char &prediction);
+
+  /**
+   * Caches the prediction of an image, evicting the least recently used
+   * prediction if the cache is full
+   *
+   * @param model_version the version of the model that predicted the image
+   * @param pixel_grid the pixels of the image
+   * @param prediction the prediction to cache
+   */
+  void Insert(uint64_t model_version,
+              const std::vector<std::vector<Pixel>> &pixel_grid,
+              char prediction);
+
+  /**
+   * Removes every cached prediction, keeping the counters
+   */
+  void Clear();
+
+  size_t GetHits() const;
+
+  size_t GetMisses() const;
+
+  size_t GetEvictions() const;
+
+  size_t GetSize() const;
+
+  size_t GetCapacity() const;
+
+  /**
+   * Packs the shades of an image into 2 bits per pixel, prefixed with the
+   * version of the model and the size of the image
+   *
+   * @param model_version the version of the model predicting the image
+   * @param pixel_grid the pixels of the image
+   * @return the packed key
+   */
+  static std::string PackKey(uint64_t model_version,
+                             const std::vector<std::vector<Pixel>> &pixel_grid);
+
+  /**
+   * Packs a key into an existing string, reusing its capacity
+   *
+   * @param model_version the version of the model predicting the image
+   * @param pixel_grid the pixels of the image
+   * @param key replaced with the packed key
+   */
+  static void PackKey(uint64_t model_version,
+                      const std::vector<std::vector<Pixel>> &pixel_grid,
+                      std::string &key);
+
+private:
+  /**
+   * Hashes packed keys with 64 bit FNV-1a
+   */
+  struct KeyHash {
+    size_t operator()(const std::string &key) const;
+  };
+
+  typedef std::list<std::pair<std::string, char>> EntryList;
+
+  size_t capacity_;
+  // Ordered from the most to the least recently used prediction
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator, KeyHash> entry_map_;
+  size_t hits_;
+  size_t misses_;
+  size_t evictions_;
+  mutable std::mutex mutex_;
+};
+} // namespace naivebayes
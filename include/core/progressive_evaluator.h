@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "image.h"
+#include "log_prob_table.h"
+
+namespace naivebayes {
+
+/**
+ * Why a progressive evaluation stopped scoring images
+ */
+enum class ProgressiveStop {
+  // The confidence interval of the accuracy became narrower than requested
+  kConverged,
+  // The candidate was statistically worse than the baseline
+  kWorseThanBaseline,
+  // Every image was scored before either of the other conditions held
+  kExhausted
+};
+
+/**
+ * The settings of a progressive evaluation
+ */
+struct ProgressiveOptions {
+  // The confidence level of the whole evaluation, between 0 and 1. It is
+  // split evenly over the checkpoints, so that the chance of stopping on a
+  // wrong verdict at any of them stays within 1 - confidence
+  double confidence;
+  // The width of the accuracy interval below which the evaluation stops
+  double target_width;
+  // The first checkpoint, so that the intervals are not trusted on a handful
+  // of images. Each later checkpoint is twice the one before it, and the last
+  // is the whole dataset
+  size_t min_images;
+  // Keeps the proportion of each label in every prefix of the order
+  bool is_stratified;
+  uint64_t seed;
+};
+
+/**
+ * The running accuracy of a candidate model when a progressive evaluation
+ * stopped, along with its paired difference from a baseline model if one was
+ * given
+ */
+struct ProgressiveEvaluation {
+  size_t num_images;
+  size_t num_available;
+  size_t num_correct;
+  double accuracy;
+  // The Wilson score interval of the accuracy at the confidence level of one
+  // checkpoint
+  double accuracy_lower;
+  double accuracy_upper;
+  bool has_baseline;
+  size_t num_baseline_correct;
+  // The candidate accuracy minus the baseline accuracy on the same images
+  double difference;
+  // The images only the candidate and only the baseline got right
+  size_t num_candidate_only;
+  size_t num_baseline_only;
+  // The two sided exact sign test of the images the models disagree on
+  double p_value;
+  ProgressiveStop stop;
+};
+
+/**
+ * Scores a testing dataset in a random order and, at checkpoints that double
+ * in size, stops as soon as the confidence interval of the accuracy is narrow
+ * enough or the candidate is shown to be worse than a baseline. Gating
+ * decisions are then made from a fraction of the holdout set
+ */
+class ProgressiveEvaluator {
+
+public:
+  /**
+   * Instantiates an evaluator with the default settings: 95% confidence, a
+   * target width of 0.01, at least 100 images and a stratified order
+   */
+  ProgressiveEvaluator();
+
+  /**
+   * Instantiates an evaluator
+   *
+   * @param options the settings of the evaluation
+   * @throws std::invalid_argument if the confidence is not between 0 and 1 or
+   * the target width is not positive
+   */
+  explicit ProgressiveEvaluator(const ProgressiveOptions &options);
+
+  /**
+   * Scores images in a random order until a stopping condition holds at a
+   * checkpoint
+   *
+   * @param images the testing images, in any order
+   * @param candidate the model being evaluated
+   * @param baseline the model the candidate is compared against, or nullptr
+   * to only track the accuracy of the candidate
+   * @return the running accuracy when the evaluation stopped
+   * @throws std::invalid_argument if an image does not match the size of a
+   * model
+   */
+  ProgressiveEvaluation Evaluate(const std::vector<Image> &images,
+                                 const LogProbTable &candidate,
+                                 const LogProbTable *baseline = nullptr) const;
+
+  /**
+   * Computes the order images are scored in. Without stratification this is
+   * a shuffle; with it, each label is shuffled and then spread evenly through
+   * the order
+   *
+   * @param images the testing images
+   * @param is_stratified whether to keep label proportions in every prefix
+   * @param seed the seed of the shuffle, which gives the same order on every
+   * platform
+   * @return a permutation of the indices of the images
+   */
+  static std::vector<size_t> ScoringOrder(const std::vector<Image> &images,
+                                          bool is_stratified, uint64_t seed);
+
+  /**
+   * Computes the numbers of scored images at which the stopping conditions
+   * are checked
+   *
+   * @param min_images the first checkpoint
+   * @param num_available the number of images in the dataset, always the last
+   * checkpoint
+   * @return the checkpoints in increasing order, empty without images
+   */
+  static std::vector<size_t> Checkpoints(size_t min_images,
+                                         size_t num_available);
+
+  /**
+   * Computes the two sided exact sign test of paired outcomes, the exact form
+   * of McNemar's test. Only the pairs that differ count
+   *
+   * @param num_first the pairs only the first model got right
+   * @param num_second the pairs only the second model got right
+   * @return the chance of a split at least this uneven if either model is as
+   * likely as the other to be the one that is right
+   */
+  static double SignTestPValue(size_t num_first, size_t num_second);
+
+  /**
+   * Computes the Wilson score interval of a proportion
+   *
+   * @param num_successes the number of successful trials
+   * @param num_trials the number of trials
+   * @param z the standard normal quantile of the confidence level
+   * @param lower populated with the lower bound of the interval
+   * @param upper populated with the upper bound of the interval
+   */
+  static void WilsonInterval(size_t num_successes, size_t num_trials, double z,
+                             double &lower, double &upper);
+
+  /**
+   * Writes a summary of a progressive evaluation
+   *
+   * @param output the output stream to write to
+   * @param evaluation the evaluation to summarize
+   */
+  static void PrintEvaluation(std::ostream &output,
+                              const ProgressiveEvaluation &evaluation);
+
+  const ProgressiveOptions &GetOptions() const;
+
+private:
+  ProgressiveOptions options_;
+};
+} // namespace naivebayes
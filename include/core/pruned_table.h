@@ -0,0 +1,186 @@
+#pragma once
+
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "image.h"
+#include "label_set.h"
+#include "log_prob_table.h"
+
+namespace naivebayes {
+
+/**
+ * The ways pixels can be ranked by how much they tell the labels apart
+ */
+enum class PixelRanking {
+  // The mutual information between the shade of the pixel and the label
+  kMutualInformation,
+  // The largest KL divergence of the shade distribution of any one label from
+  // the shade distribution of every label together
+  kMaxDivergence
+};
+
+/**
+ * The accuracy of a model pruned to a number of pixels over a testing dataset
+ */
+struct PruningPoint {
+  size_t num_pixels;
+  size_t num_images;
+  size_t num_correct;
+  float accuracy;
+  // The number of images predicted differently from the unpruned model
+  size_t num_disagreements;
+};
+
+/**
+ * Represents a LogProbTable that only keeps its most discriminative pixels.
+ * Pixels that are dropped are left out of every label's likelihood, so
+ * scoring an image only touches the kept pixels and costs a fraction of the
+ * full table
+ */
+class PrunedTable {
+
+public:
+  /**
+   * Default Constructor
+   */
+  PrunedTable();
+
+  /**
+   * Prunes a compiled model to its highest ranked pixels
+   *
+   * @param table the compiled model to prune
+   * @param num_pixels the number of pixels to keep
+   * @param ranking the way to rank the pixels
+   * @throws std::invalid_argument if the model has fewer pixels than are kept
+   */
+  PrunedTable(const LogProbTable &table, size_t num_pixels,
+              PixelRanking ranking = PixelRanking::kMutualInformation);
+
+  /**
+   * Measures how much each pixel of a compiled model tells the labels apart,
+   * using the priors of the model as the distribution of the labels
+   *
+   * @param table the compiled model
+   * @param ranking the measure to compute
+   * @return the measure of each pixel, in row major order
+   */
+  static std::vector<double> ScorePixels(const LogProbTable &table,
+                                         PixelRanking ranking);
+
+  /**
+   * Orders the pixels of a compiled model from most to least discriminative,
+   * with ties going to the earlier pixel
+   *
+   * @param table the compiled model
+   * @param ranking the way to rank the pixels
+   * @return the row major positions of every pixel, best first
+   */
+  static std::vector<size_t> RankPixels(const LogProbTable &table,
+                                        PixelRanking ranking);
+
+  /**
+   * Scores a testing dataset against the model pruned to each number of
+   * pixels, decoding every image once
+   *
+   * @param table the compiled model to prune
+   * @param testing_stream the ascii dataset of testing images
+   * @param pixel_counts the numbers of pixels to keep
+   * @param ranking the way to rank the pixels
+   * @return the accuracy of each number of pixels, in the order given
+   * @throws std::invalid_argument if the dataset is malformed or does not
+   * match the size of the model
+   */
+  static std::vector<PruningPoint>
+  EvaluatePruning(const LogProbTable &table, std::istream &testing_stream,
+                  const std::vector<size_t> &pixel_counts,
+                  PixelRanking ranking = PixelRanking::kMutualInformation);
+
+  /**
+   * Calculates the log likelihood of an image for every label from the kept
+   * pixels. With every pixel kept, the scores equal those of the full table
+   *
+   * @param image the image to score
+   * @param scores populated with the likelihood of each label, in the order of
+   * GetLabels()
+   * @throws std::invalid_argument if the image size does not match the table
+   */
+  void Score(const Image &image, std::vector<float> &scores) const;
+
+  /**
+   * Predicts the label of an image, with ties going to the first label
+   *
+   * @param image the image to classify
+   * @return the predicted label
+   * @throws std::invalid_argument if the image size does not match the table
+   */
+  char Classify(const Image &image) const;
+
+  /**
+   * Classifies every image of an ascii dataset, writing the predictions in
+   * the format of StreamClassifier: one predicted label per line, followed
+   * by the tab separated score of every label if requested
+   *
+   * @param input the ascii dataset to classify, whose labels are ignored
+   * @param output the output stream to write the predictions to
+   * @param write_scores whether to write the score of every label
+   * @return the number of images classified
+   * @throws std::invalid_argument if the dataset is malformed or an image does
+   * not match the size of the table
+   */
+  size_t Classify(std::istream &input, std::ostream &output,
+                  bool write_scores = false) const;
+
+  /**
+   * Overrides ostream for PrunedTable to save the kept pixels and their log
+   * probabilities
+   *
+   * @param output the output stream to write to
+   * @param table the pruned table to save
+   * @return the output stream
+   */
+  friend std::ostream &operator<<(std::ostream &output,
+                                  const PrunedTable &table);
+
+  /**
+   * Overrides istream for PrunedTable to load a saved pruned table
+   *
+   * @param input the input stream to read in
+   * @param table the pruned table to populate
+   * @return the input stream
+   * @throws std::invalid_argument if the stream is not a valid pruned table
+   */
+  friend std::istream &operator>>(std::istream &input, PrunedTable &table);
+
+  const std::vector<char> &GetLabels() const;
+
+  size_t GetImageSize() const;
+
+  /**
+   * Gets the pixels the table scores
+   *
+   * @return the row major positions of the kept pixels, in increasing order
+   */
+  const std::vector<size_t> &GetPixels() const;
+
+private:
+  /**
+   * Splits the kept pixels into rows and columns once, so that scoring does
+   * not divide for every pixel
+   */
+  void LocatePixels();
+
+  size_t image_size_;
+  size_t num_shades_;
+  LabelSet labels_;
+  // Kept in row major order, so keeping every pixel adds the features in the
+  // same order as the full table
+  std::vector<size_t> pixels_;
+  // The row and column of each kept pixel
+  std::vector<std::pair<size_t, size_t>> locations_;
+  std::vector<float> log_priors_;
+  // Stored in kept pixel, shade, label order
+  std::vector<float> log_features_;
+};
+} // namespace naivebayes
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace naivebayes {
+
+/**
+ * Decodes a row of an ascii image into one shade per byte, where '#' is
+ * Pixel::kShaded, '+' is Pixel::kPartiallyShaded and every other character is
+ * Pixel::kUnshaded. Compares 16 characters at a time with SSE2 or NEON where
+ * the target has them, and falls back to DecodeRowScalar elsewhere
+ *
+ * @param text the characters of the row
+ * @param length the number of characters in the row
+ * @param shades populated with the shade of each character, which must have
+ * room for length bytes
+ */
+void DecodeRow(const char *text, size_t length, uint8_t *shades);
+
+/**
+ * Decodes a row of an ascii image into packed 2-bit shades, four to a byte
+ * with the first pixel in the lowest bits, the same layout as
+ * StreamFormat::kPacked
+ *
+ * @param text the characters of the row
+ * @param length the number of characters in the row
+ * @param packed populated with the packed shades, which must have room for
+ * (length + 3) / 4 bytes
+ */
+void DecodeRowPacked(const char *text, size_t length, uint8_t *packed);
+
+/**
+ * Decodes a row of an ascii image one character at a time. Kept as the
+ * reference the vectorized decoders are tested against
+ *
+ * @param text the characters of the row
+ * @param length the number of characters in the row
+ * @param shades populated with the shade of each character
+ */
+void DecodeRowScalar(const char *text, size_t length, uint8_t *shades);
+
+/**
+ * Decodes a row of an ascii image into packed 2-bit shades one character at
+ * a time
+ *
+ * @param text the characters of the row
+ * @param length the number of characters in the row
+ * @param packed populated with the packed shades
+ */
+void DecodeRowPackedScalar(const char *text, size_t length, uint8_t *packed);
+
+/**
+ * Checks whether DecodeRow and DecodeRowPacked use vector instructions
+ *
+ * @return true if the SSE2 or NEON decoder was compiled in
+ */
+bool IsRowDecoderVectorized();
+
+} // namespace naivebayes
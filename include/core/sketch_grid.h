@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "enums/pixel.h"
+
+namespace naivebayes {
+
+/**
+ * Represents the pixels of a sketchpad and the brush that shades them, with
+ * no dependency on a window or renderer. Positions are measured in sketch
+ * pixels from the top left corner, so the center of the pixel at a row and
+ * column is (column + 0.5, row + 0.5)
+ */
+class SketchGrid {
+
+public:
+  /**
+   * Creates an unshaded grid
+   *
+   * @param num_pixels_per_side the number of pixels in one row or column
+   * @param brush_radius the maximum distance, in pixels, from the brush to
+   * the center of a pixel it shades
+   */
+  explicit SketchGrid(size_t num_pixels_per_side, double brush_radius = 1.15);
+
+  /**
+   * Shades the pixels whose centers are within the brush radius of a point.
+   * Only the pixels in the bounding box of the brush are checked
+   *
+   * @param x the horizontal position of the brush
+   * @param y the vertical position of the brush
+   */
+  void Brush(double x, double y);
+
+  /**
+   * Shades the pixels whose centers are within the brush radius of any point
+   * on a segment, so that fast drags leave a continuous line instead of a
+   * trail of dots. Only the pixels in the bounding box of the segment widened
+   * by the brush radius are checked
+   *
+   * @param start_x the horizontal position the brush moved from
+   * @param start_y the vertical position the brush moved from
+   * @param end_x the horizontal position the brush moved to
+   * @param end_y the vertical position the brush moved to
+   */
+  void BrushSegment(double start_x, double start_y, double end_x,
+                    double end_y);
+
+  /**
+   * Sets all of the pixels to an unshaded state
+   */
+  void Clear();
+
+  /**
+   * Gets a read only view of the pixels, which stays valid for the lifetime
+   * of the grid
+   *
+   * @return the status of each of the pixels, indexed by row then column
+   */
+  const std::vector<std::vector<Pixel>> &GetPixelGrid() const;
+
+  size_t GetNumPixelsPerSide() const;
+
+  double GetBrushRadius() const;
+
+private:
+  /**
+   * Clamps the range of pixel indices whose centers lie within an interval
+   * of positions along one side of the grid
+   *
+   * @param low the smallest position
+   * @param high the largest position
+   * @param first populated with the first pixel index in the range
+   * @param last populated with one past the last pixel index in the range
+   */
+  void PixelRange(double low, double high, size_t &first, size_t &last) const;
+
+  size_t num_pixels_per_side_;
+  double brush_radius_;
+  std::vector<std::vector<Pixel>> pixel_grid_;
+};
+} // namespace naivebayes
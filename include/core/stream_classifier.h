@@ -0,0 +1,96 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "batch_scorer.h"
+#include "log_prob_table.h"
+
+namespace naivebayes {
+
+/**
+ * The encodings of images a StreamClassifier can read
+ */
+enum class StreamFormat {
+  // The ascii dataset format: a label line, which is ignored, followed by one
+  // line of ' ', '+' and '#' characters per row
+  kAscii,
+  // 2 bits per pixel holding its Pixel value, 4 pixels per byte with the
+  // first pixel in the lowest bits, in row major order. Every image takes
+  // (image size * image size + 3) / 4 bytes with no separators
+  kPacked
+};
+
+/**
+ * Classifies an unbounded stream of images with one model, writing one
+ * prediction per line in the order the images were read. The stream is read
+ * in large blocks and split into batches of whole images, and each batch is
+ * decoded, scored with a BatchScorer and formatted in parallel before it is
+ * written out at once
+ */
+class StreamClassifier {
+
+public:
+  /**
+   * Instantiates a classifier
+   *
+   * @param table the compiled model to classify with, which must outlive the
+   * classifier
+   * @param num_threads the number of threads to score each batch with, or 0
+   * to use every available core
+   * @param batch_size the number of images scored together
+   */
+  explicit StreamClassifier(const LogProbTable &table, size_t num_threads = 0,
+                            size_t batch_size = 4096);
+
+  /**
+   * Classifies every image of a stream. Each output line is the predicted
+   * label, followed by the log likelihood of every label in the order of
+   * GetLabels() separated by tabs if scores are written
+   *
+   * @param input the stream of images
+   * @param output the output stream to write the predictions to
+   * @param format the encoding of the images
+   * @param write_scores whether to write the likelihoods of every label
+   * @return the number of images classified
+   * @throws std::invalid_argument if an image is malformed or truncated, in
+   * which case the predictions of every earlier batch have been written
+   */
+  size_t Classify(std::istream &input, std::ostream &output,
+                  StreamFormat format, bool write_scores) const;
+
+private:
+  /**
+   * Finds the images in the unread part of the buffer, up to a full batch
+   *
+   * @param buffer the bytes read so far
+   * @param begin the offset of the first unclassified byte
+   * @param format the encoding of the images
+   * @param is_end_of_stream whether the buffer holds the rest of the stream
+   * @param image_offsets populated with the offset of each complete image,
+   * followed by the offset just past the last one
+   */
+  void FindImages(const std::string &buffer, size_t begin,
+                  StreamFormat format, bool is_end_of_stream,
+                  std::vector<size_t> &image_offsets) const;
+
+  /**
+   * Decodes one image into a shade per byte
+   *
+   * @param record the first byte of the image in the buffer
+   * @param record_end the byte just past the image
+   * @param format the encoding of the image
+   * @param pixels populated with the shade of every pixel, row by row, which
+   * must have room for every pixel of the model
+   * @throws std::invalid_argument if a row is not the size of the model
+   */
+  void DecodeImage(const char *record, const char *record_end,
+                   StreamFormat format, uint8_t *pixels) const;
+
+  const LogProbTable &table_;
+  BatchScorer scorer_;
+  size_t num_threads_;
+  size_t batch_size_;
+};
+} // namespace naivebayes
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "metrics.h"
+#include "model.h"
+#include "sketch_grid.h"
+
+namespace naivebayes {
+
+/**
+ * The interactions a user can have with a sketchpad
+ */
+enum class StrokeEventType { kBrushDown, kBrushDrag, kPredict, kClear };
+
+/**
+ * A single interaction with a sketchpad. Positions are in sketch pixels, so a
+ * log can be replayed regardless of the window it was recorded in
+ */
+struct StrokeEvent {
+  StrokeEventType type;
+  // Microseconds since the recording started
+  uint64_t time_us;
+  // The position of the brush, only used by brush events
+  double x;
+  double y;
+};
+
+/**
+ * Records the interactions with a sketchpad as they happen, so that a session
+ * can be saved and replayed without a window
+ */
+class StrokeRecorder {
+
+public:
+  /**
+   * Starts a recording with no events, timed from now
+   */
+  StrokeRecorder();
+
+  /**
+   * Records an interaction at the current time
+   *
+   * @param type the kind of interaction
+   * @param x the horizontal position of the brush, for brush events
+   * @param y the vertical position of the brush, for brush events
+   */
+  void Record(StrokeEventType type, double x = 0.0, double y = 0.0);
+
+  const std::vector<StrokeEvent> &GetEvents() const;
+
+private:
+  std::chrono::steady_clock::time_point start_;
+  std::vector<StrokeEvent> events_;
+};
+
+/**
+ * Writes events as a stroke log, one event per line as the time in
+ * microseconds, the event name (down, drag, predict or clear) and, for brush
+ * events, the position of the brush
+ *
+ * @param events the events to write
+ * @param output the output stream to write to
+ */
+void WriteStrokeLog(const std::vector<StrokeEvent> &events,
+                    std::ostream &output);
+
+/**
+ * Reads the events of a stroke log, skipping blank lines
+ *
+ * @param input the input stream to read the log from
+ * @return the events in the order they were recorded
+ * @throws std::invalid_argument if a line is not a valid event
+ */
+std::vector<StrokeEvent> ReadStrokeLog(std::istream &input);
+
+/**
+ * Applies recorded events to a sketch grid and a model as fast as possible,
+ * timing how long each kind of event takes
+ */
+class StrokeReplayer {
+
+public:
+  /**
+   * Creates a replayer that draws on a grid and predicts with a model. Both
+   * must outlive the replayer
+   *
+   * @param grid the grid the brush events shade
+   * @param model the trained model predict events classify the grid with
+   */
+  StrokeReplayer(SketchGrid &grid, Model &model);
+
+  /**
+   * Applies a single event. Drags shade the segment from the previous brush
+   * position, and predictions are appended to GetPredictions()
+   *
+   * @param event the event to apply
+   */
+  void Apply(const StrokeEvent &event);
+
+  /**
+   * Applies every event of a log in order
+   *
+   * @param events the events to apply
+   */
+  void Replay(const std::vector<StrokeEvent> &events);
+
+  /**
+   * Gets the latencies of the events of a kind, in nanoseconds. Downs and
+   * drags are both brush events
+   *
+   * @param type the kind of event
+   * @return the distribution of the time taken to apply each event
+   */
+  const Histogram &GetLatency(StrokeEventType type) const;
+
+  /**
+   * Gets every prediction made so far, in order
+   *
+   * @return one label per predict event
+   */
+  const std::string &GetPredictions() const;
+
+private:
+  SketchGrid &grid_;
+  Model &model_;
+  double last_x_;
+  double last_y_;
+  std::string predictions_;
+  Histogram brush_latency_;
+  Histogram predict_latency_;
+  Histogram clear_latency_;
+};
+} // namespace naivebayes
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace naivebayes {
+
+/**
+ * A single begin or end event of a traced stage
+ */
+struct TraceEvent {
+  // Names and categories are string literals, so recording never allocates
+  const char *name;
+  const char *category;
+  // 'B' when the stage begins and 'E' when it ends, as in Chrome traces
+  char phase;
+  uint64_t timestamp_ns;
+};
+
+/**
+ * Records when the stages of the pipeline begin and end on every thread, and
+ * writes them as a Chrome trace_event JSON file that can be opened in
+ * Perfetto or chrome://tracing. Tracing is off until Enable is called, and
+ * costs a single atomic load per stage while it is off.
+ *
+ * Each thread appends to its own buffer of fixed size blocks, so recording
+ * never takes a lock or moves events that have already been written. When a
+ * thread exits, its buffer is handed to the next thread that records, so
+ * short lived worker threads share buffers and trace thread ids rather than
+ * each leaving a block behind. Writing the trace may run while other threads
+ * are recording, and includes every event recorded before it started.
+ */
+class Tracer {
+
+public:
+  /**
+   * Gets the tracer shared by the whole process
+   *
+   * @return the global tracer
+   */
+  static Tracer &Global();
+
+  /**
+   * Starts recording events
+   */
+  void Enable();
+
+  /**
+   * Stops recording events, keeping the events recorded so far
+   */
+  void Disable();
+
+  bool IsEnabled() const;
+
+  /**
+   * Records an event on the calling thread's buffer. Callers check IsEnabled
+   * first, so that the end of a stage is still recorded if tracing is
+   * disabled while the stage runs
+   *
+   * @param category the category of the stage, as a string literal
+   * @param name the name of the stage, as a string literal
+   * @param phase 'B' if the stage begins and 'E' if it ends
+   */
+  void Record(const char *category, const char *name, char phase);
+
+  /**
+   * Writes every recorded event as Chrome trace_event JSON
+   *
+   * @param output the stream to write to
+   */
+  void WriteChromeTrace(std::ostream &output) const;
+
+  /**
+   * Gets the number of events recorded across every thread
+   *
+   * @return the number of events
+   */
+  size_t GetNumEvents() const;
+
+  /**
+   * Gets the number of thread buffers, which is the most threads that have
+   * recorded at the same time
+   *
+   * @return the number of buffers
+   */
+  size_t GetNumBuffers() const;
+
+private:
+  static const size_t kBlockSize = 4096;
+
+  /**
+   * A fixed size run of events. Only the owning thread writes to a block, and
+   * it publishes each event by incrementing size after writing it
+   */
+  struct Block {
+    Block();
+
+    TraceEvent events[kBlockSize];
+    std::atomic<size_t> size;
+    std::atomic<Block *> next;
+  };
+
+  /**
+   * The events of the threads that held it, one thread at a time, in the
+   * order they were recorded
+   */
+  struct ThreadBuffer {
+    explicit ThreadBuffer(size_t thread_id);
+
+    size_t thread_id;
+    Block *head;
+    Block *tail;
+  };
+
+  /**
+   * Holds a buffer for the thread it belongs to, and releases the buffer to
+   * the tracer when the thread exits
+   */
+  struct BufferLease {
+    ~BufferLease();
+
+    Tracer *tracer;
+    ThreadBuffer *buffer;
+  };
+
+  Tracer();
+
+  ~Tracer();
+
+  /**
+   * Gets the buffer of the calling thread, taking a released buffer or
+   * registering a new one on first use
+   *
+   * @return the calling thread's buffer
+   */
+  ThreadBuffer &GetThreadBuffer();
+
+  std::atomic<bool> is_enabled_;
+  std::chrono::steady_clock::time_point start_;
+  mutable std::mutex buffers_mutex_;
+  std::vector<ThreadBuffer *> buffers_;
+  // The buffers of threads that have exited, waiting for a new thread
+  std::vector<ThreadBuffer *> released_buffers_;
+};
+
+/**
+ * Records the beginning of a stage when constructed and its end when
+ * destroyed
+ */
+class TraceScope {
+
+public:
+  /**
+   * Begins a stage on the global tracer
+   *
+   * @param category the category of the stage, as a string literal
+   * @param name the name of the stage, as a string literal
+   */
+  TraceScope(const char *category, const char *name);
+
+  ~TraceScope();
+
+private:
+  const char *category_;
+  const char *name_;
+  // Ends are only recorded for stages whose beginning was recorded
+  bool is_recording_;
+};
+} // namespace naivebayes
@@ -3,11 +3,15 @@
 #include <map>
 #include <vector>
 
+#include "feature_counts.h"
 #include "image.h"
+#include "label_set.h"
 
 namespace naivebayes {
 
-typedef std::vector<std::vector<std::vector<std::map<char, float>>>>
+// Feature probabilities indexed by row, column, shade and the dense index of
+// a label in the trainer's LabelSet
+typedef std::vector<std::vector<std::vector<std::vector<float>>>>
     FeatureVector;
 
 /**
@@ -27,9 +31,10 @@ public:
    * @param image_size the size of the images going into the trainer
    * @param num_shades the number of shades
    * @param labels all of the labels that the model was trained on
+   * @param laplace the Laplace smoothing added to every count
    */
   Trainer(size_t image_size, size_t num_shades,
-          const std::vector<char> &labels);
+          const std::vector<char> &labels, float laplace = kDefaultLaplace);
 
   /**
    * Overrides ostream for Trainer to write a custom serialization to
@@ -58,6 +63,13 @@ public:
    */
   void CalculateFeatures(const std::map<char, std::vector<Image *>> &image_map);
 
+  /**
+   * Sets all of the probabilities within the trainer from precomputed counts
+   *
+   * @param counts the raw per label, pixel and shade counts of the images
+   */
+  void CalculateFeatures(const FeatureCounts &counts);
+
   /**
    * Calculates and sets all of the prior probabilities for the trainer
    *
@@ -67,19 +79,43 @@ public:
   void CalculatePriors(const std::map<char, std::vector<Image *>> &image_map,
                        size_t total_num_images);
 
+  /**
+   * Calculates and sets all of the prior probabilities from precomputed counts
+   *
+   * @param counts the raw per label image totals
+   */
+  void CalculatePriors(const FeatureCounts &counts);
+
   /**
    * Clears all of the values in the trainer
    */
   void ClearValues();
 
-  FeatureVector GetFeatures() const;
+  /**
+   * Gets a read only view of the feature probabilities, which stays valid
+   * until the trainer is retrained, loaded, cleared or destroyed
+   *
+   * @return the probability of each shade of each pixel for each label
+   */
+  const FeatureVector &GetFeatures() const;
+
+  /**
+   * Gets a read only view of the prior probabilities of the labels
+   *
+   * @return the prior of each label, indexed by its index in GetLabelSet()
+   */
+  const std::vector<float> &GetPriors() const;
+
+  const std::vector<char> &GetLabels() const;
+
+  const LabelSet &GetLabelSet() const;
 
-  std::map<char, float> GetPriors() const;
+  size_t GetImageSize() const;
 
-  std::vector<char> GetLabels() const;
+  float GetLaplace() const;
 
 private:
-  const float kLaplace = 1.0f;
+  static constexpr float kDefaultLaplace = 1.0f;
   const std::map<size_t, Pixel> kPixelMap = {
       {0, Pixel::kUnshaded}, {1, Pixel::kPartiallyShaded}, {2, Pixel::kShaded}};
 
@@ -105,7 +141,7 @@ private:
    * @return a multidimensional vector representing the trainer
    */
   FeatureVector BuildStructure(size_t image_size, size_t num_shades,
-                               const std::vector<char> &all_labels);
+                               size_t num_labels);
 
   /**
    * Parses and reads a serialized model's file labels into
@@ -125,14 +161,14 @@ private:
   size_t GetNextSizeT(std::istream &input);
 
   /**
-   * Parses and reads the prior probabilities from an input file into a map
+   * Parses and reads the prior probabilities from an input file
    *
    * @param input the input stream with the probabilities
-   * @param labels the character labels of the model
-   * @return a mapping between a character label and the prior probability
+   * @param labels the character labels of the model, in file order
+   * @return the prior probability of each label by its dense index
    */
-  std::map<char, float> GetFilePriors(std::istream &input,
-                                      const std::vector<char>& labels);
+  std::vector<float> GetFilePriors(std::istream &input,
+                                   const std::vector<char> &labels);
 
   /**
    * Validates the input stream's model input
@@ -145,8 +181,9 @@ private:
   void ValidateInputSize(size_t size, size_t num_shades, size_t num_labels,
                          size_t num_features) const;
 
+  float laplace_;
+  LabelSet labels_;
   FeatureVector features_;
-  std::map<char, float> priors_;
-  std::vector<char> labels_;
+  std::vector<float> priors_;
 };
 } // namespace naivebayes
@@ -3,6 +3,7 @@
 #include "cinder/app/App.h"
 #include "cinder/app/RendererGl.h"
 #include "cinder/gl/gl.h"
+#include "core/stroke_log.h"
 #include "sketchpad.h"
 
 namespace naivebayes {
@@ -21,15 +22,24 @@ public:
   void mouseDown(ci::app::MouseEvent event) override;
   void mouseDrag(ci::app::MouseEvent event) override;
   void keyDown(ci::app::KeyEvent event) override;
+
+  /**
+   * Saves the recorded strokes to the path in the NAIVEBAYES_STROKE_LOG
+   * environment variable, if it is set, so the session can be replayed
+   * headless with train-model replay.
+   */
+  void cleanup() override;
   
   const double kWindowSize = 1075;
   const double kMargin = 100;
   const size_t kImageDimension = 28;
+  const size_t kPredictionCacheSize = 1024;
 
 private:
   Sketchpad sketchpad_;
   int current_prediction_ = -1;
   Model model_;
+  StrokeRecorder recorder_;
 };
 
 } // namespace visualizer
@@ -3,6 +3,7 @@
 #include "cinder/gl/gl.h"
 #include "enums/pixel.h"
 #include "core/model.h"
+#include "core/sketch_grid.h"
 
 namespace naivebayes {
 
@@ -38,20 +39,39 @@ class Sketchpad {
 
   /**
    * Shades in the sketchpad pixels whose centers are within brush_radius units
-   * of the brush's location. (One unit is equal to the length of one sketchpad
-   * pixel.)
+   * of the brush's location, and starts a new stroke there. (One unit is
+   * equal to the length of one sketchpad pixel.)
    *
    * @param brush_screen_coords the screen coordinates at which the brush is
    *           located
    */
   void HandleBrush(const glm::vec2& brush_screen_coords);
 
+  /**
+   * Shades in the sketchpad pixels within brush_radius units of the line from
+   * the previous brush location to the new one, so that fast drags do not
+   * leave gaps.
+   *
+   * @param brush_screen_coords the screen coordinates the brush was dragged
+   *           to
+   */
+  void HandleDrag(const glm::vec2& brush_screen_coords);
+
+  /**
+   * Converts screen coordinates into sketchpad pixel units, measured from
+   * the top left corner of the sketchpad.
+   *
+   * @param screen_coords the screen coordinates to convert
+   * @return the position in sketchpad pixels
+   */
+  glm::vec2 ToSketchCoords(const glm::vec2& screen_coords) const;
+
   /**
    * Set all of the sketchpad pixels to an unshaded state.
    */
   void Clear();
   
-  std::vector<std::vector<Pixel>> GetPixelGrid() const;
+  const std::vector<std::vector<Pixel>>& GetPixelGrid() const;
 
  private:
   glm::vec2 top_left_corner_;
@@ -61,9 +81,11 @@ class Sketchpad {
   /** Number of screen pixels in the width/height of one sketchpad pixel */
   double pixel_side_length_;
 
-  double brush_radius_;
-  
-  std::vector<std::vector<Pixel>> pixel_grid_;
+  /** The pixels and brush, which hold no drawing state */
+  SketchGrid grid_;
+
+  /** The brush location of the previous mouse event, in sketchpad pixels */
+  glm::vec2 last_brush_coords_;
 };
 
 }  // namespace visualizer
@@ -0,0 +1,109 @@
+#include <core/memory_accounting.h>
+
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions so that every heap allocation is
+// attributed to a subsystem. Only linked when NAIVEBAYES_TRACK_ALLOCATIONS is
+// on. Each allocation is prefixed with a header recording its size and
+// subsystem, so frees are attributed to the subsystem that allocated
+
+namespace {
+
+using naivebayes::AllocationTracker;
+using naivebayes::Subsystem;
+
+/**
+ * Precedes every tracked allocation. Padded to keep the memory after it as
+ * aligned as malloc's
+ */
+struct alignas(16) AllocationHeader {
+  size_t size;
+  Subsystem subsystem;
+};
+
+const bool kHooksInstalled = (AllocationTracker::MarkHooksInstalled(), true);
+
+/**
+ * Allocates memory and counts it against the current subsystem
+ *
+ * @param size the number of bytes requested
+ * @return the memory, or nullptr if none is available
+ */
+void *AllocateTracked(size_t size) {
+  void *memory = std::malloc(sizeof(AllocationHeader) + size);
+
+  if (memory == nullptr) {
+    return nullptr;
+  }
+
+  AllocationHeader *header = static_cast<AllocationHeader *>(memory);
+  header->size = size;
+  header->subsystem = AllocationTracker::GetCurrentSubsystem();
+  AllocationTracker::RecordAllocation(header->subsystem, size);
+
+  return header + 1;
+}
+
+/**
+ * Frees memory from AllocateTracked and counts it against the subsystem that
+ * allocated it
+ *
+ * @param memory the memory to free, may be nullptr
+ */
+void FreeTracked(void *memory) {
+  if (memory == nullptr) {
+    return;
+  }
+
+  AllocationHeader *header = static_cast<AllocationHeader *>(memory) - 1;
+  AllocationTracker::RecordDeallocation(header->subsystem, header->size);
+  std::free(header);
+}
+
+/**
+ * Allocates memory, throwing like operator new when none is available
+ *
+ * @param size the number of bytes requested
+ * @return the memory
+ * @throws std::bad_alloc if the memory could not be allocated
+ */
+void *AllocateOrThrow(size_t size) {
+  void *memory = AllocateTracked(size);
+
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return memory;
+}
+
+} // namespace
+
+void *operator new(size_t size) { return AllocateOrThrow(size); }
+
+void *operator new[](size_t size) { return AllocateOrThrow(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return AllocateTracked(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return AllocateTracked(size);
+}
+
+void operator delete(void *memory) noexcept { FreeTracked(memory); }
+
+void operator delete[](void *memory) noexcept { FreeTracked(memory); }
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept {
+  FreeTracked(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept {
+  FreeTracked(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept { FreeTracked(memory); }
+
+void operator delete[](void *memory, size_t) noexcept { FreeTracked(memory); }
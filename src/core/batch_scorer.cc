@@ -0,0 +1,188 @@
+#include "core/batch_scorer.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace naivebayes {
+
+namespace {
+
+// The number of labels scored together, padded with zeros past the last label
+const size_t kLabelBlock = 16;
+
+// Unrolling the additions of a block keeps its accumulators in registers,
+// which compilers only do by themselves at -O3
+#if defined(__clang__)
+#define NAIVEBAYES_UNROLL_LABEL_BLOCK _Pragma("clang loop unroll(full)")
+#elif defined(__GNUC__) && __GNUC__ >= 8
+#define NAIVEBAYES_UNROLL_LABEL_BLOCK _Pragma("GCC unroll 16")
+#else
+#define NAIVEBAYES_UNROLL_LABEL_BLOCK
+#endif
+
+} // namespace
+
+BatchScorer::BatchScorer(const LogProbTable &table, size_t image_tile,
+                         size_t row_tile)
+    : image_size_(table.GetImageSize()), num_shades_(table.GetNumShades()),
+      image_tile_(std::max<size_t>(1, image_tile)),
+      row_tile_(std::max<size_t>(1, row_tile)), labels_(table.GetLabelSet()),
+      log_priors_(table.GetLogPriors()) {
+
+  size_t num_labels = labels_.Size();
+  size_t num_blocks = (num_labels + kLabelBlock - 1) / kLabelBlock;
+  size_t num_entries = image_size_ * image_size_ * num_shades_;
+  const std::vector<float> &log_features = table.GetLogFeatures();
+
+  block_features_.assign(num_blocks * num_entries * kLabelBlock, 0.0f);
+
+  for (size_t entry = 0; entry < num_entries; ++entry) {
+    for (size_t label = 0; label < num_labels; ++label) {
+      size_t block = label / kLabelBlock;
+      block_features_[(block * num_entries + entry) * kLabelBlock +
+                      label % kLabelBlock] =
+          log_features[entry * num_labels + label];
+    }
+  }
+}
+
+void BatchScorer::Score(const uint8_t *pixels, size_t num_images,
+                        size_t row_stride, size_t image_stride,
+                        std::vector<float> &scores) const {
+  size_t invalid_image =
+      FindInvalidImage(pixels, num_images, row_stride, image_stride);
+
+  if (invalid_image != num_images) {
+    throw std::invalid_argument("Image " + std::to_string(invalid_image) +
+                                ": Image shade is not part of the model");
+  }
+
+  size_t num_labels = labels_.Size();
+  size_t num_entries = image_size_ * image_size_ * num_shades_;
+  std::vector<float> tile_scores(image_tile_ * kLabelBlock);
+  scores.resize(num_images * num_labels);
+
+  for (size_t label_begin = 0; label_begin < num_labels;
+       label_begin += kLabelBlock) {
+    const float *block_features =
+        block_features_.data() + label_begin * num_entries;
+    size_t block_labels = std::min(kLabelBlock, num_labels - label_begin);
+
+    for (size_t image_begin = 0; image_begin < num_images;
+         image_begin += image_tile_) {
+      size_t tile_images = std::min(image_tile_, num_images - image_begin);
+      const uint8_t *tile_pixels = pixels + image_begin * image_stride;
+
+      for (size_t image = 0; image < tile_images; ++image) {
+        for (size_t label = 0; label < kLabelBlock; ++label) {
+          tile_scores[image * kLabelBlock + label] =
+              label < block_labels ? log_priors_[label_begin + label] : 0.0f;
+        }
+      }
+
+      for (size_t row_begin = 0; row_begin < image_size_;
+           row_begin += row_tile_) {
+        AddRowTile(tile_pixels, tile_images, row_stride, image_stride,
+                   row_begin, std::min(image_size_, row_begin + row_tile_),
+                   block_features, tile_scores.data());
+      }
+
+      for (size_t image = 0; image < tile_images; ++image) {
+        std::copy(tile_scores.begin() + image * kLabelBlock,
+                  tile_scores.begin() + image * kLabelBlock + block_labels,
+                  scores.begin() + (image_begin + image) * num_labels +
+                      label_begin);
+      }
+    }
+  }
+}
+
+void BatchScorer::AddRowTile(const uint8_t *pixels, size_t num_images,
+                             size_t row_stride, size_t image_stride,
+                             size_t row_begin, size_t row_end,
+                             const float *block_features,
+                             float *tile_scores) const {
+  size_t row_entries = image_size_ * num_shades_ * kLabelBlock;
+
+  for (size_t image = 0; image < num_images; ++image) {
+    const uint8_t *image_pixels = pixels + image * image_stride;
+    float *image_scores = tile_scores + image * kLabelBlock;
+
+    // Kept in registers across the tile, since the block width is fixed
+    float accumulators[kLabelBlock];
+    std::copy(image_scores, image_scores + kLabelBlock, accumulators);
+
+    for (size_t row = row_begin; row < row_end; ++row) {
+      const uint8_t *row_pixels = image_pixels + row * row_stride;
+      const float *row_features = block_features + row * row_entries;
+
+      for (size_t col = 0; col < image_size_; ++col) {
+        const float *pixel_features =
+            row_features + (col * num_shades_ + row_pixels[col]) * kLabelBlock;
+
+        NAIVEBAYES_UNROLL_LABEL_BLOCK
+        for (size_t label = 0; label < kLabelBlock; ++label) {
+          accumulators[label] += pixel_features[label];
+        }
+      }
+    }
+
+    std::copy(accumulators, accumulators + kLabelBlock, image_scores);
+  }
+}
+
+void BatchScorer::ClassifyIndices(const uint8_t *pixels, size_t num_images,
+                                  size_t row_stride, size_t image_stride,
+                                  std::vector<float> &scores,
+                                  std::vector<size_t> &predictions) const {
+  Score(pixels, num_images, row_stride, image_stride, scores);
+
+  size_t num_labels = labels_.Size();
+  predictions.resize(num_images);
+
+  for (size_t image = 0; image < num_images; ++image) {
+    const float *image_scores = scores.data() + image * num_labels;
+    size_t prediction = 0;
+    float max_likelihood = -std::numeric_limits<float>::infinity();
+
+    for (size_t label = 0; label < num_labels; ++label) {
+      if (image_scores[label] > max_likelihood) {
+        max_likelihood = image_scores[label];
+        prediction = label;
+      }
+    }
+
+    predictions[image] = prediction;
+  }
+}
+
+size_t BatchScorer::FindInvalidImage(const uint8_t *pixels, size_t num_images,
+                                     size_t row_stride,
+                                     size_t image_stride) const {
+  for (size_t image = 0; image < num_images; ++image) {
+    const uint8_t *image_pixels = pixels + image * image_stride;
+    uint8_t max_shade = 0;
+
+    for (size_t row = 0; row < image_size_; ++row) {
+      const uint8_t *row_pixels = image_pixels + row * row_stride;
+
+      for (size_t col = 0; col < image_size_; ++col) {
+        max_shade = std::max(max_shade, row_pixels[col]);
+      }
+    }
+
+    if (max_shade >= num_shades_) {
+      return image;
+    }
+  }
+
+  return num_images;
+}
+
+const LabelSet &BatchScorer::GetLabelSet() const { return labels_; }
+
+size_t BatchScorer::GetImageSize() const { return image_size_; }
+
+} // namespace naivebayes
@@ -0,0 +1,219 @@
+#include "core/c_api.h"
+
+#include <exception>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "core/batch_scorer.h"
+#include "core/log_prob_table.h"
+#include "core/trainer.h"
+
+struct naivebayes_model {
+  naivebayes::LogProbTable table;
+  naivebayes::BatchScorer scorer;
+};
+
+namespace {
+
+/**
+ * Gets the message of the last failure on the calling thread
+ *
+ * @return the message, which the C interface hands out pointers into
+ */
+std::string &LastError() {
+  thread_local std::string last_error;
+  return last_error;
+}
+
+/**
+ * Records a failure for naivebayes_last_error
+ *
+ * @param status the status to return to the caller
+ * @param message a description of the failure
+ * @return the status
+ */
+naivebayes_status Fail(naivebayes_status status, const char *message) {
+  LastError() = message;
+  return status;
+}
+
+/**
+ * Compiles a saved model read from a stream into a handle
+ *
+ * @param input the stream of the saved model
+ * @param model populated with the new handle
+ * @return the status of the load
+ */
+naivebayes_status LoadModel(std::istream &input, naivebayes_model **model) {
+  try {
+    naivebayes::Trainer trainer;
+    input >> trainer;
+
+    // The Trainer keeps reusing the last line it read once the stream ends,
+    // so a truncated model is only noticed by the failed stream
+    if (input.fail()) {
+      return Fail(NAIVEBAYES_INVALID_MODEL, "Model is truncated");
+    }
+
+    if (trainer.GetLabels().empty() || trainer.GetImageSize() == 0) {
+      return Fail(NAIVEBAYES_INVALID_MODEL, "Model has no labels or pixels");
+    }
+
+    naivebayes::LogProbTable table(trainer);
+    *model = new naivebayes_model{table, naivebayes::BatchScorer(table)};
+    return NAIVEBAYES_OK;
+  } catch (const std::bad_alloc &) {
+    return Fail(NAIVEBAYES_INTERNAL_ERROR, "Out of memory loading the model");
+  } catch (const std::exception &error) {
+    return Fail(NAIVEBAYES_INVALID_MODEL, error.what());
+  }
+}
+
+/**
+ * Checks the arguments shared by the predict functions
+ *
+ * @return NAIVEBAYES_OK if the arguments can be predicted with
+ */
+naivebayes_status ValidatePredict(const naivebayes_model *model,
+                                  const uint8_t *pixels, size_t row_stride,
+                                  const char *labels) {
+  if (model == nullptr || pixels == nullptr || labels == nullptr) {
+    return Fail(NAIVEBAYES_INVALID_ARGUMENT, "Null argument");
+  }
+
+  if (row_stride < model->table.GetImageSize()) {
+    return Fail(NAIVEBAYES_INVALID_ARGUMENT,
+                "Row stride is smaller than a row of the image");
+  }
+
+  return NAIVEBAYES_OK;
+}
+
+/**
+ * Classifies one image, catching any failure
+ *
+ * @return the status of the prediction
+ */
+naivebayes_status PredictImage(const naivebayes_model *model,
+                               const uint8_t *pixels, size_t row_stride,
+                               char *label) {
+  try {
+    // Reused by every prediction on the thread so that predicting allocates
+    // nothing once the thread has warmed up
+    thread_local std::vector<float> scores;
+    size_t prediction = model->table.ClassifyIndex(pixels, row_stride, scores);
+
+    *label = model->table.GetLabelSet().LabelAt(prediction);
+    return NAIVEBAYES_OK;
+  } catch (const std::invalid_argument &error) {
+    return Fail(NAIVEBAYES_INVALID_ARGUMENT, error.what());
+  } catch (const std::exception &error) {
+    return Fail(NAIVEBAYES_INTERNAL_ERROR, error.what());
+  }
+}
+
+} // namespace
+
+naivebayes_status naivebayes_model_load(const char *path,
+                                        naivebayes_model **model) {
+  if (path == nullptr || model == nullptr) {
+    return Fail(NAIVEBAYES_INVALID_ARGUMENT, "Null argument");
+  }
+
+  std::ifstream model_stream(path);
+
+  if (!model_stream) {
+    return Fail(NAIVEBAYES_IO_ERROR, "Model file could not be opened");
+  }
+
+  return LoadModel(model_stream, model);
+}
+
+naivebayes_status naivebayes_model_load_buffer(const char *data, size_t size,
+                                               naivebayes_model **model) {
+  if (data == nullptr || model == nullptr) {
+    return Fail(NAIVEBAYES_INVALID_ARGUMENT, "Null argument");
+  }
+
+  try {
+    std::istringstream model_stream(std::string(data, size));
+    return LoadModel(model_stream, model);
+  } catch (const std::bad_alloc &) {
+    return Fail(NAIVEBAYES_INTERNAL_ERROR, "Out of memory loading the model");
+  }
+}
+
+void naivebayes_model_free(naivebayes_model *model) { delete model; }
+
+size_t naivebayes_model_image_size(const naivebayes_model *model) {
+  return model == nullptr ? 0 : model->table.GetImageSize();
+}
+
+size_t naivebayes_model_num_labels(const naivebayes_model *model) {
+  return model == nullptr ? 0 : model->table.GetLabels().size();
+}
+
+char naivebayes_model_label(const naivebayes_model *model, size_t index) {
+  if (model == nullptr || index >= model->table.GetLabels().size()) {
+    return '\0';
+  }
+
+  return model->table.GetLabels()[index];
+}
+
+naivebayes_status naivebayes_predict(const naivebayes_model *model,
+                                     const uint8_t *pixels, size_t row_stride,
+                                     char *label) {
+  naivebayes_status status = ValidatePredict(model, pixels, row_stride, label);
+
+  if (status != NAIVEBAYES_OK) {
+    return status;
+  }
+
+  return PredictImage(model, pixels, row_stride, label);
+}
+
+naivebayes_status naivebayes_predict_batch(const naivebayes_model *model,
+                                           const uint8_t *pixels,
+                                           size_t num_images,
+                                           size_t row_stride,
+                                           size_t image_stride,
+                                           char *labels) {
+  naivebayes_status status =
+      ValidatePredict(model, pixels, row_stride, labels);
+
+  if (status != NAIVEBAYES_OK) {
+    return status;
+  }
+
+  // Every image before the first invalid one is still classified
+  size_t num_valid = model->scorer.FindInvalidImage(pixels, num_images,
+                                                    row_stride, image_stride);
+
+  try {
+    // Reused by every batch on the thread, like the scores of PredictImage
+    thread_local std::vector<float> scores;
+    thread_local std::vector<size_t> predictions;
+    model->scorer.ClassifyIndices(pixels, num_valid, row_stride, image_stride,
+                                  scores, predictions);
+
+    for (size_t image = 0; image < num_valid; ++image) {
+      labels[image] = model->scorer.GetLabelSet().LabelAt(predictions[image]);
+    }
+  } catch (const std::exception &error) {
+    return Fail(NAIVEBAYES_INTERNAL_ERROR, error.what());
+  }
+
+  if (num_valid != num_images) {
+    return Fail(NAIVEBAYES_INVALID_ARGUMENT,
+                "Image shade is not part of the model");
+  }
+
+  return NAIVEBAYES_OK;
+}
+
+const char *naivebayes_last_error(void) { return LastError().c_str(); }
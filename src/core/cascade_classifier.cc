@@ -0,0 +1,264 @@
+#include "core/cascade_classifier.h"
+
+#include <algorithm>
+#include <core/feature_counts.h>
+#include <core/tracer.h>
+#include <core/trainer.h>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace naivebayes {
+
+namespace {
+
+/**
+ * Pools each square of pixels of a grid into the average of their shades,
+ * rounded to the nearest shade with halves rounding up
+ *
+ * @param pixels the full size pixels
+ * @param pool_factor the number of pixels along each side of a square
+ * @param pooled populated with one shade per byte, row by row
+ */
+void PoolPixels(const std::vector<std::vector<Pixel>> &pixels,
+                size_t pool_factor, std::vector<uint8_t> &pooled) {
+  size_t pooled_size = pixels.size() / pool_factor;
+  size_t pool_area = pool_factor * pool_factor;
+  pooled.assign(pooled_size * pooled_size, 0);
+
+  for (size_t row = 0; row < pooled_size * pool_factor; ++row) {
+    const std::vector<Pixel> &pixel_row = pixels[row];
+    uint8_t *pooled_row = pooled.data() + row / pool_factor * pooled_size;
+
+    for (size_t col = 0; col < pooled_size * pool_factor; ++col) {
+      pooled_row[col / pool_factor] += uint8_t(pixel_row[col]);
+    }
+  }
+
+  for (uint8_t &shade : pooled) {
+    shade = uint8_t((2 * size_t(shade) + pool_area) / (2 * pool_area));
+  }
+}
+
+/**
+ * Checks that a pool factor evenly divides an image size
+ *
+ * @param image_size the size of the full images
+ * @param pool_factor the number of pixels along each side of a square
+ * @throws std::invalid_argument if the factor does not divide the size
+ */
+void ValidatePoolFactor(size_t image_size, size_t pool_factor) {
+  // The pooled sums are held in a byte
+  if (pool_factor == 0 || image_size % pool_factor != 0 ||
+      pool_factor * pool_factor * (size_t(Pixel::kNumShades) - 1) > 255) {
+    throw std::invalid_argument("Pool factor does not divide the image size");
+  }
+}
+
+} // namespace
+
+CascadeClassifier::CascadeClassifier(const LogProbTable &full_table,
+                                     const LogProbTable &coarse_table,
+                                     size_t pool_factor,
+                                     float margin_threshold)
+    : full_table_(full_table), coarse_table_(coarse_table),
+      pool_factor_(pool_factor), margin_threshold_(margin_threshold) {
+
+  ValidatePoolFactor(full_table.GetImageSize(), pool_factor);
+
+  if (coarse_table.GetImageSize() * pool_factor != full_table.GetImageSize()) {
+    throw std::invalid_argument("Coarse model size does not match the pool");
+  }
+
+  if (coarse_table.GetLabels() != full_table.GetLabels()) {
+    throw std::invalid_argument("Coarse and full models have other labels");
+  }
+}
+
+Image CascadeClassifier::Downsample(const Image &image, size_t pool_factor) {
+  ValidatePoolFactor(image.GetSize(), pool_factor);
+
+  std::vector<uint8_t> pooled;
+  PoolPixels(image.GetPixels(), pool_factor, pooled);
+
+  size_t pooled_size = image.GetSize() / pool_factor;
+  std::vector<std::vector<Pixel>> pixels(pooled_size,
+                                         std::vector<Pixel>(pooled_size));
+
+  for (size_t row = 0; row < pooled_size; ++row) {
+    for (size_t col = 0; col < pooled_size; ++col) {
+      pixels[row][col] = Pixel(pooled[row * pooled_size + col]);
+    }
+  }
+
+  return Image(pooled_size, image.GetLabel(), std::move(pixels));
+}
+
+LogProbTable CascadeClassifier::TrainCoarseTable(
+    const std::vector<Image> &images, size_t pool_factor, float laplace) {
+  TraceScope trace("cascade", "TrainCoarseTable");
+
+  if (images.empty()) {
+    throw std::invalid_argument("No training images to train the model on");
+  }
+
+  FeatureCounts counts;
+
+  for (const Image &image : images) {
+    counts.AddImage(Downsample(image, pool_factor));
+  }
+
+  Trainer trainer(counts.GetImageSize(), size_t(Pixel::kNumShades),
+                  counts.GetLabels(), laplace);
+  trainer.CalculateFeatures(counts);
+  trainer.CalculatePriors(counts);
+
+  return LogProbTable(trainer);
+}
+
+float CascadeClassifier::Calibrate(const std::vector<Image> &images,
+                                   double agreement) {
+  TraceScope trace("cascade", "Calibrate");
+  std::vector<std::pair<float, bool>> margins;
+  std::vector<float> scores;
+
+  for (const Image &image : images) {
+    float margin = ScoreCoarse(image, scores);
+    size_t coarse_prediction =
+        size_t(std::max_element(scores.begin(), scores.end()) - scores.begin());
+
+    margins.emplace_back(margin, coarse_prediction !=
+                                     full_table_.ClassifyIndex(image));
+  }
+
+  // Lowering the threshold past each margin lets one more image be resolved
+  // by the coarse model, so the threshold stops at the last margin that keeps
+  // the disagreements within budget
+  std::sort(margins.begin(), margins.end(),
+            [](const std::pair<float, bool> &first,
+               const std::pair<float, bool> &second) {
+              return first.first > second.first;
+            });
+
+  size_t budget = size_t((1.0 - agreement) * double(margins.size()) + 1e-9);
+  size_t disagreements = 0;
+  margin_threshold_ = std::numeric_limits<float>::infinity();
+
+  for (size_t begin = 0; begin < margins.size();) {
+    size_t end = begin;
+
+    // Images with the same margin are either all resolved or none are
+    for (; end < margins.size() && margins[end].first == margins[begin].first;
+         ++end) {
+      disagreements += size_t(margins[end].second);
+    }
+
+    if (disagreements > budget) {
+      break;
+    }
+
+    margin_threshold_ = margins[begin].first;
+    begin = end;
+  }
+
+  return margin_threshold_;
+}
+
+char CascadeClassifier::Classify(const Image &image, bool *is_coarse) const {
+  // Reused by every call on the thread so that classifying does not allocate
+  thread_local std::vector<float> scores;
+  float margin = ScoreCoarse(image, scores);
+  bool is_resolved = margin >= margin_threshold_;
+
+  if (is_coarse != nullptr) {
+    *is_coarse = is_resolved;
+  }
+
+  if (is_resolved) {
+    size_t prediction =
+        size_t(std::max_element(scores.begin(), scores.end()) - scores.begin());
+    return coarse_table_.GetLabelSet().LabelAt(prediction);
+  }
+
+  return full_table_.Classify(image);
+}
+
+CascadeReport
+CascadeClassifier::Evaluate(const std::vector<Image> &images) const {
+  TraceScope trace("cascade", "Evaluate");
+  CascadeReport report = {0, 0, 0, 0, 0, 0};
+
+  for (const Image &image : images) {
+    bool is_coarse = false;
+    char prediction = Classify(image, &is_coarse);
+    char full_prediction = full_table_.Classify(image);
+
+    ++report.num_images;
+
+    if (is_coarse) {
+      ++report.num_coarse;
+    } else {
+      ++report.num_full;
+    }
+
+    report.num_cascade_correct += size_t(prediction == image.GetLabel());
+    report.num_full_correct += size_t(full_prediction == image.GetLabel());
+    report.num_disagreements += size_t(prediction != full_prediction);
+  }
+
+  return report;
+}
+
+void CascadeClassifier::PrintReport(std::ostream &output,
+                                    const CascadeReport &report) {
+  double num_images = double(std::max<size_t>(1, report.num_images));
+  double full_accuracy = 100.0 * double(report.num_full_correct) / num_images;
+  double cascade_accuracy =
+      100.0 * double(report.num_cascade_correct) / num_images;
+
+  output << "Images: " << report.num_images << std::endl;
+  output << "Resolved by the coarse model: " << report.num_coarse << " ("
+         << 100.0 * double(report.num_coarse) / num_images << "%)"
+         << std::endl;
+  output << "Resolved by the full model: " << report.num_full << " ("
+         << 100.0 * double(report.num_full) / num_images << "%)" << std::endl;
+  output << "Full model accuracy: " << full_accuracy << "%" << std::endl;
+  output << "Cascade accuracy: " << cascade_accuracy << "%" << std::endl;
+  output << "Accuracy delta: " << cascade_accuracy - full_accuracy << "%"
+         << std::endl;
+  output << "Disagreements with the full model: " << report.num_disagreements
+         << std::endl;
+}
+
+float CascadeClassifier::ScoreCoarse(const Image &image,
+                                     std::vector<float> &scores) const {
+  if (image.GetSize() != full_table_.GetImageSize()) {
+    throw std::invalid_argument("Image size does not match the model");
+  }
+
+  thread_local std::vector<uint8_t> pooled;
+  PoolPixels(image.GetPixels(), pool_factor_, pooled);
+  coarse_table_.Score(pooled.data(), coarse_table_.GetImageSize(), scores);
+
+  float best = -std::numeric_limits<float>::infinity();
+  float second_best = -std::numeric_limits<float>::infinity();
+
+  for (float score : scores) {
+    if (score > best) {
+      second_best = best;
+      best = score;
+    } else if (score > second_best) {
+      second_best = score;
+    }
+  }
+
+  return best - second_best;
+}
+
+float CascadeClassifier::GetMarginThreshold() const {
+  return margin_threshold_;
+}
+
+size_t CascadeClassifier::GetPoolFactor() const { return pool_factor_; }
+
+} // namespace naivebayes
@@ -0,0 +1,255 @@
+#include "core/dataset_reader.h"
+
+#include <algorithm>
+#include <core/memory_accounting.h>
+#include <core/metrics.h>
+#include <core/tracer.h>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+namespace naivebayes {
+
+namespace {
+
+/**
+ * Gets the counter of images decoded from dataset files
+ *
+ * @return the counter in the global registry
+ */
+Counter &ImagesParsed() {
+  static Counter &images_parsed = MetricsRegistry::Global().GetCounter(
+      "naivebayes_images_parsed_total", "Images decoded from dataset files");
+  return images_parsed;
+}
+
+// The number of parsed images counted at once
+const size_t kCountBatchSize = 1024;
+
+/**
+ * Counts a batch of parsed images and empties the batch
+ *
+ * @param batch the parsed images
+ * @param backend the way to count the images
+ * @param batch_images scratch space for pointers to the images
+ * @param counts the counts to add the images to
+ */
+void AddBatch(std::vector<Image> &batch, CountingBackend backend,
+              std::vector<const Image *> &batch_images,
+              FeatureCounts &counts) {
+  batch_images.clear();
+
+  for (const Image &image : batch) {
+    batch_images.push_back(&image);
+  }
+
+  counts.AddImages(batch_images, backend);
+  batch.clear();
+}
+
+} // namespace
+
+DatasetReader::DatasetReader(const std::string &file_path, size_t image_size)
+    : file_path_(file_path), image_size_(image_size), file_size_(0) {
+
+  std::ifstream file(file_path_, std::ios::binary | std::ios::ate);
+
+  if (!file) {
+    throw std::invalid_argument("Could not open dataset file");
+  }
+
+  file_size_ = size_t(file.tellg());
+
+  if (image_size_ == 0) {
+    image_size_ = DetectImageSize();
+  }
+}
+
+FeatureCounts DatasetReader::CountFeatures(size_t num_threads,
+                                           CountingBackend backend) const {
+  TraceScope trace("dataset", "CountFeatures");
+  SubsystemScope subsystem(Subsystem::kDataset);
+
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Rows of single pixel images cannot be told apart from label lines
+  if (image_size_ <= 1) {
+    num_threads = 1;
+  }
+
+  std::vector<std::future<FeatureCounts>> partial_counts;
+
+  for (const auto &range : SplitRanges(num_threads)) {
+    partial_counts.push_back(std::async(std::launch::async,
+                                        &DatasetReader::CountRange, this,
+                                        range.first, range.second, backend));
+  }
+
+  FeatureCounts counts(image_size_, size_t(Pixel::kNumShades), {});
+
+  for (auto &partial : partial_counts) {
+    counts += partial.get();
+  }
+
+  return counts;
+}
+
+std::vector<std::pair<size_t, size_t>>
+DatasetReader::SplitRanges(size_t num_ranges) const {
+  std::vector<std::pair<size_t, size_t>> ranges;
+  num_ranges = std::max<size_t>(1, std::min(num_ranges, file_size_));
+
+  for (size_t range = 0; range < num_ranges; ++range) {
+    ranges.emplace_back(file_size_ * range / num_ranges,
+                        file_size_ * (range + 1) / num_ranges);
+  }
+
+  return ranges;
+}
+
+bool DatasetReader::ReadImage(std::istream &input, Image &image) {
+  SubsystemScope subsystem(Subsystem::kDataset);
+  std::string label_line;
+
+  // Skip blank lines, such as a trailing empty line at the end of file
+  while (label_line.empty()) {
+    if (!std::getline(input, label_line)) {
+      return false;
+    }
+  }
+
+  if (label_line.length() != 1) {
+    throw std::invalid_argument("Expected a label line in the dataset");
+  }
+
+  std::vector<std::string> ascii_image(1);
+
+  if (!std::getline(input, ascii_image[0]) || ascii_image[0].empty()) {
+    throw std::invalid_argument("Incomplete image at end of dataset");
+  }
+
+  ascii_image.resize(ascii_image[0].length());
+
+  for (size_t row = 1; row < ascii_image.size(); ++row) {
+    if (!std::getline(input, ascii_image[row])) {
+      throw std::invalid_argument("Incomplete image at end of dataset");
+    }
+  }
+
+  image = Image(ascii_image, label_line[0]);
+  ImagesParsed().Increment();
+
+  return true;
+}
+
+size_t DatasetReader::GetImageSize() const { return image_size_; }
+
+size_t DatasetReader::GetFileSize() const { return file_size_; }
+
+size_t DatasetReader::DetectImageSize() const {
+  std::ifstream file(file_path_, std::ios::binary);
+  std::string current_line;
+
+  std::getline(file, current_line);
+  std::getline(file, current_line);
+
+  return current_line.length();
+}
+
+size_t DatasetReader::SeekRecordStart(std::ifstream &file,
+                                      size_t offset) const {
+  std::string current_line;
+  size_t position = offset;
+
+  if (offset > 0) {
+    // Skip the rest of the line the offset lands in, which belongs to the
+    // previous range. Starting one byte early keeps a line that begins
+    // exactly at the offset
+    file.seekg(std::streamoff(offset - 1));
+    std::getline(file, current_line);
+    position = offset - 1 + current_line.size() + 1;
+  }
+
+  while (std::getline(file, current_line)) {
+    size_t label_position = position;
+    position += current_line.size() + 1;
+
+    if (current_line.length() == 1 && IsRecordAt(file)) {
+      file.clear();
+      file.seekg(std::streamoff(label_position));
+      return label_position;
+    }
+
+    file.clear();
+    file.seekg(std::streamoff(position));
+  }
+
+  return file_size_;
+}
+
+bool DatasetReader::IsRecordAt(std::ifstream &file) const {
+  std::string current_line;
+
+  // A label line is followed by exactly image height rows, and then either
+  // the next label line or the end of the file
+  for (size_t row = 0; row < image_size_; ++row) {
+    if (!std::getline(file, current_line) || current_line.length() == 1) {
+      return false;
+    }
+  }
+
+  return !std::getline(file, current_line) || current_line.length() <= 1;
+}
+
+FeatureCounts DatasetReader::CountRange(size_t begin, size_t end,
+                                        CountingBackend backend) const {
+  TraceScope trace("dataset", "CountRange");
+  SubsystemScope subsystem(Subsystem::kDataset);
+  std::ifstream file(file_path_, std::ios::binary);
+  FeatureCounts counts(image_size_, size_t(Pixel::kNumShades), {});
+
+  size_t position = SeekRecordStart(file, begin);
+  std::string label_line;
+  std::vector<std::string> ascii_image(image_size_);
+
+  // Images are counted in batches so that each label fills whole bit slices
+  std::vector<Image> batch;
+  std::vector<const Image *> batch_images;
+  batch.reserve(kCountBatchSize);
+
+  while (position < end && std::getline(file, label_line)) {
+    position += label_line.size() + 1;
+
+    // Tolerate blank lines, such as a trailing empty line at the end of file
+    if (label_line.empty()) {
+      continue;
+    }
+
+    if (label_line.length() != 1) {
+      throw std::invalid_argument("Expected a label line in the dataset");
+    }
+
+    for (std::string &row : ascii_image) {
+      if (!std::getline(file, row)) {
+        throw std::invalid_argument("Incomplete image at end of dataset");
+      }
+
+      position += row.size() + 1;
+    }
+
+    batch.emplace_back(ascii_image, label_line[0]);
+
+    if (batch.size() == kCountBatchSize) {
+      AddBatch(batch, backend, batch_images, counts);
+    }
+  }
+
+  AddBatch(batch, backend, batch_images, counts);
+  ImagesParsed().Increment(counts.GetTotal());
+
+  return counts;
+}
+
+} // namespace naivebayes
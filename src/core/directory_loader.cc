@@ -0,0 +1,594 @@
+#include "core/directory_loader.h"
+
+#include <algorithm>
+#include <core/memory_accounting.h>
+#include <core/parallel.h>
+#include <core/row_decoder.h>
+#include <core/tracer.h>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// The ring is mapped through the features field of the setup parameters,
+// which arrived with single mmap support in the 5.4 headers
+#ifdef IORING_FEAT_SINGLE_MMAP
+#define NAIVEBAYES_HAS_IO_URING 1
+#include <cerrno>
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#endif
+#endif
+
+namespace naivebayes {
+
+namespace {
+
+/**
+ * Reads a whole file with a blocking read
+ *
+ * @param file_path the path of the file
+ * @param contents populated with the contents of the file
+ * @throws std::invalid_argument if the file cannot be read
+ */
+void ReadFile(const std::string &file_path, std::string &contents) {
+  std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+
+  if (!file) {
+    throw std::invalid_argument("Cannot open " + file_path);
+  }
+
+  contents.resize(size_t(file.tellg()));
+  file.seekg(0);
+  file.read(&contents[0], std::streamsize(contents.size()));
+
+  if (!file) {
+    throw std::invalid_argument("Cannot read " + file_path);
+  }
+}
+
+#ifdef NAIVEBAYES_HAS_IO_URING
+// The number of reads the ring holds at once
+const unsigned kRingEntries = 256;
+#endif
+
+} // namespace
+
+#ifdef NAIVEBAYES_HAS_IO_URING
+
+/**
+ * A minimal io_uring driven through the raw system calls, which submits a
+ * read of every file of a batch at once and waits for all of them
+ */
+class IoUring {
+
+public:
+  IoUring() : ring_fd_(-1), sq_ring_(MAP_FAILED), cq_ring_(MAP_FAILED),
+              sqes_(MAP_FAILED), sq_ring_size_(0), cq_ring_size_(0),
+              sqes_size_(0) {
+    std::memset(&params_, 0, sizeof(params_));
+    ring_fd_ = int(syscall(__NR_io_uring_setup, kRingEntries, &params_));
+
+    if (ring_fd_ < 0) {
+      return;
+    }
+
+    sq_ring_size_ =
+        params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+    bool is_single_mmap = params_.features & IORING_FEAT_SINGLE_MMAP;
+
+    if (is_single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    cq_ring_ = is_single_mmap
+                   ? sq_ring_
+                   : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd_,
+                          IORING_OFF_CQ_RING);
+    sqes_size_ = params_.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  }
+
+  ~IoUring() {
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+
+    if (ring_fd_ >= 0) {
+      close(ring_fd_);
+    }
+  }
+
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  bool IsValid() const {
+    return ring_fd_ >= 0 && sq_ring_ != MAP_FAILED &&
+           cq_ring_ != MAP_FAILED && sqes_ != MAP_FAILED;
+  }
+
+  /**
+   * Reads whole files, at most kRingEntries at a time
+   *
+   * @param file_paths the paths of the files to read
+   * @param contents populated with the contents of each file
+   * @return false if the kernel does not support io_uring reads, in which
+   * case nothing has been read
+   * @throws std::invalid_argument if a file cannot be read
+   */
+  bool ReadFiles(const std::vector<const std::string *> &file_paths,
+                 std::vector<std::string> &contents) {
+    std::vector<int> fds(file_paths.size(), -1);
+    bool is_supported = true;
+
+    try {
+      for (size_t file = 0; file < file_paths.size(); ++file) {
+        fds[file] = open(file_paths[file]->c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat file_stat;
+
+        if (fds[file] < 0 || fstat(fds[file], &file_stat) != 0) {
+          throw std::invalid_argument("Cannot open " + *file_paths[file]);
+        }
+
+        contents[file].resize(size_t(file_stat.st_size));
+      }
+
+      for (size_t begin = 0; begin < fds.size() && is_supported;
+           begin += kRingEntries) {
+        size_t end = std::min<size_t>(fds.size(), begin + kRingEntries);
+        is_supported = ReadRange(fds, begin, end, file_paths, contents);
+      }
+    } catch (...) {
+      CloseAll(fds);
+      throw;
+    }
+
+    CloseAll(fds);
+
+    return is_supported;
+  }
+
+private:
+  /**
+   * Submits one read per file of a range and waits for all of them, reading
+   * any file the ring only partly read with blocking reads
+   *
+   * @return false if the kernel rejected the read operation
+   */
+  bool ReadRange(const std::vector<int> &fds, size_t begin, size_t end,
+                 const std::vector<const std::string *> &file_paths,
+                 std::vector<std::string> &contents) {
+    char *sq_ring = static_cast<char *>(sq_ring_);
+    char *cq_ring = static_cast<char *>(cq_ring_);
+    unsigned *sq_tail =
+        reinterpret_cast<unsigned *>(sq_ring + params_.sq_off.tail);
+    unsigned sq_mask =
+        *reinterpret_cast<unsigned *>(sq_ring + params_.sq_off.ring_mask);
+    unsigned *sq_array =
+        reinterpret_cast<unsigned *>(sq_ring + params_.sq_off.array);
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(sqes_);
+
+    // Vectored reads are used because plain reads need 5.6 headers and
+    // kernels, and the vectors must live until every read completes
+    std::vector<iovec> buffers(end - begin);
+    unsigned tail = *sq_tail;
+
+    for (size_t file = begin; file < end; ++file) {
+      unsigned index = tail & sq_mask;
+      io_uring_sqe &sqe = sqes[index];
+      iovec &buffer = buffers[file - begin];
+
+      buffer.iov_base = &contents[file][0];
+      buffer.iov_len = contents[file].size();
+
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = IORING_OP_READV;
+      sqe.fd = fds[file];
+      sqe.addr = reinterpret_cast<uint64_t>(&buffer);
+      sqe.len = 1;
+      sqe.off = 0;
+      sqe.user_data = file;
+      sq_array[index] = index;
+      ++tail;
+    }
+
+    // The kernel must see the entries before it sees the new tail
+    __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+    unsigned *cq_head =
+        reinterpret_cast<unsigned *>(cq_ring + params_.cq_off.head);
+    unsigned *cq_tail =
+        reinterpret_cast<unsigned *>(cq_ring + params_.cq_off.tail);
+    unsigned cq_mask =
+        *reinterpret_cast<unsigned *>(cq_ring + params_.cq_off.ring_mask);
+    io_uring_cqe *cqes =
+        reinterpret_cast<io_uring_cqe *>(cq_ring + params_.cq_off.cqes);
+
+    unsigned to_submit = unsigned(end - begin);
+    size_t remaining = end - begin;
+    bool is_supported = true;
+    // The kernel may still be writing into the buffers of other reads, so the
+    // first failure is only thrown once every read has completed
+    std::string first_error;
+
+    while (remaining > 0) {
+      long entered =
+          syscall(__NR_io_uring_enter, ring_fd_, to_submit, unsigned(remaining),
+                  IORING_ENTER_GETEVENTS, nullptr, 0);
+
+      if (entered < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          continue;
+        }
+
+        // Only an unusable ring fails this way, and its reads never start
+        throw std::invalid_argument("io_uring_enter failed: " +
+                                    std::string(std::strerror(errno)));
+      }
+
+      to_submit -= std::min(to_submit, unsigned(entered));
+
+      unsigned head = *cq_head;
+      unsigned completed_tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+      for (; head != completed_tail; ++head) {
+        const io_uring_cqe &cqe = cqes[head & cq_mask];
+        size_t file = size_t(cqe.user_data);
+        --remaining;
+
+        if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+          is_supported = false;
+        } else if (cqe.res < 0) {
+          if (first_error.empty()) {
+            first_error = "Cannot read " + *file_paths[file];
+          }
+        } else if (size_t(cqe.res) < contents[file].size() &&
+                   first_error.empty()) {
+          try {
+            FinishRead(fds[file], size_t(cqe.res), *file_paths[file],
+                       contents[file]);
+          } catch (const std::invalid_argument &error) {
+            first_error = error.what();
+          }
+        }
+      }
+
+      __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    if (!first_error.empty()) {
+      throw std::invalid_argument(first_error);
+    }
+
+    return is_supported;
+  }
+
+  /**
+   * Reads the rest of a file the ring only partly read
+   */
+  static void FinishRead(int fd, size_t offset, const std::string &file_path,
+                         std::string &contents) {
+    while (offset < contents.size()) {
+      ssize_t bytes_read = pread(fd, &contents[offset],
+                                 contents.size() - offset, off_t(offset));
+
+      if (bytes_read <= 0) {
+        if (bytes_read < 0 && errno == EINTR) {
+          continue;
+        }
+
+        throw std::invalid_argument("Cannot read " + file_path);
+      }
+
+      offset += size_t(bytes_read);
+    }
+  }
+
+  static void CloseAll(const std::vector<int> &fds) {
+    for (int fd : fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  int ring_fd_;
+  io_uring_params params_;
+  void *sq_ring_;
+  void *cq_ring_;
+  void *sqes_;
+  size_t sq_ring_size_;
+  size_t cq_ring_size_;
+  size_t sqes_size_;
+};
+
+#endif
+
+DirectoryLoader::DirectoryLoader(const std::string &directory_path,
+                                 const std::string &extension,
+                                 IoBackend backend, size_t batch_size)
+    : backend_(backend), batch_size_(std::max<size_t>(1, batch_size)) {
+
+  std::vector<std::string> file_names;
+
+#ifdef _WIN32
+  WIN32_FIND_DATAA find_data;
+  HANDLE find_handle =
+      FindFirstFileA((directory_path + "\\*" + extension).c_str(), &find_data);
+
+  if (find_handle == INVALID_HANDLE_VALUE) {
+    if (GetLastError() != ERROR_FILE_NOT_FOUND) {
+      throw std::invalid_argument("Cannot open directory " + directory_path);
+    }
+  } else {
+    do {
+      if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        file_names.push_back(find_data.cFileName);
+      }
+    } while (FindNextFileA(find_handle, &find_data));
+
+    FindClose(find_handle);
+  }
+
+  const std::string separator = "\\";
+#else
+  DIR *directory = opendir(directory_path.c_str());
+
+  if (directory == nullptr) {
+    throw std::invalid_argument("Cannot open directory " + directory_path);
+  }
+
+  while (dirent *entry = readdir(directory)) {
+    std::string name = entry->d_name;
+
+    // Skips hidden files along with . and ..
+    if (name.empty() || name[0] == '.' || name.size() < extension.size() ||
+        name.compare(name.size() - extension.size(), extension.size(),
+                     extension) != 0) {
+      continue;
+    }
+
+    file_names.push_back(name);
+  }
+
+  closedir(directory);
+
+  const std::string separator = "/";
+#endif
+
+  std::sort(file_names.begin(), file_names.end());
+
+  for (const std::string &name : file_names) {
+    std::string file_path = directory_path + separator + name;
+
+    if (!IsDirectory(file_path)) {
+      file_paths_.push_back(file_path);
+    }
+  }
+}
+
+std::vector<Image> DirectoryLoader::LoadImages(size_t num_threads) const {
+  TraceScope trace("dataset", "LoadDirectory");
+  SubsystemScope subsystem(Subsystem::kDataset);
+  std::vector<Image> images;
+  images.reserve(file_paths_.size());
+
+  ForEachBatch(num_threads, [&images](size_t, std::vector<Image> &batch) {
+    for (Image &image : batch) {
+      images.push_back(std::move(image));
+    }
+  });
+
+  return images;
+}
+
+FeatureCounts DirectoryLoader::CountFeatures(size_t num_threads,
+                                             CountingBackend backend) const {
+  TraceScope trace("dataset", "CountDirectory");
+  SubsystemScope subsystem(Subsystem::kDataset);
+  FeatureCounts counts;
+  std::vector<const Image *> batch_images;
+
+  ForEachBatch(num_threads, [&](size_t, std::vector<Image> &batch) {
+    batch_images.clear();
+
+    for (const Image &image : batch) {
+      batch_images.push_back(&image);
+    }
+
+    counts.AddImages(batch_images, backend);
+  });
+
+  return counts;
+}
+
+template <typename Consumer>
+void DirectoryLoader::ForEachBatch(size_t num_threads,
+                                   Consumer consume) const {
+  num_threads = ResolveNumThreads(num_threads);
+  std::vector<std::string> contents;
+  std::vector<Image> images;
+  IoUring *ring = nullptr;
+
+#ifdef NAIVEBAYES_HAS_IO_URING
+  // Set up once per load rather than once per batch
+  std::unique_ptr<IoUring> load_ring;
+
+  if (backend_ == IoBackend::kAuto && !file_paths_.empty()) {
+    load_ring.reset(new IoUring());
+
+    if (load_ring->IsValid()) {
+      ring = load_ring.get();
+    }
+  }
+#endif
+
+  for (size_t begin = 0; begin < file_paths_.size(); begin += batch_size_) {
+    size_t end = std::min(file_paths_.size(), begin + batch_size_);
+
+    ReadBatch(begin, end, num_threads, ring, contents);
+    images.assign(end - begin, Image());
+
+    {
+      TraceScope trace("dataset", "DecodeBatch");
+
+      ParallelFor(end - begin, num_threads,
+                  [&](size_t, size_t chunk_begin, size_t chunk_end) {
+                    SubsystemScope chunk_subsystem(Subsystem::kDataset);
+
+                    for (size_t file = chunk_begin; file < chunk_end; ++file) {
+                      try {
+                        images[file] = DecodeImage(contents[file]);
+                      } catch (const std::exception &error) {
+                        throw std::invalid_argument(file_paths_[begin + file] +
+                                                    ": " + error.what());
+                      }
+                    }
+                  });
+    }
+
+    consume(begin, images);
+  }
+}
+
+void DirectoryLoader::ReadBatch(size_t begin, size_t end, size_t num_threads,
+                                IoUring *&ring,
+                                std::vector<std::string> &contents) const {
+  TraceScope trace("dataset", "ReadBatch");
+  contents.resize(end - begin);
+
+#ifdef NAIVEBAYES_HAS_IO_URING
+  if (ring != nullptr) {
+    std::vector<const std::string *> batch_paths;
+
+    for (size_t file = begin; file < end; ++file) {
+      batch_paths.push_back(&file_paths_[file]);
+    }
+
+    if (ring->ReadFiles(batch_paths, contents)) {
+      return;
+    }
+
+    ring = nullptr;
+  }
+#else
+  (void)ring;
+#endif
+
+  ParallelFor(end - begin, num_threads,
+              [&](size_t, size_t chunk_begin, size_t chunk_end) {
+                for (size_t file = chunk_begin; file < chunk_end; ++file) {
+                  ReadFile(file_paths_[begin + file], contents[file]);
+                }
+              });
+}
+
+Image DirectoryLoader::DecodeImage(const std::string &contents) {
+  size_t line_begin = contents.find('\n');
+
+  if (line_begin == std::string::npos || line_begin == 0) {
+    throw std::invalid_argument("Image file has no label line");
+  }
+
+  char label = contents[0];
+  std::vector<std::vector<Pixel>> pixels;
+  std::vector<uint8_t> shades;
+  ++line_begin;
+
+  while (line_begin < contents.size()) {
+    size_t line_end = contents.find('\n', line_begin);
+
+    if (line_end == std::string::npos) {
+      line_end = contents.size();
+    }
+
+    size_t length = line_end - line_begin;
+
+    if (length > 0 && contents[line_begin + length - 1] == '\r') {
+      --length;
+    }
+
+    // Trailing blank lines are not rows of the image
+    if (length == 0 &&
+        contents.find_first_not_of("\r\n", line_end) == std::string::npos) {
+      break;
+    }
+
+    shades.resize(length);
+    DecodeRow(contents.data() + line_begin, length, shades.data());
+
+    std::vector<Pixel> row(length);
+
+    for (size_t col = 0; col < length; ++col) {
+      row[col] = Pixel(shades[col]);
+    }
+
+    pixels.push_back(std::move(row));
+    line_begin = line_end + 1;
+  }
+
+  if (pixels.empty()) {
+    throw std::invalid_argument("Image file has no rows");
+  }
+
+  size_t image_size = pixels.size();
+
+  // The Image constructor only compares the first row against the height
+  for (const std::vector<Pixel> &row : pixels) {
+    if (row.size() != image_size) {
+      throw std::invalid_argument("Image data is not square");
+    }
+  }
+
+  return Image(image_size, label, std::move(pixels));
+}
+
+bool DirectoryLoader::IsDirectory(const std::string &path) {
+  struct stat path_stat;
+
+  return stat(path.c_str(), &path_stat) == 0 &&
+         (path_stat.st_mode & S_IFMT) == S_IFDIR;
+}
+
+bool DirectoryLoader::IsIoUringAvailable() {
+#ifdef NAIVEBAYES_HAS_IO_URING
+  return IoUring().IsValid();
+#else
+  return false;
+#endif
+}
+
+const std::vector<std::string> &DirectoryLoader::GetFilePaths() const {
+  return file_paths_;
+}
+
+} // namespace naivebayes
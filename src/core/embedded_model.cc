@@ -0,0 +1,123 @@
+#include "core/embedded_model.h"
+
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <ios>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "core/log_prob_table.h"
+
+namespace naivebayes {
+
+namespace {
+
+// Values written per line of a generated table
+constexpr size_t kValuesPerLine = 4;
+
+/**
+ * Checks whether a name can be used as a C++ identifier
+ *
+ * @param name the name to check
+ * @return true if the name is a valid identifier
+ */
+bool IsIdentifier(const std::string &name) {
+  if (name.empty() || std::isdigit((unsigned char)name[0])) {
+    return false;
+  }
+
+  for (char character : name) {
+    if (!std::isalnum((unsigned char)character) && character != '_') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Writes a float as a literal that reads back as exactly the same value
+ *
+ * @param output the output stream to write to
+ * @param value the value to write
+ */
+void WriteFloat(std::ostream &output, float value) {
+  if (std::isinf(value)) {
+    output << (value < 0 ? "-" : "")
+           << "std::numeric_limits<float>::infinity()";
+    return;
+  }
+
+  // 9 significant digits are enough to round trip any float
+  output << std::scientific << std::setprecision(8) << value << "f";
+}
+
+/**
+ * Writes a constexpr, cache line aligned table of floats
+ *
+ * @param output the output stream to write to
+ * @param name the name of the table
+ * @param values the values of the table
+ */
+void WriteTable(std::ostream &output, const std::string &name,
+                const std::vector<float> &values) {
+  output << "alignas(64) constexpr float " << name << "[] = {";
+
+  for (size_t index = 0; index < values.size(); ++index) {
+    output << (index % kValuesPerLine == 0 ? "\n    " : " ");
+    WriteFloat(output, values[index]);
+    output << ",";
+  }
+
+  output << "\n};\n\n";
+}
+
+} // namespace
+
+void WriteEmbeddedModel(const LogProbTable &table,
+                        const std::string &function_name,
+                        std::ostream &output) {
+  if (table.GetLabels().empty()) {
+    throw std::invalid_argument("Cannot embed a model with no labels");
+  }
+
+  if (!IsIdentifier(function_name)) {
+    throw std::invalid_argument("Function name is not a valid identifier");
+  }
+
+  std::ios::fmtflags flags = output.flags();
+  std::streamsize precision = output.precision();
+
+  output << "// Generated by train-model embed. Do not edit.\n\n"
+         << "#include <core/embedded_model.h>\n"
+         << "#include <limits>\n\n"
+         << "namespace naivebayes {\n\n"
+         << "namespace {\n\n";
+
+  output << "constexpr char kLabels[] = {";
+
+  for (char label : table.GetLabels()) {
+    output << int(label) << ", ";
+  }
+
+  output << "};\n\n";
+
+  WriteTable(output, "kLogPriors", table.GetLogPriors());
+  WriteTable(output, "kLogFeatures", table.GetLogFeatures());
+
+  output << "constexpr EmbeddedModel kModel = {" << table.GetImageSize()
+         << ", " << table.GetNumShades() << ", " << table.GetLabels().size()
+         << ",\n                                   kLabels, kLogPriors, "
+            "kLogFeatures};\n\n"
+         << "} // namespace\n\n"
+         << "const EmbeddedModel &" << function_name
+         << "() { return kModel; }\n\n"
+         << "} // namespace naivebayes\n";
+
+  output.flags(flags);
+  output.precision(precision);
+}
+
+} // namespace naivebayes
@@ -0,0 +1,426 @@
+#include "core/evaluator.h"
+
+#include <core/dataset_reader.h>
+#include <core/memory_accounting.h>
+#include <core/metrics.h>
+#include <core/parallel.h>
+#include <core/tracer.h>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+namespace naivebayes {
+
+namespace {
+
+/**
+ * Calculates the accuracy of a model on the images of a single label
+ *
+ * @param evaluation the evaluation of the model
+ * @param label the label of the images
+ * @return the fraction of the label's images predicted correctly
+ */
+float LabelAccuracy(const ModelEvaluation &evaluation, char label) {
+  auto label_itr = evaluation.confusion_matrix.find(label);
+
+  if (label_itr == evaluation.confusion_matrix.end()) {
+    return 0.0f;
+  }
+
+  size_t num_correct = 0;
+  size_t num_images = 0;
+
+  for (const auto &outcome_itr : label_itr->second) {
+    num_images += outcome_itr.second;
+
+    if (outcome_itr.first) {
+      num_correct += outcome_itr.second;
+    }
+  }
+
+  return num_images == 0 ? 0.0f : float(num_correct) / float(num_images);
+}
+
+/**
+ * Tallies the outcomes of one model's predictions by the dense index of each
+ * label in the model, so that the hot loop never searches a tree
+ */
+struct LabelTally {
+  // Incorrect and correct predictions, indexed by label index
+  std::vector<std::array<size_t, 2>> outcomes;
+  // Images whose label the model was never trained on, always incorrect
+  std::map<char, size_t> unknown_labels;
+};
+
+/**
+ * Compiles a model from raw counts
+ *
+ * @param counts the raw counts of the training images
+ * @param laplace the smoothing value to compile the model with
+ * @return the compiled model
+ * @throws std::invalid_argument if the smoothing value is not positive
+ */
+LogProbTable CompileTable(const FeatureCounts &counts, float laplace) {
+  if (laplace <= 0.0f) {
+    throw std::invalid_argument("Laplace smoothing must be positive");
+  }
+
+  Trainer trainer(counts.GetImageSize(), counts.GetNumShades(),
+                  counts.GetLabels(), laplace);
+  trainer.CalculateFeatures(counts);
+  trainer.CalculatePriors(counts);
+
+  return LogProbTable(trainer);
+}
+
+/**
+ * Counts a batch of parsed images and empties the batch
+ *
+ * @param batch the parsed images
+ * @param batch_images scratch space for pointers to the images
+ * @param counts the counts to add the images to
+ */
+void AddBatch(std::vector<Image> &batch,
+              std::vector<const Image *> &batch_images,
+              FeatureCounts &counts) {
+  batch_images.clear();
+
+  for (const Image &image : batch) {
+    batch_images.push_back(&image);
+  }
+
+  counts.AddImages(batch_images);
+  batch.clear();
+}
+
+} // namespace
+
+Evaluator::Evaluator(size_t num_threads, size_t batch_size)
+    : num_threads_(ResolveNumThreads(num_threads)),
+      batch_size_(std::max<size_t>(1, batch_size)) {}
+
+std::vector<ModelEvaluation>
+Evaluator::Evaluate(std::istream &testing_stream,
+                    const std::vector<const LogProbTable *> &tables) const {
+  return Compare(testing_stream, tables).models;
+}
+
+ComparisonReport
+Evaluator::Compare(std::istream &testing_stream,
+                   const std::vector<const LogProbTable *> &tables) const {
+
+  MetricsRegistry &registry = MetricsRegistry::Global();
+  static Counter &images_evaluated =
+      registry.GetCounter("naivebayes_images_evaluated_total",
+                          "Testing images scored for accuracy");
+  static Histogram &batch_duration =
+      registry.GetHistogram("naivebayes_evaluate_batch_duration_ns",
+                            "Time to score a batch of testing images");
+
+  SubsystemScope subsystem(Subsystem::kEvaluator);
+
+  typedef std::vector<std::vector<size_t>> DisagreementMatrix;
+
+  size_t num_tables = tables.size();
+  std::vector<LabelTally> empty_tallies(num_tables);
+
+  for (size_t table = 0; table < num_tables; ++table) {
+    empty_tallies[table].outcomes.assign(tables[table]->GetLabelSet().Size(),
+                                         {{0, 0}});
+  }
+
+  // Every chunk of a batch tallies into its own matrices, merged at the end
+  std::vector<std::vector<LabelTally>> chunk_confusion(num_threads_,
+                                                       empty_tallies);
+  std::vector<DisagreementMatrix> chunk_disagreements(
+      num_threads_,
+      DisagreementMatrix(num_tables, std::vector<size_t>(num_tables, 0)));
+
+  std::vector<Image> batch(batch_size_);
+  bool has_images = true;
+
+  while (has_images) {
+    size_t batch_images = 0;
+
+    {
+      TraceScope trace("evaluator", "DecodeBatch");
+
+      while (batch_images < batch_size_ &&
+             DatasetReader::ReadImage(testing_stream, batch[batch_images])) {
+        ++batch_images;
+      }
+    }
+
+    has_images = batch_images == batch_size_;
+    images_evaluated.Increment(batch_images);
+    ScopedTimer timer(batch_duration);
+    TraceScope trace("evaluator", "ScoreBatch");
+
+    ParallelFor(
+        batch_images, num_threads_,
+        [&](size_t chunk, size_t begin, size_t end) {
+          TraceScope chunk_trace("evaluator", "ScoreChunk");
+          SubsystemScope chunk_subsystem(Subsystem::kEvaluator);
+          std::vector<char> predictions(num_tables);
+
+          for (size_t image = begin; image < end; ++image) {
+            char label = batch[image].GetLabel();
+
+            for (size_t table = 0; table < num_tables; ++table) {
+              const LabelSet &labels = tables[table]->GetLabelSet();
+              size_t prediction = tables[table]->ClassifyIndex(batch[image]);
+              LabelTally &tally = chunk_confusion[chunk][table];
+
+              predictions[table] = labels.LabelAt(prediction);
+
+              if (labels.Contains(label)) {
+                size_t label_index = labels.IndexOf(label);
+                ++tally.outcomes[label_index][prediction == label_index];
+              } else {
+                ++tally.unknown_labels[label];
+              }
+            }
+
+            for (size_t first = 0; first < num_tables; ++first) {
+              for (size_t second = 0; second < num_tables; ++second) {
+                if (predictions[first] != predictions[second]) {
+                  ++chunk_disagreements[chunk][first][second];
+                }
+              }
+            }
+          }
+        });
+  }
+
+  ComparisonReport report;
+  report.models.assign(num_tables, ModelEvaluation{0, 0, 0.0f, {}});
+  report.disagreements.assign(num_tables, std::vector<size_t>(num_tables, 0));
+
+  for (size_t chunk = 0; chunk < num_threads_; ++chunk) {
+    for (size_t table = 0; table < num_tables; ++table) {
+      ModelEvaluation &evaluation = report.models[table];
+      const LabelSet &labels = tables[table]->GetLabelSet();
+      const LabelTally &tally = chunk_confusion[chunk][table];
+
+      // Labels are only translated back to characters once per chunk
+      for (size_t label = 0; label < tally.outcomes.size(); ++label) {
+        for (size_t outcome = 0; outcome < 2; ++outcome) {
+          size_t num_images = tally.outcomes[label][outcome];
+
+          if (num_images > 0) {
+            evaluation.confusion_matrix[labels.LabelAt(label)][outcome == 1] +=
+                num_images;
+            evaluation.num_images += num_images;
+          }
+        }
+
+        evaluation.num_correct += tally.outcomes[label][1];
+      }
+
+      for (const auto &label_itr : tally.unknown_labels) {
+        evaluation.confusion_matrix[label_itr.first][false] +=
+            label_itr.second;
+        evaluation.num_images += label_itr.second;
+      }
+
+      for (size_t other = 0; other < num_tables; ++other) {
+        report.disagreements[table][other] +=
+            chunk_disagreements[chunk][table][other];
+      }
+    }
+  }
+
+  for (ModelEvaluation &evaluation : report.models) {
+    if (evaluation.num_images > 0) {
+      evaluation.accuracy =
+          float(evaluation.num_correct) / float(evaluation.num_images);
+    }
+  }
+
+  return report;
+}
+
+std::vector<ModelEvaluation>
+Evaluator::SweepLaplace(const FeatureCounts &counts,
+                        const std::vector<float> &laplace_values,
+                        std::istream &testing_stream) const {
+
+  std::vector<LogProbTable> tables;
+
+  for (float laplace : laplace_values) {
+    tables.push_back(CompileTable(counts, laplace));
+  }
+
+  std::vector<const LogProbTable *> table_pointers;
+
+  for (const LogProbTable &table : tables) {
+    table_pointers.push_back(&table);
+  }
+
+  return Evaluate(testing_stream, table_pointers);
+}
+
+std::vector<LearningCurvePoint>
+Evaluator::LearningCurve(std::istream &training_stream,
+                         const std::vector<size_t> &checkpoints,
+                         std::istream &testing_stream, float laplace) const {
+  TraceScope trace("evaluator", "LearningCurve");
+
+  if (laplace <= 0.0f) {
+    throw std::invalid_argument("Laplace smoothing must be positive");
+  }
+
+  std::vector<size_t> sorted_checkpoints(checkpoints);
+  std::sort(sorted_checkpoints.begin(), sorted_checkpoints.end());
+  sorted_checkpoints.erase(
+      std::unique(sorted_checkpoints.begin(), sorted_checkpoints.end()),
+      sorted_checkpoints.end());
+
+  if (!sorted_checkpoints.empty() && sorted_checkpoints.front() == 0) {
+    throw std::invalid_argument("Learning curve checkpoints must be positive");
+  }
+
+  FeatureCounts counts;
+  std::vector<FeatureCounts> snapshots;
+  std::vector<Image> batch;
+  std::vector<const Image *> batch_images;
+  Image image;
+  size_t num_images = 0;
+  auto next_checkpoint = sorted_checkpoints.begin();
+
+  {
+    SubsystemScope subsystem(Subsystem::kDataset);
+
+    while (DatasetReader::ReadImage(training_stream, image)) {
+      batch.push_back(std::move(image));
+      ++num_images;
+
+      bool is_checkpoint = next_checkpoint != sorted_checkpoints.end() &&
+                           *next_checkpoint == num_images;
+
+      // Batches end at every checkpoint so the snapshot holds exactly the
+      // images before it
+      if (batch.size() == batch_size_ || is_checkpoint) {
+        AddBatch(batch, batch_images, counts);
+      }
+
+      if (is_checkpoint) {
+        snapshots.push_back(counts);
+        ++next_checkpoint;
+      }
+    }
+
+    AddBatch(batch, batch_images, counts);
+  }
+
+  if (num_images > 0 && (snapshots.empty() ||
+                         snapshots.back().GetTotal() != counts.GetTotal())) {
+    snapshots.push_back(counts);
+  }
+
+  std::vector<LogProbTable> tables;
+
+  for (const FeatureCounts &snapshot : snapshots) {
+    tables.push_back(CompileTable(snapshot, laplace));
+  }
+
+  std::vector<const LogProbTable *> table_pointers;
+
+  for (const LogProbTable &table : tables) {
+    table_pointers.push_back(&table);
+  }
+
+  std::vector<ModelEvaluation> evaluations =
+      Evaluate(testing_stream, table_pointers);
+  std::vector<LearningCurvePoint> curve;
+
+  for (size_t point = 0; point < snapshots.size(); ++point) {
+    curve.push_back({snapshots[point].GetTotal(), evaluations[point]});
+  }
+
+  return curve;
+}
+
+void Evaluator::WriteLearningCurve(
+    std::ostream &output, const std::vector<LearningCurvePoint> &curve) {
+  output << "training_images,testing_images,correct,accuracy" << std::endl;
+
+  for (const LearningCurvePoint &point : curve) {
+    output << point.num_training_images << ","
+           << point.evaluation.num_images << ","
+           << point.evaluation.num_correct << "," << point.evaluation.accuracy
+           << std::endl;
+  }
+}
+
+void Evaluator::PrintComparison(std::ostream &output,
+                                const ComparisonReport &report,
+                                const std::vector<std::string> &model_names) {
+  if (report.models.empty()) {
+    output << "No models were compared" << std::endl;
+    return;
+  }
+
+  std::map<char, bool> labels;
+
+  for (const ModelEvaluation &evaluation : report.models) {
+    for (const auto &label_itr : evaluation.confusion_matrix) {
+      labels[label_itr.first] = true;
+    }
+  }
+
+  std::string separator = "  |  ";
+  const ModelEvaluation &baseline = report.models[0];
+
+  output << "-----------Model comparison-----------" << std::endl;
+  output << "Label";
+
+  for (size_t model = 0; model < report.models.size(); ++model) {
+    output << separator << model_names.at(model);
+
+    if (model > 0) {
+      output << separator << "Delta";
+    }
+  }
+
+  output << std::endl;
+
+  for (const auto &label_itr : labels) {
+    char label = label_itr.first;
+    output << label;
+
+    for (size_t model = 0; model < report.models.size(); ++model) {
+      float accuracy = LabelAccuracy(report.models[model], label);
+      output << separator << accuracy;
+
+      if (model > 0) {
+        output << separator << accuracy - LabelAccuracy(baseline, label);
+      }
+    }
+
+    output << std::endl;
+  }
+
+  output << "All";
+
+  for (size_t model = 0; model < report.models.size(); ++model) {
+    output << separator << report.models[model].accuracy;
+
+    if (model > 0) {
+      output << separator
+             << report.models[model].accuracy - baseline.accuracy;
+    }
+  }
+
+  output << std::endl << std::endl;
+  output << "Images predicted differently from " << model_names.at(0) << ":"
+         << std::endl;
+
+  for (size_t model = 1; model < report.models.size(); ++model) {
+    output << model_names.at(model) << separator
+           << report.disagreements[0][model] << std::endl;
+  }
+}
+
+} // namespace naivebayes
@@ -0,0 +1,467 @@
+#include "core/feature_counts.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace naivebayes {
+
+namespace {
+
+/**
+ * Parses and reads the next line of an input to a size_t
+ *
+ * @param input the input stream with the next number
+ * @return the parsed number
+ */
+size_t ReadSizeT(std::istream &input) {
+  std::string line;
+  std::getline(input, line);
+  return std::stoul(line);
+}
+
+// The number of images counted by one word of a bit plane
+const size_t kBitSliceWidth = 64;
+
+static_assert(size_t(Pixel::kPartiallyShaded) == 1 &&
+                  size_t(Pixel::kShaded) == 2,
+              "Bit planes are taken directly from the bits of a shade");
+
+/**
+ * Counts the set bits of every word of a set of bit planes
+ *
+ * @param planes the words to count
+ * @param num_words the number of words
+ * @param plane_counts populated with the number of set bits in each word
+ */
+void CountPlanes(const uint64_t *planes, size_t num_words,
+                 uint32_t *plane_counts) {
+  for (size_t word = 0; word < num_words; ++word) {
+#if defined(__GNUC__) || defined(__clang__)
+    plane_counts[word] = uint32_t(__builtin_popcountll(planes[word]));
+#else
+    uint64_t bits = planes[word];
+    bits -= (bits >> 1) & 0x5555555555555555ull;
+    bits = (bits & 0x3333333333333333ull) +
+           ((bits >> 2) & 0x3333333333333333ull);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    plane_counts[word] = uint32_t((bits * 0x0101010101010101ull) >> 56);
+#endif
+  }
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                               \
+    (defined(__x86_64__) || defined(__i386__))
+#define NAIVEBAYES_POPCNT_DISPATCH 1
+
+/**
+ * Counts the set bits of every word with the popcnt instruction, which
+ * builds without -mpopcnt do not otherwise emit
+ */
+__attribute__((target("popcnt"))) void
+CountPlanesPopcnt(const uint64_t *planes, size_t num_words,
+                  uint32_t *plane_counts) {
+  for (size_t word = 0; word < num_words; ++word) {
+    plane_counts[word] = uint32_t(__builtin_popcountll(planes[word]));
+  }
+}
+#endif
+
+/**
+ * Counts the set bits of every word with the fastest popcount the processor
+ * supports
+ */
+void CountPlanesDispatch(const uint64_t *planes, size_t num_words,
+                         uint32_t *plane_counts) {
+#ifdef NAIVEBAYES_POPCNT_DISPATCH
+  static const bool has_popcnt = __builtin_cpu_supports("popcnt");
+
+  if (has_popcnt) {
+    CountPlanesPopcnt(planes, num_words, plane_counts);
+    return;
+  }
+#endif
+
+  CountPlanes(planes, num_words, plane_counts);
+}
+
+} // namespace
+
+FeatureCounts::FeatureCounts()
+    : image_size_(0), num_shades_(size_t(Pixel::kNumShades)) {}
+
+FeatureCounts::FeatureCounts(size_t image_size, size_t num_shades,
+                             const std::vector<char> &labels)
+    : image_size_(image_size), num_shades_(num_shades) {
+
+  for (char label : labels) {
+    AddLabel(label);
+  }
+}
+
+void FeatureCounts::AddImage(const Image &image) {
+  if (labels_.Empty() && image_size_ == 0) {
+    image_size_ = image.GetSize();
+  }
+
+  if (image.GetSize() != image_size_) {
+    throw std::invalid_argument("Image size does not match the counts");
+  }
+
+  if (!labels_.Contains(image.GetLabel())) {
+    AddLabel(image.GetLabel());
+  }
+
+  size_t label_index = labels_.IndexOf(image.GetLabel());
+
+  for (size_t row = 0; row < image_size_; ++row) {
+    for (size_t col = 0; col < image_size_; ++col) {
+      size_t shade = size_t(image.GetPixelStatusByLocation(row, col));
+
+      if (shade >= num_shades_) {
+        throw std::invalid_argument("Image shade is not part of the counts");
+      }
+
+      ++counts_[CountIndex(row * image_size_ + col, shade, label_index)];
+    }
+  }
+
+  ++label_totals_[label_index];
+}
+
+void FeatureCounts::AddImages(const std::vector<const Image *> &images,
+                              CountingBackend backend) {
+  if (images.empty()) {
+    return;
+  }
+
+  if (labels_.Empty() && image_size_ == 0) {
+    image_size_ = images[0]->GetSize();
+  }
+
+  for (const Image *image : images) {
+    if (image->GetSize() != image_size_) {
+      throw std::invalid_argument("Image size does not match the counts");
+    }
+
+    for (const std::vector<Pixel> &row : image->GetPixels()) {
+      if (row.size() != image_size_) {
+        throw std::invalid_argument("Image data is not square");
+      }
+    }
+  }
+
+  // Bit planes are only kept for the shades every image can have
+  if (backend == CountingBackend::kScalar ||
+      num_shades_ != size_t(Pixel::kNumShades)) {
+    for (const Image *image : images) {
+      AddImage(*image);
+    }
+
+    return;
+  }
+
+  for (const Image *image : images) {
+    AddLabel(image->GetLabel());
+  }
+
+  std::vector<std::vector<const Image *>> label_images(labels_.Size());
+
+  for (const Image *image : images) {
+    label_images[labels_.IndexOf(image->GetLabel())].push_back(image);
+  }
+
+  std::vector<uint64_t> planes;
+  std::vector<uint32_t> plane_counts;
+
+  for (size_t label = 0; label < label_images.size(); ++label) {
+    const std::vector<const Image *> &block_images = label_images[label];
+
+    for (size_t begin = 0; begin < block_images.size();
+         begin += kBitSliceWidth) {
+      AddBitSlicedBlock(block_images.data() + begin,
+                        std::min(kBitSliceWidth, block_images.size() - begin),
+                        label, planes, plane_counts);
+    }
+  }
+}
+
+void FeatureCounts::AddBitSlicedBlock(const Image *const *images,
+                                      size_t num_images, size_t label_index,
+                                      std::vector<uint64_t> &planes,
+                                      std::vector<uint32_t> &plane_counts) {
+  size_t num_pixels = image_size_ * image_size_;
+
+  // Two planes per pixel, for the partially shaded and shaded images
+  planes.assign(2 * num_pixels, 0);
+  plane_counts.resize(planes.size());
+
+  for (size_t image = 0; image < num_images; ++image) {
+    const std::vector<std::vector<Pixel>> &pixels = images[image]->GetPixels();
+    uint64_t *pixel_planes = planes.data();
+
+    // Shades 1 and 2 are the low and high bits of the shade, so each plane
+    // takes one bit of it without comparing
+    for (const std::vector<Pixel> &row : pixels) {
+      for (Pixel pixel : row) {
+        uint64_t shade = uint64_t(pixel);
+        pixel_planes[0] |= (shade & 1) << image;
+        pixel_planes[1] |= (shade >> 1) << image;
+        pixel_planes += 2;
+      }
+    }
+  }
+
+  CountPlanesDispatch(planes.data(), planes.size(), plane_counts.data());
+
+  for (size_t pixel = 0; pixel < num_pixels; ++pixel) {
+    size_t partially_shaded = plane_counts[2 * pixel];
+    size_t shaded = plane_counts[2 * pixel + 1];
+
+    counts_[CountIndex(pixel, size_t(Pixel::kUnshaded), label_index)] +=
+        num_images - partially_shaded - shaded;
+    counts_[CountIndex(pixel, size_t(Pixel::kPartiallyShaded),
+                       label_index)] += partially_shaded;
+    counts_[CountIndex(pixel, size_t(Pixel::kShaded), label_index)] += shaded;
+  }
+
+  label_totals_[label_index] += num_images;
+}
+
+FeatureCounts &FeatureCounts::operator+=(const FeatureCounts &source) {
+  if (source.labels_.Empty()) {
+    return *this;
+  }
+
+  if (labels_.Empty()) {
+    *this = source;
+    return *this;
+  }
+
+  if (image_size_ != source.image_size_ ||
+      num_shades_ != source.num_shades_) {
+    throw std::invalid_argument("Counts dimensions do not match");
+  }
+
+  for (char label : source.labels_.GetLabels()) {
+    if (!labels_.Contains(label)) {
+      AddLabel(label);
+    }
+  }
+
+  size_t num_pixels = image_size_ * image_size_;
+
+  for (size_t source_index = 0; source_index < source.labels_.Size();
+       ++source_index) {
+    size_t label_index = labels_.IndexOf(source.labels_.LabelAt(source_index));
+    label_totals_[label_index] += source.label_totals_[source_index];
+
+    for (size_t pixel = 0; pixel < num_pixels; ++pixel) {
+      for (size_t shade = 0; shade < num_shades_; ++shade) {
+        counts_[CountIndex(pixel, shade, label_index)] +=
+            source.counts_[source.CountIndex(pixel, shade, source_index)];
+      }
+    }
+  }
+
+  return *this;
+}
+
+FeatureCounts &FeatureCounts::operator-=(const FeatureCounts &source) {
+  if (source.labels_.Empty()) {
+    return *this;
+  }
+
+  if (image_size_ != source.image_size_ ||
+      num_shades_ != source.num_shades_) {
+    throw std::invalid_argument("Counts dimensions do not match");
+  }
+
+  size_t num_pixels = image_size_ * image_size_;
+
+  for (size_t source_index = 0; source_index < source.labels_.Size();
+       ++source_index) {
+    char label = source.labels_.LabelAt(source_index);
+
+    if (!labels_.Contains(label) || label_totals_[labels_.IndexOf(label)] <
+                                        source.label_totals_[source_index]) {
+      throw std::invalid_argument("Counts are not a subset of the counts");
+    }
+  }
+
+  for (size_t source_index = 0; source_index < source.labels_.Size();
+       ++source_index) {
+    size_t label_index = labels_.IndexOf(source.labels_.LabelAt(source_index));
+    label_totals_[label_index] -= source.label_totals_[source_index];
+
+    for (size_t pixel = 0; pixel < num_pixels; ++pixel) {
+      for (size_t shade = 0; shade < num_shades_; ++shade) {
+        size_t &count = counts_[CountIndex(pixel, shade, label_index)];
+        size_t source_count =
+            source.counts_[source.CountIndex(pixel, shade, source_index)];
+
+        // Clamp so that inconsistent counts cannot wrap around
+        count = count < source_count ? 0 : count - source_count;
+      }
+    }
+  }
+
+  return *this;
+}
+
+FeatureCounts FeatureCounts::Merge(const std::vector<FeatureCounts> &shards) {
+  FeatureCounts merged;
+
+  for (const FeatureCounts &shard : shards) {
+    merged += shard;
+  }
+
+  return merged;
+}
+
+std::ostream &operator<<(std::ostream &output, const FeatureCounts &counts) {
+  output << counts.image_size_ << std::endl;
+  output << counts.num_shades_ << std::endl;
+  output << counts.labels_.Size() << std::endl;
+
+  for (char label : counts.labels_.GetLabels()) {
+    output << label << std::endl;
+  }
+
+  output << std::endl;
+
+  for (size_t total : counts.label_totals_) {
+    output << total << std::endl;
+  }
+
+  for (size_t count : counts.counts_) {
+    output << count << std::endl;
+  }
+
+  return output;
+}
+
+std::istream &operator>>(std::istream &input, FeatureCounts &counts) {
+  std::string current_line;
+
+  size_t image_size = ReadSizeT(input);
+  size_t num_shades = ReadSizeT(input);
+  size_t num_labels = ReadSizeT(input);
+
+  std::vector<char> labels;
+
+  for (size_t label = 0; label < num_labels; ++label) {
+    std::getline(input, current_line);
+
+    if (current_line.length() != 1) {
+      throw std::invalid_argument("Bad file provided");
+    }
+
+    labels.push_back(current_line[0]);
+  }
+
+  std::getline(input, current_line);
+
+  FeatureCounts loaded(image_size, num_shades, labels);
+
+  if (loaded.labels_.Size() != labels.size()) {
+    throw std::invalid_argument("Bad file provided");
+  }
+
+  // Totals and counts are stored against the labels in file order, which is
+  // sorted for any file written by operator<<
+  for (char label : labels) {
+    loaded.label_totals_[loaded.labels_.IndexOf(label)] = ReadSizeT(input);
+  }
+
+  size_t num_pixels = image_size * image_size;
+
+  for (size_t pixel = 0; pixel < num_pixels; ++pixel) {
+    for (size_t shade = 0; shade < num_shades; ++shade) {
+      for (char label : labels) {
+        loaded.counts_[loaded.CountIndex(pixel, shade,
+                                         loaded.labels_.IndexOf(label))] =
+            ReadSizeT(input);
+      }
+    }
+  }
+
+  counts = loaded;
+  return input;
+}
+
+size_t FeatureCounts::GetCount(char label, size_t row, size_t col,
+                               size_t shade) const {
+  if (row >= image_size_ || col >= image_size_ || shade >= num_shades_) {
+    throw std::out_of_range("Count location is out of range");
+  }
+
+  return counts_[CountIndex(row * image_size_ + col, shade,
+                            labels_.IndexOf(label))];
+}
+
+size_t FeatureCounts::GetLabelTotal(char label) const {
+  return label_totals_[labels_.IndexOf(label)];
+}
+
+size_t FeatureCounts::GetTotal() const {
+  size_t total = 0;
+
+  for (size_t label_total : label_totals_) {
+    total += label_total;
+  }
+
+  return total;
+}
+
+size_t FeatureCounts::GetImageSize() const { return image_size_; }
+
+size_t FeatureCounts::GetNumShades() const { return num_shades_; }
+
+const std::vector<char> &FeatureCounts::GetLabels() const {
+  return labels_.GetLabels();
+}
+
+const LabelSet &FeatureCounts::GetLabelSet() const { return labels_; }
+
+size_t FeatureCounts::GetCountByIndex(size_t label_index, size_t pixel,
+                                      size_t shade) const {
+  return counts_[CountIndex(pixel, shade, label_index)];
+}
+
+size_t FeatureCounts::GetLabelTotalByIndex(size_t label_index) const {
+  return label_totals_[label_index];
+}
+
+void FeatureCounts::AddLabel(char label) {
+  if (labels_.Contains(label)) {
+    return;
+  }
+
+  size_t old_num_labels = labels_.Size();
+  size_t new_index = labels_.Add(label);
+  size_t num_entries = image_size_ * image_size_ * num_shades_;
+
+  // Rebuild the counts with room for the new label in its sorted position
+  std::vector<size_t> resized_counts(num_entries * (old_num_labels + 1), 0);
+
+  for (size_t entry = 0; entry < num_entries; ++entry) {
+    for (size_t label_index = 0; label_index < old_num_labels; ++label_index) {
+      size_t new_label_index =
+          label_index < new_index ? label_index : label_index + 1;
+
+      resized_counts[entry * (old_num_labels + 1) + new_label_index] =
+          counts_[entry * old_num_labels + label_index];
+    }
+  }
+
+  label_totals_.insert(label_totals_.begin() + new_index, 0);
+  counts_.swap(resized_counts);
+}
+
+size_t FeatureCounts::CountIndex(size_t pixel, size_t shade,
+                                 size_t label_index) const {
+  return (pixel * num_shades_ + shade) * labels_.Size() + label_index;
+}
+
+} // namespace naivebayes
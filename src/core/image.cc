@@ -1,5 +1,8 @@
 #include "core/image.h"
 
+#include <core/row_decoder.h>
+#include <utility>
+
 namespace naivebayes {
 Image::Image() : image_label_('\0'), image_size_(0) {}
 
@@ -9,7 +12,13 @@ Image::Image(const Image &source) {
   pixels_ = source.pixels_;
 }
 
-Image::Image(Image &&source) noexcept { *this = std::move(source); }
+Image::Image(Image &&source) noexcept
+    : image_size_(source.image_size_), image_label_(source.image_label_),
+      pixels_(std::move(source.pixels_)) {
+  source.image_size_ = 0;
+  source.image_label_ = 0;
+  source.pixels_.clear();
+}
 
 Image &Image::operator=(const Image &source) {
   image_size_ = source.image_size_;
@@ -20,7 +29,13 @@ Image &Image::operator=(const Image &source) {
 }
 
 Image &Image::operator=(Image &&source) noexcept {
-  *this = source;
+  if (this == &source) {
+    return *this;
+  }
+
+  image_size_ = source.image_size_;
+  image_label_ = source.image_label_;
+  pixels_ = std::move(source.pixels_);
 
   source.image_size_ = 0;
   source.image_label_ = 0;
@@ -36,7 +51,12 @@ Image::~Image() {
 }
 
 Image::Image(size_t image_size, char image_label,
-             const std::vector<std::vector<Pixel>> &pixels) {
+             const std::vector<std::vector<Pixel>> &pixels)
+    : Image(image_size, image_label, std::vector<std::vector<Pixel>>(pixels)) {
+}
+
+Image::Image(size_t image_size, char image_label,
+             std::vector<std::vector<Pixel>> &&pixels) {
   if (!pixels.empty()) {
     if (pixels.size() != pixels[0].size()) {
       throw std::invalid_argument("Pixel vector is not square");
@@ -49,36 +69,37 @@ Image::Image(size_t image_size, char image_label,
 
   image_size_ = pixels.size();
   image_label_ = image_label;
-  pixels_ = pixels;
+  pixels_ = std::move(pixels);
 }
 
 Image::Image(const std::vector<std::string> &raw_ascii_image, char image_label)
     : image_label_(image_label) {
 
-  // Dimensions of the training image is the length of a row in the ascii image
-  image_size_ = raw_ascii_image.at(0).length();
-
   if (raw_ascii_image.empty()) {
     throw std::invalid_argument("No image data to build off of");
-  } else if (raw_ascii_image.size() != image_size_) {
+  }
+
+  // Dimensions of the training image is the length of a row in the ascii image
+  image_size_ = raw_ascii_image[0].length();
+
+  if (raw_ascii_image.size() != image_size_) {
     throw std::invalid_argument("Image data is not square");
   }
 
+  pixels_.reserve(image_size_);
+  std::vector<uint8_t> shades;
+
   for (const std::string &image_line : raw_ascii_image) {
-    std::vector<Pixel> pixel_row;
+    shades.resize(image_line.length());
+    DecodeRow(image_line.data(), image_line.length(), shades.data());
 
-    for (char pixel_char : image_line) {
+    std::vector<Pixel> pixel_row(shades.size());
 
-      if (pixel_char == kShadedChar) {
-        pixel_row.push_back(Pixel::kShaded);
-      } else if (pixel_char == kPartiallyShadedChar) {
-        pixel_row.push_back(Pixel::kPartiallyShaded);
-      } else {
-        pixel_row.push_back(Pixel::kUnshaded);
-      }
+    for (size_t col = 0; col < shades.size(); ++col) {
+      pixel_row[col] = Pixel(shades[col]);
     }
 
-    pixels_.push_back(pixel_row);
+    pixels_.push_back(std::move(pixel_row));
   }
 }
 
@@ -108,6 +129,8 @@ char Image::GetLabel() const { return image_label_; }
 
 size_t Image::GetSize() const { return image_size_; }
 
-std::vector<std::vector<Pixel>> Image::GetPixels() const { return pixels_; }
+const std::vector<std::vector<Pixel>> &Image::GetPixels() const {
+  return pixels_;
+}
 
 } // namespace naivebayes
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "core/label_set.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace naivebayes {
+
+namespace {
+
+/**
+ * Converts a label to its position in the lookup table, regardless of whether
+ * char is signed
+ *
+ * @param label the label to convert
+ * @return the position of the label in the lookup table
+ */
+size_t LookupPosition(char label) { return size_t((unsigned char)label); }
+
+} // namespace
+
+const size_t LabelSet::kNoIndex;
+
+LabelSet::LabelSet() { BuildIndex(); }
+
+LabelSet::LabelSet(const std::vector<char> &labels) : labels_(labels) {
+  std::sort(labels_.begin(), labels_.end());
+  labels_.erase(std::unique(labels_.begin(), labels_.end()), labels_.end());
+  BuildIndex();
+}
+
+size_t LabelSet::Add(char label) {
+  if (!Contains(label)) {
+    labels_.insert(std::lower_bound(labels_.begin(), labels_.end(), label),
+                   label);
+    BuildIndex();
+  }
+
+  return IndexOf(label);
+}
+
+bool LabelSet::Contains(char label) const {
+  return indices_[LookupPosition(label)] != kNoIndex;
+}
+
+size_t LabelSet::IndexOf(char label) const {
+  size_t index = indices_[LookupPosition(label)];
+
+  if (index == kNoIndex) {
+    throw std::out_of_range("Label is not part of the label set");
+  }
+
+  return index;
+}
+
+char LabelSet::LabelAt(size_t index) const { return labels_.at(index); }
+
+size_t LabelSet::Size() const { return labels_.size(); }
+
+bool LabelSet::Empty() const { return labels_.empty(); }
+
+const std::vector<char> &LabelSet::GetLabels() const { return labels_; }
+
+bool LabelSet::operator==(const LabelSet &other) const {
+  return labels_ == other.labels_;
+}
+
+void LabelSet::BuildIndex() {
+  indices_.fill(kNoIndex);
+
+  for (size_t index = 0; index < labels_.size(); ++index) {
+    indices_[LookupPosition(labels_[index])] = index;
+  }
+}
+
+} // namespace naivebayes
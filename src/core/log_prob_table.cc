@@ -0,0 +1,317 @@
+#include "core/log_prob_table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace naivebayes {
+
+LogProbTable::LogProbTable()
+    : image_size_(0), num_shades_(0), bound_tolerance_(0.0) {}
+
+LogProbTable::LogProbTable(const Trainer &trainer)
+    : image_size_(trainer.GetImageSize()), num_shades_(0),
+      labels_(trainer.GetLabelSet()), bound_tolerance_(0.0) {
+
+  for (float prior : trainer.GetPriors()) {
+    log_priors_.push_back(std::log(prior));
+  }
+
+  const FeatureVector &features = trainer.GetFeatures();
+
+  for (size_t row = 0; row < features.size(); ++row) {
+    for (size_t col = 0; col < features[row].size(); ++col) {
+      num_shades_ = features[row][col].size();
+
+      for (size_t pixel = 0; pixel < features[row][col].size(); ++pixel) {
+        for (float feature : features[row][col][pixel]) {
+          log_features_.push_back(std::log(feature));
+        }
+      }
+    }
+  }
+
+  BuildBounds();
+}
+
+LogProbTable::LogProbTable(const EmbeddedModel &model)
+    : image_size_(model.image_size), num_shades_(model.num_shades),
+      bound_tolerance_(0.0) {
+
+  if (model.num_labels == 0 || model.labels == nullptr ||
+      model.log_priors == nullptr || model.log_features == nullptr) {
+    throw std::invalid_argument("Embedded model is missing its tables");
+  }
+
+  std::vector<char> labels(model.labels, model.labels + model.num_labels);
+  labels_ = LabelSet(labels);
+
+  // The tables are indexed by label, so the labels must already be in order
+  if (labels_.GetLabels() != labels) {
+    throw std::invalid_argument("Embedded model labels are not sorted");
+  }
+
+  log_priors_.assign(model.log_priors, model.log_priors + model.num_labels);
+  log_features_.assign(model.log_features,
+                       model.log_features + image_size_ * image_size_ *
+                                                num_shades_ *
+                                                model.num_labels);
+
+  BuildBounds();
+}
+
+void LogProbTable::BuildBounds() {
+  size_t num_labels = labels_.Size();
+  remaining_bounds_.assign((image_size_ + 1) * num_labels, 0.0);
+
+  // Built from the last row up, so each row adds to the bound of the next
+  for (size_t row = image_size_; row-- > 0;) {
+    for (size_t label = 0; label < num_labels; ++label) {
+      double row_bound = 0.0;
+
+      for (size_t col = 0; col < image_size_; ++col) {
+        const float *pixel_features =
+            log_features_.data() +
+            (row * image_size_ + col) * num_shades_ * num_labels;
+        float max_feature = -std::numeric_limits<float>::infinity();
+
+        for (size_t shade = 0; shade < num_shades_; ++shade) {
+          max_feature =
+              std::max(max_feature, pixel_features[shade * num_labels + label]);
+        }
+
+        row_bound += max_feature;
+      }
+
+      remaining_bounds_[row * num_labels + label] =
+          row_bound + remaining_bounds_[(row + 1) * num_labels + label];
+    }
+  }
+
+  // Summing n floats is off by at most n epsilon times the sum of magnitudes
+  bound_tolerance_ = double(std::numeric_limits<float>::epsilon()) *
+                     double(image_size_ * image_size_ + image_size_ + 2);
+}
+
+void LogProbTable::Score(const Image &image, std::vector<float> &scores) const {
+  if (image.GetSize() != image_size_) {
+    throw std::invalid_argument("Image size does not match the model");
+  }
+
+  ScorePixels(
+      [&image](size_t row, size_t col) {
+        return image.GetPixelStatusByLocation(row, col);
+      },
+      scores);
+}
+
+void LogProbTable::Score(const std::vector<std::vector<Pixel>> &pixel_grid,
+                         std::vector<float> &scores) const {
+  if (pixel_grid.size() != image_size_) {
+    throw std::invalid_argument("Image size does not match the model");
+  }
+
+  for (const std::vector<Pixel> &row : pixel_grid) {
+    if (row.size() != image_size_) {
+      throw std::invalid_argument("Pixel vector is not square");
+    }
+  }
+
+  ScorePixels(
+      [&pixel_grid](size_t row, size_t col) { return pixel_grid[row][col]; },
+      scores);
+}
+
+void LogProbTable::Score(const uint8_t *pixels, size_t row_stride,
+                         std::vector<float> &scores) const {
+  ScorePixels(
+      [pixels, row_stride](size_t row, size_t col) {
+        return pixels[row * row_stride + col];
+      },
+      scores);
+}
+
+template <typename PixelAt>
+void LogProbTable::ScorePixels(PixelAt pixel_at,
+                               std::vector<float> &scores) const {
+  scores.assign(log_priors_.begin(), log_priors_.end());
+
+  size_t num_labels = labels_.Size();
+  const float *label_features = log_features_.data();
+
+  for (size_t row = 0; row < image_size_; ++row) {
+    for (size_t col = 0; col < image_size_; ++col) {
+      size_t pixel = size_t(pixel_at(row, col));
+
+      if (pixel >= num_shades_) {
+        throw std::invalid_argument("Image shade is not part of the model");
+      }
+
+      const float *pixel_features = label_features + pixel * num_labels;
+
+      for (size_t label = 0; label < num_labels; ++label) {
+        scores[label] += pixel_features[label];
+      }
+
+      label_features += num_shades_ * num_labels;
+    }
+  }
+}
+
+char LogProbTable::Classify(const Image &image) const {
+  return labels_.LabelAt(ClassifyIndex(image));
+}
+
+size_t LogProbTable::ClassifyIndex(const Image &image) const {
+  // Reused by every call on the thread so that classifying does not allocate
+  thread_local std::vector<float> scores;
+  Score(image, scores);
+
+  return ArgMax(scores);
+}
+
+size_t
+LogProbTable::ClassifyIndex(const std::vector<std::vector<Pixel>> &pixel_grid,
+                            std::vector<float> &scores) const {
+  Score(pixel_grid, scores);
+
+  return ArgMax(scores);
+}
+
+size_t LogProbTable::ClassifyIndex(const uint8_t *pixels, size_t row_stride,
+                                   std::vector<float> &scores) const {
+  Score(pixels, row_stride, scores);
+
+  return ArgMax(scores);
+}
+
+size_t LogProbTable::ArgMax(const std::vector<float> &scores) const {
+  size_t prediction = 0;
+  float max_likelihood = -std::numeric_limits<float>::infinity();
+
+  for (size_t label = 0; label < scores.size(); ++label) {
+    if (scores[label] > max_likelihood) {
+      max_likelihood = scores[label];
+      prediction = label;
+    }
+  }
+
+  return prediction;
+}
+
+char LogProbTable::ClassifyEarlyExit(const Image &image,
+                                     EarlyExitStats *stats) const {
+  if (image.GetSize() != image_size_) {
+    throw std::invalid_argument("Image size does not match the model");
+  }
+
+  // Reused by every call on the thread so that the fast path does not
+  // allocate
+  thread_local std::vector<size_t> shades;
+  thread_local std::vector<float> scores;
+  shades.resize(image_size_ * image_size_);
+
+  for (size_t row = 0; row < image_size_; ++row) {
+    for (size_t col = 0; col < image_size_; ++col) {
+      size_t pixel = size_t(image.GetPixelStatusByLocation(row, col));
+
+      if (pixel >= num_shades_) {
+        throw std::invalid_argument("Image shade is not part of the model");
+      }
+
+      shades[row * image_size_ + col] = pixel;
+    }
+  }
+
+  size_t num_labels = labels_.Size();
+  size_t rows_scored = 0;
+  scores.assign(log_priors_.begin(), log_priors_.end());
+  size_t leader = 0;
+
+  // Every label is scored on the first row to pick the likely winner
+  for (size_t label = 0; label < num_labels && image_size_ > 0; ++label) {
+    scores[label] = AddRow(shades, 0, label, scores[label]);
+    ++rows_scored;
+
+    if (scores[label] > scores[leader]) {
+      leader = label;
+    }
+  }
+
+  for (size_t row = 1; row < image_size_; ++row) {
+    scores[leader] = AddRow(shades, row, leader, scores[leader]);
+    ++rows_scored;
+  }
+
+  for (size_t label = 0; label < num_labels; ++label) {
+    if (label == leader) {
+      continue;
+    }
+
+    bool is_pruned = false;
+
+    for (size_t row = 1; row < image_size_ && !is_pruned; ++row) {
+      double partial = scores[label];
+      double bound = remaining_bounds_[row * num_labels + label];
+      double tolerance =
+          bound_tolerance_ * (std::fabs(partial) + std::fabs(bound) +
+                              std::fabs(double(scores[leader])));
+
+      // Strictly below the leader even with the tolerance, so not even a tie
+      if (partial + bound + tolerance < double(scores[leader])) {
+        is_pruned = true;
+      } else {
+        scores[label] = AddRow(shades, row, label, scores[label]);
+        ++rows_scored;
+      }
+    }
+
+    // Ties go to the first label, the same as Classify
+    if (!is_pruned && (scores[label] > scores[leader] ||
+                       (scores[label] == scores[leader] && label < leader))) {
+      leader = label;
+    }
+  }
+
+  if (stats != nullptr) {
+    ++stats->num_images;
+    stats->features_scored += rows_scored * image_size_;
+    stats->features_total += num_labels * image_size_ * image_size_;
+  }
+
+  return labels_.LabelAt(leader);
+}
+
+float LogProbTable::AddRow(const std::vector<size_t> &shades, size_t row,
+                           size_t label, float score) const {
+  size_t num_labels = labels_.Size();
+
+  for (size_t col = 0; col < image_size_; ++col) {
+    size_t pixel = row * image_size_ + col;
+    score += log_features_[(pixel * num_shades_ + shades[pixel]) * num_labels +
+                           label];
+  }
+
+  return score;
+}
+
+const std::vector<char> &LogProbTable::GetLabels() const {
+  return labels_.GetLabels();
+}
+
+const LabelSet &LogProbTable::GetLabelSet() const { return labels_; }
+
+size_t LogProbTable::GetImageSize() const { return image_size_; }
+
+size_t LogProbTable::GetNumShades() const { return num_shades_; }
+
+const std::vector<float> &LogProbTable::GetLogPriors() const {
+  return log_priors_;
+}
+
+const std::vector<float> &LogProbTable::GetLogFeatures() const {
+  return log_features_;
+}
+
+} // namespace naivebayes
@@ -0,0 +1,177 @@
+#include "core/memory_accounting.h"
+
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+namespace naivebayes {
+
+namespace {
+
+const size_t kNumSubsystems = size_t(Subsystem::kNumSubsystems);
+
+/**
+ * The live counters of one subsystem. Constant initialized, so allocations
+ * made before main are counted safely
+ */
+struct SubsystemCounters {
+  std::atomic<uint64_t> allocations;
+  std::atomic<uint64_t> deallocations;
+  std::atomic<uint64_t> bytes_allocated;
+  std::atomic<int64_t> live_bytes;
+  std::atomic<int64_t> peak_live_bytes;
+};
+
+/**
+ * Gets the counters of every subsystem. The array has no constructor to run,
+ * so it is zeroed before any allocation and needs no initialization guard
+ *
+ * @return the counters, indexed by subsystem
+ */
+SubsystemCounters *GetSubsystemCounters() {
+  static SubsystemCounters subsystem_counters[kNumSubsystems];
+  return subsystem_counters;
+}
+
+std::atomic<bool> hooks_installed(false);
+
+} // namespace
+
+thread_local Subsystem AllocationTracker::current_subsystem_ =
+    Subsystem::kOther;
+
+void AllocationTracker::RecordAllocation(Subsystem subsystem, size_t bytes) {
+  SubsystemCounters &counter = GetSubsystemCounters()[size_t(subsystem)];
+
+  counter.allocations.fetch_add(1, std::memory_order_relaxed);
+  counter.bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+
+  int64_t live_bytes =
+      counter.live_bytes.fetch_add(int64_t(bytes), std::memory_order_relaxed) +
+      int64_t(bytes);
+  int64_t peak = counter.peak_live_bytes.load(std::memory_order_relaxed);
+
+  // Retried until the peak is raised or another thread raised it further
+  while (live_bytes > peak &&
+         !counter.peak_live_bytes.compare_exchange_weak(
+             peak, live_bytes, std::memory_order_relaxed)) {
+  }
+}
+
+void AllocationTracker::RecordDeallocation(Subsystem subsystem, size_t bytes) {
+  SubsystemCounters &counter = GetSubsystemCounters()[size_t(subsystem)];
+
+  counter.deallocations.fetch_add(1, std::memory_order_relaxed);
+  counter.live_bytes.fetch_sub(int64_t(bytes), std::memory_order_relaxed);
+}
+
+Subsystem AllocationTracker::GetCurrentSubsystem() {
+  return current_subsystem_;
+}
+
+AllocationTracker::Snapshot AllocationTracker::GetSnapshot() {
+  Snapshot snapshot;
+
+  for (size_t subsystem = 0; subsystem < kNumSubsystems; ++subsystem) {
+    const SubsystemCounters &counter = GetSubsystemCounters()[subsystem];
+
+    snapshot[subsystem] = {counter.allocations.load(),
+                           counter.deallocations.load(),
+                           counter.bytes_allocated.load(),
+                           counter.live_bytes.load(),
+                           counter.peak_live_bytes.load()};
+  }
+
+  return snapshot;
+}
+
+void AllocationTracker::MarkHooksInstalled() { hooks_installed = true; }
+
+bool AllocationTracker::AreHooksInstalled() { return hooks_installed; }
+
+uint64_t AllocationTracker::GetPeakRss() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS memory_counters;
+
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &memory_counters,
+                           sizeof(memory_counters))) {
+    return uint64_t(memory_counters.PeakWorkingSetSize);
+  }
+
+  return 0;
+#else
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+
+#ifdef __APPLE__
+  return uint64_t(usage.ru_maxrss);
+#else
+  // Linux reports kilobytes
+  return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+void AllocationTracker::PrintReport(std::ostream &output) {
+  output << "-----------Memory by subsystem-----------" << std::endl;
+
+  if (!AreHooksInstalled()) {
+    output << "Allocation tracking is off. Build with "
+              "NAIVEBAYES_TRACK_ALLOCATIONS to enable it"
+           << std::endl;
+  } else {
+    output << "Subsystem  |  Allocations  |  Bytes allocated  |  Live bytes  "
+              "|  Peak live bytes"
+           << std::endl;
+
+    Snapshot snapshot = GetSnapshot();
+    std::string separator = "  |  ";
+
+    for (size_t subsystem = 0; subsystem < kNumSubsystems; ++subsystem) {
+      const SubsystemAllocations &usage = snapshot[subsystem];
+
+      output << GetSubsystemName(Subsystem(subsystem)) << separator
+             << usage.allocations << separator << usage.bytes_allocated
+             << separator << usage.live_bytes << separator
+             << usage.peak_live_bytes << std::endl;
+    }
+  }
+
+  output << "Peak RSS: " << GetPeakRss() << " bytes" << std::endl;
+}
+
+const char *AllocationTracker::GetSubsystemName(Subsystem subsystem) {
+  switch (subsystem) {
+  case Subsystem::kDataset:
+    return "dataset";
+  case Subsystem::kTrainer:
+    return "trainer";
+  case Subsystem::kModel:
+    return "model";
+  case Subsystem::kEvaluator:
+    return "evaluator";
+  default:
+    return "other";
+  }
+}
+
+SubsystemScope::SubsystemScope(Subsystem subsystem)
+    : previous_subsystem_(AllocationTracker::current_subsystem_) {
+  AllocationTracker::current_subsystem_ = subsystem;
+}
+
+SubsystemScope::~SubsystemScope() {
+  AllocationTracker::current_subsystem_ = previous_subsystem_;
+}
+
+} // namespace naivebayes
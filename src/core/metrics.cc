@@ -0,0 +1,261 @@
+#include "core/metrics.h"
+
+namespace naivebayes {
+
+namespace {
+
+/**
+ * The quantiles every histogram is exported with, along with the suffix of
+ * their JSON names
+ */
+const std::pair<double, const char *> kExportedQuantiles[] = {
+    {0.5, "p50"}, {0.99, "p99"}, {0.999, "p999"}};
+
+/**
+ * Finds the position of the highest set bit of a value
+ *
+ * @param value a value greater than 0
+ * @return the base 2 logarithm of the value, rounded down
+ */
+size_t HighestBit(uint64_t value) {
+  size_t bit = 0;
+
+  while (value >>= 1) {
+    ++bit;
+  }
+
+  return bit;
+}
+
+} // namespace
+
+const size_t Histogram::kSubBuckets;
+const size_t Histogram::kNumBuckets;
+
+Counter::Counter() : value_(0) {}
+
+void Counter::Increment(uint64_t amount) {
+  value_.fetch_add(amount, std::memory_order_relaxed);
+}
+
+uint64_t Counter::Get() const { return value_.load(std::memory_order_relaxed); }
+
+Gauge::Gauge() : value_(0) {}
+
+void Gauge::Set(int64_t value) {
+  value_.store(value, std::memory_order_relaxed);
+}
+
+void Gauge::Add(int64_t amount) {
+  value_.fetch_add(amount, std::memory_order_relaxed);
+}
+
+int64_t Gauge::Get() const { return value_.load(std::memory_order_relaxed); }
+
+Histogram::Histogram() : count_(0), sum_(0) {
+  for (std::atomic<uint64_t> &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Histogram::Record(uint64_t value) {
+  buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::Quantile(double quantile) const {
+  uint64_t count = 0;
+  std::array<uint64_t, kNumBuckets> buckets;
+
+  // Buckets are read once so that a concurrent Record cannot skew the walk
+  for (size_t index = 0; index < kNumBuckets; ++index) {
+    buckets[index] = buckets_[index].load(std::memory_order_relaxed);
+    count += buckets[index];
+  }
+
+  if (count == 0) {
+    return 0;
+  }
+
+  uint64_t rank = uint64_t(quantile * double(count - 1)) + 1;
+  uint64_t seen = 0;
+
+  for (size_t index = 0; index < kNumBuckets; ++index) {
+    seen += buckets[index];
+
+    if (seen >= rank) {
+      return BucketUpperBound(index);
+    }
+  }
+
+  return BucketUpperBound(kNumBuckets - 1);
+}
+
+uint64_t Histogram::GetCount() const {
+  return count_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetSum() const {
+  return sum_.load(std::memory_order_relaxed);
+}
+
+size_t Histogram::BucketIndex(uint64_t value) {
+  if (value < kSubBuckets) {
+    return size_t(value);
+  }
+
+  // Values from 2^octave up to 2^(octave + 1) share kSubBuckets buckets
+  size_t sub_bucket_bits = HighestBit(kSubBuckets);
+  size_t octave = HighestBit(value) - sub_bucket_bits;
+  size_t sub_bucket = size_t(value >> octave) - kSubBuckets;
+
+  return kSubBuckets + octave * kSubBuckets + sub_bucket;
+}
+
+uint64_t Histogram::BucketUpperBound(size_t index) {
+  if (index < kSubBuckets) {
+    return uint64_t(index);
+  }
+
+  size_t octave = (index - kSubBuckets) / kSubBuckets;
+  uint64_t sub_bucket = (index - kSubBuckets) % kSubBuckets;
+
+  return ((kSubBuckets + sub_bucket + 1) << octave) - 1;
+}
+
+MetricsRegistry &MetricsRegistry::Global() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+Counter &MetricsRegistry::GetCounter(const std::string &name,
+                                     const std::string &help) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<Counter> &counter = counters_[name];
+
+  if (!counter) {
+    counter.reset(new Counter());
+    help_[name] = help;
+  }
+
+  return *counter;
+}
+
+Gauge &MetricsRegistry::GetGauge(const std::string &name,
+                                 const std::string &help) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<Gauge> &gauge = gauges_[name];
+
+  if (!gauge) {
+    gauge.reset(new Gauge());
+    help_[name] = help;
+  }
+
+  return *gauge;
+}
+
+Histogram &MetricsRegistry::GetHistogram(const std::string &name,
+                                         const std::string &help) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<Histogram> &histogram = histograms_[name];
+
+  if (!histogram) {
+    histogram.reset(new Histogram());
+    help_[name] = help;
+  }
+
+  return *histogram;
+}
+
+void MetricsRegistry::Export(std::ostream &output,
+                             MetricsFormat format) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (format == MetricsFormat::kPrometheus) {
+    for (const auto &counter_itr : counters_) {
+      output << "# HELP " << counter_itr.first << " "
+             << help_.at(counter_itr.first) << std::endl;
+      output << "# TYPE " << counter_itr.first << " counter" << std::endl;
+      output << counter_itr.first << " " << counter_itr.second->Get()
+             << std::endl;
+    }
+
+    for (const auto &gauge_itr : gauges_) {
+      output << "# HELP " << gauge_itr.first << " "
+             << help_.at(gauge_itr.first) << std::endl;
+      output << "# TYPE " << gauge_itr.first << " gauge" << std::endl;
+      output << gauge_itr.first << " " << gauge_itr.second->Get() << std::endl;
+    }
+
+    // Histograms are exported as summaries of their quantiles
+    for (const auto &histogram_itr : histograms_) {
+      const std::string &name = histogram_itr.first;
+      const Histogram &histogram = *histogram_itr.second;
+
+      output << "# HELP " << name << " " << help_.at(name) << std::endl;
+      output << "# TYPE " << name << " summary" << std::endl;
+
+      for (const auto &quantile : kExportedQuantiles) {
+        output << name << "{quantile=\"" << quantile.first << "\"} "
+               << histogram.Quantile(quantile.first) << std::endl;
+      }
+
+      output << name << "_sum " << histogram.GetSum() << std::endl;
+      output << name << "_count " << histogram.GetCount() << std::endl;
+    }
+
+    return;
+  }
+
+  std::string separator;
+
+  output << "{\"counters\": {";
+
+  for (const auto &counter_itr : counters_) {
+    output << separator << "\"" << counter_itr.first
+           << "\": " << counter_itr.second->Get();
+    separator = ", ";
+  }
+
+  output << "}, \"gauges\": {";
+  separator = "";
+
+  for (const auto &gauge_itr : gauges_) {
+    output << separator << "\"" << gauge_itr.first
+           << "\": " << gauge_itr.second->Get();
+    separator = ", ";
+  }
+
+  output << "}, \"histograms\": {";
+  separator = "";
+
+  for (const auto &histogram_itr : histograms_) {
+    const Histogram &histogram = *histogram_itr.second;
+
+    output << separator << "\"" << histogram_itr.first
+           << "\": {\"count\": " << histogram.GetCount()
+           << ", \"sum\": " << histogram.GetSum();
+
+    for (const auto &quantile : kExportedQuantiles) {
+      output << ", \"" << quantile.second
+             << "\": " << histogram.Quantile(quantile.first);
+    }
+
+    output << "}";
+    separator = ", ";
+  }
+
+  output << "}}" << std::endl;
+}
+
+ScopedTimer::ScopedTimer(Histogram &histogram)
+    : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+ScopedTimer::~ScopedTimer() {
+  auto elapsed = std::chrono::steady_clock::now() - start_;
+  histogram_.Record(uint64_t(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+} // namespace naivebayes
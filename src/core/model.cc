@@ -1,29 +1,111 @@
 #include "iostream"
+#include <array>
+#include <cmath>
+#include <core/log_prob_table.h>
+#include <core/memory_accounting.h>
+#include <core/metrics.h>
 #include <core/model.h>
+#include <core/parallel.h>
+#include <core/tracer.h>
+#include <atomic>
 #include <fstream>
 
 namespace naivebayes {
 
+namespace {
+
+/**
+ * Hands out model versions that are unique across every Model in the process
+ *
+ * @return a version that has never been returned before
+ */
+uint64_t NextModelVersion() {
+  static std::atomic<uint64_t> next_version(1);
+  return next_version++;
+}
+
+/**
+ * The metrics every Model reports to the global registry
+ */
+struct ModelMetrics {
+  Counter &images_parsed;
+  Counter &images_trained;
+  Counter &predictions;
+  Counter &images_evaluated;
+  Gauge &model_labels;
+  Histogram &train_duration;
+  Histogram &load_duration;
+  Histogram &save_duration;
+  Histogram &predict_latency;
+  Histogram &evaluate_duration;
+};
+
+/**
+ * Gets the metrics of every Model, registering them on first use
+ *
+ * @return the metrics in the global registry
+ */
+ModelMetrics &GetModelMetrics() {
+  MetricsRegistry &registry = MetricsRegistry::Global();
+
+  static ModelMetrics metrics = {
+      registry.GetCounter("naivebayes_images_parsed_total",
+                          "Images decoded from dataset files"),
+      registry.GetCounter("naivebayes_images_trained_total",
+                          "Images counted into trained models"),
+      registry.GetCounter("naivebayes_predictions_total",
+                          "Predictions served by Model::Predict"),
+      registry.GetCounter("naivebayes_images_evaluated_total",
+                          "Testing images scored for accuracy"),
+      registry.GetGauge("naivebayes_model_labels",
+                        "Labels of the most recently trained or loaded model"),
+      registry.GetHistogram("naivebayes_train_duration_ns",
+                            "Time to compile counts into a model"),
+      registry.GetHistogram("naivebayes_load_duration_ns",
+                            "Time to load a saved model"),
+      registry.GetHistogram("naivebayes_save_duration_ns",
+                            "Time to serialize a model"),
+      registry.GetHistogram("naivebayes_predict_latency_ns",
+                            "Latency of a single Model::Predict"),
+      registry.GetHistogram("naivebayes_evaluate_duration_ns",
+                            "Time to score a testing dataset")};
+
+  return metrics;
+}
+
+} // namespace
+
 Model::Model() {
   model_trainer_ = nullptr;
-  label_image_map_ = std::map<char, std::vector<Image *>>();
   total_num_images_ = 0;
+  prediction_cache_ = nullptr;
+  version_ = 0;
 }
 
 Model::Model(const Model &source) {
   model_trainer_ = nullptr;
+  prediction_cache_ = nullptr;
   *this = source;
 }
 
 Model::Model(Model &&source) noexcept {
 
-  label_image_map_ = std::move(source.label_image_map_);
+  labels_ = std::move(source.labels_);
+  label_images_ = std::move(source.label_images_);
   model_trainer_ = source.model_trainer_;
+  prediction_table_ = std::move(source.prediction_table_);
   total_num_images_ = source.total_num_images_;
+  prediction_cache_ = source.prediction_cache_;
+  version_ = source.version_;
+  confusion_matrix_ = std::move(source.confusion_matrix_);
 
-  source.label_image_map_.clear();
+  source.labels_ = LabelSet();
+  source.label_images_.clear();
   source.model_trainer_ = nullptr;
   source.total_num_images_ = 0;
+  source.prediction_cache_ = nullptr;
+  source.version_ = 0;
+  source.confusion_matrix_.clear();
 }
 
 Model &Model::operator=(const Model &source) {
@@ -31,61 +113,121 @@ Model &Model::operator=(const Model &source) {
   if (this != &source) {
     ClearModel();
 
-    label_image_map_ = std::map<char, std::vector<Image *>>();
-    model_trainer_ = nullptr;
-
-    for (const auto &itr : source.label_image_map_) {
-      std::vector<Image *> images = itr.second;
+    labels_ = source.labels_;
+    label_images_.assign(labels_.Size(), std::vector<Image *>{});
 
-      for (Image *image : images) {
-
-        Image *new_image = new Image(*image);
-        label_image_map_[new_image->GetLabel()].push_back(new_image);
+    for (size_t label = 0; label < source.label_images_.size(); ++label) {
+      for (Image *image : source.label_images_[label]) {
+        label_images_[label].push_back(new Image(*image));
       }
     }
 
-    model_trainer_ = source.model_trainer_;
+    // Each model owns its trainer, so the copy gets a trainer of its own
+    if (source.model_trainer_ != nullptr) {
+      model_trainer_ = new Trainer(*source.model_trainer_);
+    }
+
+    prediction_table_ = source.prediction_table_;
     total_num_images_ = source.total_num_images_;
+    version_ = source.version_;
+    confusion_matrix_ = source.confusion_matrix_;
+
+    // Copies start with an empty cache of their own
+    delete prediction_cache_;
+    prediction_cache_ = nullptr;
+
+    if (source.prediction_cache_ != nullptr) {
+      EnablePredictionCache(source.prediction_cache_->GetCapacity());
+    }
   }
 
   return *this;
 }
 
 Model &Model::operator=(Model &&source) noexcept {
+  if (this == &source) {
+    return *this;
+  }
+
   ClearModel();
 
-  label_image_map_ = std::move(source.label_image_map_);
+  labels_ = std::move(source.labels_);
+  label_images_ = std::move(source.label_images_);
   model_trainer_ = source.model_trainer_;
+  prediction_table_ = std::move(source.prediction_table_);
   total_num_images_ = source.total_num_images_;
 
-  source.label_image_map_.clear();
+  delete prediction_cache_;
+  prediction_cache_ = source.prediction_cache_;
+  version_ = source.version_;
+  confusion_matrix_ = std::move(source.confusion_matrix_);
+
+  source.labels_ = LabelSet();
+  source.label_images_.clear();
+  source.model_trainer_ = nullptr;
+  source.total_num_images_ = 0;
+  source.prediction_cache_ = nullptr;
+  source.version_ = 0;
+  source.confusion_matrix_.clear();
 
   return *this;
 }
 
-Model::~Model() { ClearModel(); }
+Model::~Model() {
+  ClearModel();
+  delete prediction_cache_;
+}
 
 Trainer *Model::GetTrainer() const { return model_trainer_; }
 
-void Model::Train() {
-  if (label_image_map_.empty()) {
-    throw std::exception("No training images to train the model on");
+void Model::Train(CountingBackend backend) {
+  if (label_images_.empty()) {
+    throw std::invalid_argument("No training images to train the model on");
   }
 
-  std::cout << "Training Model................" << std::endl;
+  // The overload that compiles the counts records the Train span
+  SubsystemScope subsystem(Subsystem::kModel);
+  Train(CountFeatures(backend));
+}
 
-  // Access the first training image's size
-  size_t image_size = label_image_map_.begin()->second.at(0)->GetSize();
+void Model::Train(const FeatureCounts &counts, float laplace) {
+  if (counts.GetTotal() == 0) {
+    throw std::invalid_argument("No training images to train the model on");
+  }
 
-  std::vector<char> labels = GetLabels();
+  std::cout << "Training Model................" << std::endl;
+  ModelMetrics &metrics = GetModelMetrics();
+  ScopedTimer timer(metrics.train_duration);
+  TraceScope trace("model", "Train");
+  SubsystemScope subsystem(Subsystem::kModel);
 
-  model_trainer_ = new Trainer(image_size, size_t(Pixel::kNumShades), labels);
-  model_trainer_->CalculateFeatures(label_image_map_);
-  model_trainer_->CalculatePriors(label_image_map_, total_num_images_);
+  delete model_trainer_;
+  model_trainer_ = new Trainer(counts.GetImageSize(),
+                               size_t(Pixel::kNumShades), counts.GetLabels(),
+                               laplace);
+  model_trainer_->CalculateFeatures(counts);
+  model_trainer_->CalculatePriors(counts);
+  UpdateVersion();
+
+  metrics.images_trained.Increment(counts.GetTotal());
+  metrics.model_labels.Set(int64_t(counts.GetLabelSet().Size()));
 
   std::cout << "Finished Training................" << std::endl;
 }
 
+FeatureCounts Model::CountFeatures(CountingBackend backend) const {
+  TraceScope trace("model", "CountFeatures");
+  SubsystemScope subsystem(Subsystem::kModel);
+  FeatureCounts counts;
+
+  for (const std::vector<Image *> &images : label_images_) {
+    counts.AddImages(std::vector<const Image *>(images.begin(), images.end()),
+                     backend);
+  }
+
+  return counts;
+}
+
 char Model::Predict(const std::vector<std::string> &ascii_image) {
   Image predict_image(ascii_image, 0);
 
@@ -93,35 +235,50 @@ char Model::Predict(const std::vector<std::string> &ascii_image) {
 }
 
 char Model::Predict(const std::vector<std::vector<Pixel>> &pixel_grid) {
-  Image predict_image(pixel_grid.size(), 0, pixel_grid);
+  ModelMetrics &metrics = GetModelMetrics();
+  ScopedTimer timer(metrics.predict_latency);
+  SubsystemScope subsystem(Subsystem::kModel);
+  metrics.predictions.Increment();
 
-  float max_likelihood = INT_MIN;
-  char prediction;
-  std::vector<char> labels = GetLabels();
+  char cached_prediction;
 
-  for (char label : labels) {
-    float likelihood = CalculateLikelihood(label, predict_image);
-    if (likelihood > max_likelihood) {
-      max_likelihood = likelihood;
-      prediction = label;
-    }
+  if (prediction_cache_ != nullptr &&
+      prediction_cache_->Lookup(version_, pixel_grid, cached_prediction)) {
+    return cached_prediction;
+  }
+
+  // Reused by every prediction on the thread so that predicting allocates
+  // nothing once the thread has warmed up
+  thread_local std::vector<float> scores;
+  size_t prediction = prediction_table_.ClassifyIndex(pixel_grid, scores);
+
+  char label = prediction_table_.GetLabelSet().LabelAt(prediction);
+
+  if (prediction_cache_ != nullptr) {
+    prediction_cache_->Insert(version_, pixel_grid, label);
   }
 
-  return prediction;
+  return label;
 }
 
 float Model::CalculateLikelihood(char label, const Image &image) const {
+  return CalculateLabelLikelihood(model_trainer_->GetLabelSet().IndexOf(label),
+                                  image);
+}
+
+float Model::CalculateLabelLikelihood(size_t label_index,
+                                      const Image &image) const {
 
-  auto features = model_trainer_->GetFeatures();
+  const FeatureVector &features = model_trainer_->GetFeatures();
   float sum_probability = 0.0f;
-  float prior = model_trainer_->GetPriors().at(label);
+  float prior = model_trainer_->GetPriors().at(label_index);
 
   sum_probability += std::log(prior);
 
   for (size_t row = 0; row < features.size(); ++row) {
     for (size_t col = 0; col < features[row].size(); ++col) {
       size_t pixel = size_t(image.GetPixelStatusByLocation(row, col));
-      sum_probability += std::log(features[row][col][pixel].at(label));
+      sum_probability += std::log(features[row][col][pixel][label_index]);
     }
   }
 
@@ -129,6 +286,11 @@ float Model::CalculateLikelihood(char label, const Image &image) const {
 }
 
 float Model::GetAccuracy(const std::string &testing_file_path) {
+  ModelMetrics &metrics = GetModelMetrics();
+  ScopedTimer timer(metrics.evaluate_duration);
+  TraceScope trace("model", "GetAccuracy");
+  SubsystemScope subsystem(Subsystem::kModel);
+
   std::ifstream testing_file(testing_file_path);
   std::string current_line;
   std::vector<std::string> ascii_image;
@@ -138,6 +300,8 @@ float Model::GetAccuracy(const std::string &testing_file_path) {
 
   size_t total_images = 0;
   size_t correct_predictions = 0;
+  const LabelSet &labels = prediction_table_.GetLabelSet();
+  confusion_matrix_.assign(labels.Size(), std::array<size_t, 2>{{0, 0}});
 
   while (std::getline(testing_file, current_line)) {
     if (current_line.length() == 1) {
@@ -150,7 +314,10 @@ float Model::GetAccuracy(const std::string &testing_file_path) {
           ++correct_predictions;
         }
 
-        ++confusion_matrix_[label][is_correct_classification];
+        // Labels the model was never trained on have no row in the matrix
+        if (labels.Contains(label)) {
+          ++confusion_matrix_[labels.IndexOf(label)][is_correct_classification];
+        }
 
         ascii_image.clear();
         label = current_line[0];
@@ -161,21 +328,165 @@ float Model::GetAccuracy(const std::string &testing_file_path) {
     ascii_image.push_back(current_line);
   }
 
+  metrics.images_evaluated.Increment(total_images);
+
   return float(correct_predictions) / float(total_images);
 }
 
+CrossValidationReport Model::CrossValidate(size_t num_folds,
+                                          size_t num_threads) const {
+  if (num_folds < 2 || num_folds > total_num_images_) {
+    throw std::invalid_argument(
+        "Number of folds must be between 2 and the number of images");
+  }
+
+  // Labels can be added without images, so the size is taken from the first
+  // label that has any
+  const Image *first_image = nullptr;
+
+  for (const std::vector<Image *> &images : label_images_) {
+    if (!images.empty()) {
+      first_image = images.front();
+      break;
+    }
+  }
+
+  if (first_image == nullptr) {
+    throw std::invalid_argument("The model has no training images");
+  }
+
+  size_t image_size = first_image->GetSize();
+  size_t num_shades = size_t(Pixel::kNumShades);
+  const std::vector<char> &labels = labels_.GetLabels();
+
+  // Dealing the images out in label order keeps every fold stratified
+  std::vector<std::vector<const Image *>> fold_images(num_folds);
+  size_t image_index = 0;
+
+  for (const std::vector<Image *> &images : label_images_) {
+    for (const Image *image : images) {
+      fold_images[image_index % num_folds].push_back(image);
+      ++image_index;
+    }
+  }
+
+  std::vector<FeatureCounts> fold_counts(
+      num_folds, FeatureCounts(image_size, num_shades, labels));
+
+  ParallelFor(num_folds, num_threads,
+              [&](size_t, size_t begin, size_t end) {
+                for (size_t fold = begin; fold < end; ++fold) {
+                  for (const Image *image : fold_images[fold]) {
+                    fold_counts[fold].AddImage(*image);
+                  }
+                }
+              });
+
+  FeatureCounts total_counts = FeatureCounts::Merge(fold_counts);
+  CrossValidationReport report;
+  size_t total_correct = 0;
+
+  for (size_t fold = 0; fold < num_folds; ++fold) {
+    FeatureCounts training_counts = total_counts;
+    training_counts -= fold_counts[fold];
+
+    Trainer trainer(image_size, num_shades, labels);
+    trainer.CalculateFeatures(training_counts);
+    trainer.CalculatePriors(training_counts);
+    LogProbTable table(trainer);
+
+    const std::vector<const Image *> &images = fold_images[fold];
+    std::vector<std::vector<std::array<size_t, 2>>> chunk_confusion(
+        ResolveNumThreads(num_threads),
+        std::vector<std::array<size_t, 2>>(labels_.Size(), {{0, 0}}));
+
+    ParallelFor(images.size(), num_threads,
+                [&](size_t chunk, size_t begin, size_t end) {
+                  for (size_t image = begin; image < end; ++image) {
+                    size_t label = labels_.IndexOf(images[image]->GetLabel());
+                    bool is_correct_classification =
+                        table.ClassifyIndex(*images[image]) == label;
+
+                    ++chunk_confusion[chunk][label][is_correct_classification];
+                  }
+                });
+
+    FoldResult result = {images.size(), 0, 0.0f};
+
+    for (const auto &confusion : chunk_confusion) {
+      for (size_t label = 0; label < confusion.size(); ++label) {
+        for (size_t outcome = 0; outcome < 2; ++outcome) {
+          report.confusion_matrix[labels_.LabelAt(label)][outcome == 1] +=
+              confusion[label][outcome];
+        }
+
+        result.num_correct += confusion[label][1];
+      }
+    }
+
+    result.accuracy = float(result.num_correct) / float(result.num_images);
+    total_correct += result.num_correct;
+    report.folds.push_back(result);
+  }
+
+  float accuracy_sum = 0.0f;
+
+  for (const FoldResult &result : report.folds) {
+    accuracy_sum += result.accuracy;
+  }
+
+  report.mean_accuracy = accuracy_sum / float(num_folds);
+
+  float squared_deviation_sum = 0.0f;
+
+  for (const FoldResult &result : report.folds) {
+    float deviation = result.accuracy - report.mean_accuracy;
+    squared_deviation_sum += deviation * deviation;
+  }
+
+  report.accuracy_std_dev =
+      std::sqrt(squared_deviation_sum / float(num_folds - 1));
+  report.pooled_accuracy = float(total_correct) / float(total_num_images_);
+
+  return report;
+}
+
 void Model::Load(const std::string &model_file_path) {
   std::cout << "Loading Model........" << std::endl;
+  ModelMetrics &metrics = GetModelMetrics();
+  ScopedTimer timer(metrics.load_duration);
+  TraceScope trace("model", "Load");
+  SubsystemScope subsystem(Subsystem::kModel);
 
   std::ifstream saved_stream(model_file_path);
+  delete model_trainer_;
   model_trainer_ = new Trainer();
   // Overloaded operator to train to load model
   saved_stream >> *model_trainer_;
+  UpdateVersion();
+
+  metrics.model_labels.Set(int64_t(model_trainer_->GetLabelSet().Size()));
 
   std::cout << "Finished Loading........." << std::endl;
 }
 
+void Model::Load(const EmbeddedModel &embedded_model) {
+  ModelMetrics &metrics = GetModelMetrics();
+  ScopedTimer timer(metrics.load_duration);
+  TraceScope trace("model", "Load");
+  SubsystemScope subsystem(Subsystem::kModel);
+
+  prediction_table_ = LogProbTable(embedded_model);
+  delete model_trainer_;
+  model_trainer_ = nullptr;
+  UpdateVersion();
+
+  metrics.model_labels.Set(int64_t(prediction_table_.GetLabelSet().Size()));
+}
+
 std::istream &operator>>(std::istream &input, Model &model) {
+  TraceScope trace("model", "Parse");
+  SubsystemScope subsystem(Subsystem::kModel);
   std::string current_line;
   std::vector<std::string> ascii_image;
 
@@ -185,7 +496,7 @@ std::istream &operator>>(std::istream &input, Model &model) {
   while (std::getline(input, current_line)) {
     // Text file is on a line with a label
     if (current_line.length() == 1) {
-      model.UpdateTrainingImageMap(label);
+      model.AddLabel(label);
       // Only create a new image if the data has been collected for it
       if (!ascii_image.empty()) {
         model.AddImage(ascii_image, label);
@@ -198,23 +509,27 @@ std::istream &operator>>(std::istream &input, Model &model) {
   }
 
   model.AddImage(ascii_image, label);
+  delete model.model_trainer_;
   model.model_trainer_ = nullptr;
+  model.prediction_table_ = LogProbTable();
 
   return input;
 }
 
 std::ostream &operator<<(std::ostream &os, const Model &trainer) {
   std::cout << "Saving the model........" << std::endl;
+  ScopedTimer timer(GetModelMetrics().save_duration);
+  TraceScope trace("model", "Save");
+  SubsystemScope subsystem(Subsystem::kModel);
 
-  // Access the first training image's size
-  size_t image_size = trainer.label_image_map_.begin()->second.at(0)->GetSize();
+  size_t image_size = trainer.model_trainer_->GetImageSize();
   size_t num_shades = size_t(Pixel::kNumShades);
-  std::vector<char> labels = trainer.GetLabels();
+  const std::vector<char> &labels = trainer.model_trainer_->GetLabels();
 
   // Save basic model information at top of file
   os << image_size << std::endl;
   os << num_shades << std::endl;
-  os << trainer.label_image_map_.size() << std::endl;
+  os << labels.size() << std::endl;
 
   for (char label : labels) {
     os << label << std::endl;
@@ -228,55 +543,78 @@ std::ostream &operator<<(std::ostream &os, const Model &trainer) {
 }
 
 void Model::AddImage(const std::vector<std::string> &ascii_image, char label) {
+  SubsystemScope subsystem(Subsystem::kModel);
+  GetModelMetrics().images_parsed.Increment();
+
   Image *image = new Image(ascii_image, label);
-  label_image_map_[label].push_back(image);
+  label_images_[AddLabel(label)].push_back(image);
   ++total_num_images_;
 }
 
-void Model::UpdateTrainingImageMap(char label) {
-  // Initialize a new label in the map with an empty vector
-  if (!label_image_map_.count(label)) {
-    label_image_map_[label] = std::vector<Image *>{};
-    return;
+size_t Model::AddLabel(char label) {
+  // Initialize a new label with an empty vector in its sorted position
+  if (!labels_.Contains(label)) {
+    size_t label_index = labels_.Add(label);
+    label_images_.insert(label_images_.begin() + label_index,
+                         std::vector<Image *>{});
+    return label_index;
   }
+
+  return labels_.IndexOf(label);
 }
 
 void Model::ClearModel() {
 
-  for (const auto &itr : label_image_map_) {
-    std::vector<Image *> images = itr.second;
-
+  for (const std::vector<Image *> &images : label_images_) {
     for (Image *image : images) {
       delete image;
     }
-
-    images.clear();
   }
 
   delete model_trainer_;
-  label_image_map_.clear();
+  model_trainer_ = nullptr;
+  labels_ = LabelSet();
+  label_images_.clear();
   total_num_images_ = 0;
 }
 
-std::vector<char> Model::GetLabels() const {
+void Model::UpdateVersion() {
+  version_ = NextModelVersion();
 
-  if (label_image_map_.empty()) {
-    return model_trainer_->GetLabels();
+  if (model_trainer_ != nullptr) {
+    prediction_table_ = LogProbTable(*model_trainer_);
   }
 
-  std::vector<char> labels;
-
-  for (const auto &itr : label_image_map_) {
-    labels.push_back(itr.first);
+  if (prediction_cache_ != nullptr) {
+    prediction_cache_->Clear();
   }
+}
 
-  return labels;
+void Model::EnablePredictionCache(size_t capacity) {
+  delete prediction_cache_;
+  prediction_cache_ = new PredictionCache(capacity);
 }
 
+PredictionCache *Model::GetPredictionCache() const { return prediction_cache_; }
+
+uint64_t Model::GetVersion() const { return version_; }
+
 std::map<char, std::vector<Image *>> Model::GetTrainingImageMap() const {
-  return label_image_map_;
+  std::map<char, std::vector<Image *>> image_map;
+
+  for (size_t label = 0; label < label_images_.size(); ++label) {
+    image_map[labels_.LabelAt(label)] = label_images_[label];
+  }
+
+  return image_map;
+}
+
+const std::vector<Image *> &Model::GetTrainingImages(char label) const {
+  return label_images_[labels_.IndexOf(label)];
 }
 
+const LabelSet &Model::GetLabelSet() const { return labels_; }
+
 void Model::PrintConfusionMatrix() const {
 
   if (confusion_matrix_.empty()) {
@@ -288,11 +626,12 @@ void Model::PrintConfusionMatrix() const {
   std::cout << " Label  |     Correct     |    Wrong  " << std::endl;
 
   std::string spacing_string = "                ";
-  
-  for (auto label_itr : confusion_matrix_) {
-    std::cout << label_itr.first << spacing_string;
-    std::cout << label_itr.second.at(true) << spacing_string;
-    std::cout << label_itr.second.at(false) << std::endl;
+  const LabelSet &labels = prediction_table_.GetLabelSet();
+
+  for (size_t label = 0; label < confusion_matrix_.size(); ++label) {
+    std::cout << labels.LabelAt(label) << spacing_string;
+    std::cout << confusion_matrix_[label][true] << spacing_string;
+    std::cout << confusion_matrix_[label][false] << std::endl;
   }
 }
 
@@ -0,0 +1,147 @@
+#include "core/prediction_cache.h"
+
+namespace naivebayes {
+
+PredictionCache::PredictionCache(size_t capacity)
+    : capacity_(capacity), hits_(0), misses_(0), evictions_(0) {}
+
+bool PredictionCache::Lookup(uint64_t model_version,
+                             const std::vector<std::vector<Pixel>> &pixel_grid,
+                             char &prediction) {
+  // Lookups reuse a key per thread, so a cache hit allocates nothing
+  thread_local std::string key;
+  PackKey(model_version, pixel_grid, key);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto entry_itr = entry_map_.find(key);
+
+  if (entry_itr == entry_map_.end()) {
+    ++misses_;
+    return false;
+  }
+
+  entries_.splice(entries_.begin(), entries_, entry_itr->second);
+  prediction = entry_itr->second->second;
+  ++hits_;
+
+  return true;
+}
+
+void PredictionCache::Insert(uint64_t model_version,
+                             const std::vector<std::vector<Pixel>> &pixel_grid,
+                             char prediction) {
+  if (capacity_ == 0) {
+    return;
+  }
+
+  std::string key = PackKey(model_version, pixel_grid);
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto entry_itr = entry_map_.find(key);
+
+  // Another thread may have predicted the same image in the meantime
+  if (entry_itr != entry_map_.end()) {
+    entry_itr->second->second = prediction;
+    entries_.splice(entries_.begin(), entries_, entry_itr->second);
+    return;
+  }
+
+  if (entries_.size() == capacity_) {
+    entry_map_.erase(entries_.back().first);
+    entries_.pop_back();
+    ++evictions_;
+  }
+
+  entries_.emplace_front(key, prediction);
+  entry_map_[key] = entries_.begin();
+}
+
+void PredictionCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  entries_.clear();
+  entry_map_.clear();
+}
+
+size_t PredictionCache::GetHits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hits_;
+}
+
+size_t PredictionCache::GetMisses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return misses_;
+}
+
+size_t PredictionCache::GetEvictions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return evictions_;
+}
+
+size_t PredictionCache::GetSize() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+size_t PredictionCache::GetCapacity() const { return capacity_; }
+
+std::string
+PredictionCache::PackKey(uint64_t model_version,
+                         const std::vector<std::vector<Pixel>> &pixel_grid) {
+  std::string key;
+  PackKey(model_version, pixel_grid, key);
+
+  return key;
+}
+
+void PredictionCache::PackKey(uint64_t model_version,
+                              const std::vector<std::vector<Pixel>> &pixel_grid,
+                              std::string &key) {
+  const size_t kPixelsPerByte = 4;
+  const size_t kBitsPerPixel = 2;
+
+  key.clear();
+  uint64_t rows = pixel_grid.size();
+
+  for (uint64_t header : {model_version, rows}) {
+    for (size_t byte = 0; byte < sizeof(header); ++byte) {
+      key.push_back(char((header >> (byte * 8)) & 0xFF));
+    }
+  }
+
+  unsigned char packed = 0;
+  size_t num_packed = 0;
+
+  for (const std::vector<Pixel> &row : pixel_grid) {
+    for (Pixel pixel : row) {
+      packed |= (unsigned char)(size_t(pixel) << (num_packed * kBitsPerPixel));
+
+      if (++num_packed == kPixelsPerByte) {
+        key.push_back(char(packed));
+        packed = 0;
+        num_packed = 0;
+      }
+    }
+  }
+
+  if (num_packed > 0) {
+    key.push_back(char(packed));
+  }
+}
+
+size_t PredictionCache::KeyHash::operator()(const std::string &key) const {
+  const uint64_t kOffsetBasis = 14695981039346656037ULL;
+  const uint64_t kPrime = 1099511628211ULL;
+
+  uint64_t hash = kOffsetBasis;
+
+  for (char byte : key) {
+    hash ^= uint64_t((unsigned char)byte);
+    hash *= kPrime;
+  }
+
+  return size_t(hash);
+}
+
+} // namespace naivebayes
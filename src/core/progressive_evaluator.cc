@@ -0,0 +1,299 @@
+#include "core/progressive_evaluator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <core/tracer.h>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace naivebayes {
+
+namespace {
+
+/**
+ * Finds the standard normal quantile of a two sided confidence level
+ *
+ * @param confidence the confidence level, between 0 and 1
+ * @return the z score that leaves (1 - confidence) / 2 in each tail
+ */
+double NormalQuantile(double confidence) {
+  double tail = (1.0 - confidence) / 2.0;
+  double low = 0.0;
+  double high = 40.0;
+
+  // The upper tail of the normal distribution falls as z grows
+  for (size_t step = 0; step < 200; ++step) {
+    double middle = (low + high) / 2.0;
+
+    if (0.5 * std::erfc(middle / std::sqrt(2.0)) > tail) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+
+  return (low + high) / 2.0;
+}
+
+/**
+ * Shuffles indices with a Fisher-Yates shuffle. Unlike std::shuffle, the
+ * order only depends on the Mersenne Twister, so it is the same with every
+ * standard library
+ *
+ * @param indices the indices to shuffle
+ * @param generator the source of randomness
+ */
+void Shuffle(std::vector<size_t> &indices, std::mt19937_64 &generator) {
+  for (size_t index = indices.size(); index > 1; --index) {
+    std::swap(indices[index - 1], indices[generator() % index]);
+  }
+}
+
+} // namespace
+
+ProgressiveEvaluator::ProgressiveEvaluator()
+    : ProgressiveEvaluator(ProgressiveOptions{0.95, 0.01, 100, true, 0}) {}
+
+ProgressiveEvaluator::ProgressiveEvaluator(const ProgressiveOptions &options)
+    : options_(options) {
+
+  if (!(options.confidence > 0.0 && options.confidence < 1.0)) {
+    throw std::invalid_argument("Confidence must be between 0 and 1");
+  }
+
+  if (!(options.target_width > 0.0)) {
+    throw std::invalid_argument("Target width must be positive");
+  }
+}
+
+ProgressiveEvaluation
+ProgressiveEvaluator::Evaluate(const std::vector<Image> &images,
+                               const LogProbTable &candidate,
+                               const LogProbTable *baseline) const {
+  TraceScope trace("progressive", "Evaluate");
+
+  ProgressiveEvaluation evaluation = {};
+  evaluation.num_available = images.size();
+  evaluation.has_baseline = baseline != nullptr;
+  evaluation.accuracy_upper = 1.0;
+  evaluation.p_value = 1.0;
+  evaluation.stop = ProgressiveStop::kExhausted;
+
+  // Every checkpoint is a chance to stop on a wrong verdict, so each one
+  // gets an even share of the error rate (a Bonferroni correction)
+  std::vector<size_t> checkpoints =
+      Checkpoints(options_.min_images, images.size());
+  double alpha = (1.0 - options_.confidence) /
+                 double(std::max<size_t>(1, checkpoints.size()));
+  double z = NormalQuantile(1.0 - alpha);
+  size_t next_checkpoint = 0;
+
+  for (size_t index :
+       ScoringOrder(images, options_.is_stratified, options_.seed)) {
+    const Image &image = images[index];
+    bool is_correct = candidate.Classify(image) == image.GetLabel();
+
+    ++evaluation.num_images;
+    evaluation.num_correct += is_correct ? 1 : 0;
+
+    if (baseline != nullptr) {
+      bool is_baseline_correct = baseline->Classify(image) == image.GetLabel();
+      evaluation.num_baseline_correct += is_baseline_correct ? 1 : 0;
+
+      if (is_correct && !is_baseline_correct) {
+        ++evaluation.num_candidate_only;
+      } else if (!is_correct && is_baseline_correct) {
+        ++evaluation.num_baseline_only;
+      }
+    }
+
+    if (evaluation.num_images < checkpoints[next_checkpoint]) {
+      continue;
+    }
+
+    ++next_checkpoint;
+    WilsonInterval(evaluation.num_correct, evaluation.num_images, z,
+                   evaluation.accuracy_lower, evaluation.accuracy_upper);
+
+    if (baseline != nullptr) {
+      evaluation.p_value = SignTestPValue(evaluation.num_candidate_only,
+                                          evaluation.num_baseline_only);
+
+      if (evaluation.num_baseline_only > evaluation.num_candidate_only &&
+          evaluation.p_value < alpha) {
+        evaluation.stop = ProgressiveStop::kWorseThanBaseline;
+        break;
+      }
+    }
+
+    if (evaluation.accuracy_upper - evaluation.accuracy_lower <
+        options_.target_width) {
+      evaluation.stop = ProgressiveStop::kConverged;
+      break;
+    }
+  }
+
+  if (evaluation.num_images > 0) {
+    evaluation.accuracy =
+        double(evaluation.num_correct) / double(evaluation.num_images);
+    evaluation.difference = (double(evaluation.num_candidate_only) -
+                             double(evaluation.num_baseline_only)) /
+                            double(evaluation.num_images);
+  }
+
+  return evaluation;
+}
+
+std::vector<size_t> ProgressiveEvaluator::Checkpoints(size_t min_images,
+                                                      size_t num_available) {
+  std::vector<size_t> checkpoints;
+
+  for (size_t checkpoint = std::max<size_t>(1, min_images);
+       checkpoint < num_available; checkpoint *= 2) {
+    checkpoints.push_back(checkpoint);
+  }
+
+  if (num_available > 0) {
+    checkpoints.push_back(num_available);
+  }
+
+  return checkpoints;
+}
+
+double ProgressiveEvaluator::SignTestPValue(size_t num_first,
+                                            size_t num_second) {
+  double num_trials = double(num_first + num_second);
+  size_t num_fewer = std::min(num_first, num_second);
+  double log_tail_total = std::lgamma(num_trials + 1.0) -
+                          num_trials * std::log(2.0);
+  double tail = 0.0;
+
+  // The binomial probabilities are taken in logs so that long runs do not
+  // underflow 0.5 to the power of the number of trials
+  for (size_t successes = 0; successes <= num_fewer; ++successes) {
+    tail += std::exp(log_tail_total - std::lgamma(double(successes) + 1.0) -
+                     std::lgamma(num_trials - double(successes) + 1.0));
+  }
+
+  return std::min(1.0, 2.0 * tail);
+}
+
+std::vector<size_t>
+ProgressiveEvaluator::ScoringOrder(const std::vector<Image> &images,
+                                   bool is_stratified, uint64_t seed) {
+  std::mt19937_64 generator(seed);
+  std::vector<size_t> order;
+
+  if (!is_stratified) {
+    for (size_t index = 0; index < images.size(); ++index) {
+      order.push_back(index);
+    }
+
+    Shuffle(order, generator);
+    return order;
+  }
+
+  std::map<char, std::vector<size_t>> label_indices;
+
+  for (size_t index = 0; index < images.size(); ++index) {
+    label_indices[images[index].GetLabel()].push_back(index);
+  }
+
+  // The k-th of the n images of a label is placed at (k + 0.5) / n of the
+  // way through the order, so every prefix holds each label in proportion
+  std::vector<std::pair<double, size_t>> positions;
+
+  for (auto &label : label_indices) {
+    Shuffle(label.second, generator);
+
+    for (size_t rank = 0; rank < label.second.size(); ++rank) {
+      positions.emplace_back((double(rank) + 0.5) / double(label.second.size()),
+                             label.second[rank]);
+    }
+  }
+
+  std::stable_sort(positions.begin(), positions.end(),
+                   [](const std::pair<double, size_t> &first,
+                      const std::pair<double, size_t> &second) {
+                     return first.first < second.first;
+                   });
+
+  for (const std::pair<double, size_t> &position : positions) {
+    order.push_back(position.second);
+  }
+
+  return order;
+}
+
+void ProgressiveEvaluator::WilsonInterval(size_t num_successes,
+                                          size_t num_trials, double z,
+                                          double &lower, double &upper) {
+  if (num_trials == 0) {
+    lower = 0.0;
+    upper = 1.0;
+    return;
+  }
+
+  double trials = double(num_trials);
+  double proportion = double(num_successes) / trials;
+  double z_squared = z * z;
+  double denominator = 1.0 + z_squared / trials;
+  double center = (proportion + z_squared / (2.0 * trials)) / denominator;
+  double margin = z *
+                  std::sqrt(proportion * (1.0 - proportion) / trials +
+                            z_squared / (4.0 * trials * trials)) /
+                  denominator;
+
+  lower = std::max(0.0, center - margin);
+  upper = std::min(1.0, center + margin);
+}
+
+void ProgressiveEvaluator::PrintEvaluation(
+    std::ostream &output, const ProgressiveEvaluation &evaluation) {
+  output << "Images scored: " << evaluation.num_images << " of "
+         << evaluation.num_available << std::endl;
+  output << "Accuracy: " << evaluation.accuracy * 100.0 << "% ["
+         << evaluation.accuracy_lower * 100.0 << "%, "
+         << evaluation.accuracy_upper * 100.0 << "%]" << std::endl;
+
+  if (evaluation.has_baseline) {
+    double baseline_accuracy = 0.0;
+
+    if (evaluation.num_images > 0) {
+      baseline_accuracy = double(evaluation.num_baseline_correct) /
+                          double(evaluation.num_images);
+    }
+
+    output << "Baseline accuracy: " << baseline_accuracy * 100.0 << "%"
+           << std::endl;
+    output << "Difference from the baseline: " << evaluation.difference * 100.0
+           << "% (" << evaluation.num_candidate_only << " images only the "
+           << "candidate got right, " << evaluation.num_baseline_only
+           << " only the baseline, p = " << evaluation.p_value << ")"
+           << std::endl;
+  }
+
+  output << "Stopped: ";
+
+  switch (evaluation.stop) {
+  case ProgressiveStop::kConverged:
+    output << "the accuracy interval is narrower than the target";
+    break;
+  case ProgressiveStop::kWorseThanBaseline:
+    output << "the candidate is worse than the baseline";
+    break;
+  case ProgressiveStop::kExhausted:
+    output << "every image was scored";
+    break;
+  }
+
+  output << std::endl;
+}
+
+const ProgressiveOptions &ProgressiveEvaluator::GetOptions() const {
+  return options_;
+}
+
+} // namespace naivebayes
@@ -0,0 +1,386 @@
+#include "core/pruned_table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <core/dataset_reader.h>
+#include <core/tracer.h>
+#include <stdexcept>
+#include <string>
+
+namespace naivebayes {
+
+namespace {
+
+/**
+ * Parses and reads the next line of an input to a size_t
+ *
+ * @param input the input stream with the next number
+ * @return the parsed number
+ * @throws std::invalid_argument if the line is not a number
+ */
+size_t ReadSizeT(std::istream &input) {
+  std::string line;
+
+  size_t parsed_length = 0;
+
+  if (!std::getline(input, line)) {
+    throw std::invalid_argument("Bad file provided");
+  }
+
+  size_t number = std::stoul(line, &parsed_length);
+
+  // A fraction, such as a prior of an unpruned model, is not a count
+  if (parsed_length != line.length()) {
+    throw std::invalid_argument("Bad file provided");
+  }
+
+  return number;
+}
+
+/**
+ * Parses and reads the next line of an input to a float, including infinite
+ * log probabilities
+ *
+ * @param input the input stream with the next number
+ * @return the parsed number
+ * @throws std::invalid_argument if the line is not a number
+ */
+float ReadFloat(std::istream &input) {
+  std::string line;
+
+  if (!std::getline(input, line)) {
+    throw std::invalid_argument("Bad file provided");
+  }
+
+  return std::stof(line);
+}
+
+/**
+ * Finds the label with the highest score, with ties going to the first label
+ *
+ * @param scores the score of every label
+ * @return the index of the best label
+ */
+size_t ArgMax(const std::vector<float> &scores) {
+  return size_t(std::max_element(scores.begin(), scores.end()) -
+                scores.begin());
+}
+
+} // namespace
+
+PrunedTable::PrunedTable() : image_size_(0), num_shades_(0) {}
+
+PrunedTable::PrunedTable(const LogProbTable &table, size_t num_pixels,
+                         PixelRanking ranking)
+    : image_size_(table.GetImageSize()), num_shades_(table.GetNumShades()),
+      labels_(table.GetLabelSet()), log_priors_(table.GetLogPriors()) {
+
+  if (num_pixels > image_size_ * image_size_) {
+    throw std::invalid_argument("Cannot keep more pixels than the model has");
+  }
+
+  std::vector<size_t> ranked_pixels = RankPixels(table, ranking);
+  pixels_.assign(ranked_pixels.begin(), ranked_pixels.begin() + num_pixels);
+  std::sort(pixels_.begin(), pixels_.end());
+  LocatePixels();
+
+  size_t pixel_stride = num_shades_ * labels_.Size();
+  const std::vector<float> &log_features = table.GetLogFeatures();
+
+  for (size_t pixel : pixels_) {
+    log_features_.insert(log_features_.end(),
+                         log_features.begin() + pixel * pixel_stride,
+                         log_features.begin() + (pixel + 1) * pixel_stride);
+  }
+}
+
+std::vector<double> PrunedTable::ScorePixels(const LogProbTable &table,
+                                             PixelRanking ranking) {
+  size_t num_labels = table.GetLabelSet().Size();
+  size_t num_shades = table.GetNumShades();
+  size_t num_pixels = table.GetImageSize() * table.GetImageSize();
+  const std::vector<float> &log_features = table.GetLogFeatures();
+
+  // Saved priors are rounded, so they are renormalized to sum to one
+  std::vector<double> priors;
+  double prior_total = 0.0;
+
+  for (float log_prior : table.GetLogPriors()) {
+    priors.push_back(std::exp(double(log_prior)));
+    prior_total += priors.back();
+  }
+
+  for (double &prior : priors) {
+    prior /= prior_total;
+  }
+
+  std::vector<double> pixel_scores(num_pixels, 0.0);
+  std::vector<double> shade_probs(num_shades);
+
+  for (size_t pixel = 0; pixel < num_pixels; ++pixel) {
+    const float *pixel_features =
+        log_features.data() + pixel * num_shades * num_labels;
+
+    // The probability of each shade over every label together
+    for (size_t shade = 0; shade < num_shades; ++shade) {
+      shade_probs[shade] = 0.0;
+
+      for (size_t label = 0; label < num_labels; ++label) {
+        shade_probs[shade] +=
+            priors[label] *
+            std::exp(double(pixel_features[shade * num_labels + label]));
+      }
+    }
+
+    for (size_t label = 0; label < num_labels; ++label) {
+      double divergence = 0.0;
+
+      for (size_t shade = 0; shade < num_shades; ++shade) {
+        double log_prob = double(pixel_features[shade * num_labels + label]);
+        double prob = std::exp(log_prob);
+
+        if (prob > 0.0) {
+          divergence += prob * (log_prob - std::log(shade_probs[shade]));
+        }
+      }
+
+      if (ranking == PixelRanking::kMutualInformation) {
+        pixel_scores[pixel] += priors[label] * divergence;
+      } else {
+        pixel_scores[pixel] = std::max(pixel_scores[pixel], divergence);
+      }
+    }
+  }
+
+  return pixel_scores;
+}
+
+std::vector<size_t> PrunedTable::RankPixels(const LogProbTable &table,
+                                            PixelRanking ranking) {
+  std::vector<double> pixel_scores = ScorePixels(table, ranking);
+  std::vector<size_t> ranked_pixels;
+
+  for (size_t pixel = 0; pixel < pixel_scores.size(); ++pixel) {
+    ranked_pixels.push_back(pixel);
+  }
+
+  std::stable_sort(ranked_pixels.begin(), ranked_pixels.end(),
+                   [&pixel_scores](size_t first, size_t second) {
+                     return pixel_scores[first] > pixel_scores[second];
+                   });
+
+  return ranked_pixels;
+}
+
+std::vector<PruningPoint>
+PrunedTable::EvaluatePruning(const LogProbTable &table,
+                             std::istream &testing_stream,
+                             const std::vector<size_t> &pixel_counts,
+                             PixelRanking ranking) {
+  TraceScope trace("pruning", "EvaluatePruning");
+
+  std::vector<PrunedTable> pruned_tables;
+  std::vector<PruningPoint> points;
+
+  for (size_t num_pixels : pixel_counts) {
+    pruned_tables.emplace_back(table, num_pixels, ranking);
+    points.push_back({num_pixels, 0, 0, 0.0f, 0});
+  }
+
+  Image image;
+
+  while (DatasetReader::ReadImage(testing_stream, image)) {
+    char full_prediction = table.Classify(image);
+
+    for (size_t point = 0; point < points.size(); ++point) {
+      char prediction = pruned_tables[point].Classify(image);
+
+      ++points[point].num_images;
+      points[point].num_correct += prediction == image.GetLabel() ? 1 : 0;
+      points[point].num_disagreements += prediction != full_prediction ? 1 : 0;
+    }
+  }
+
+  for (PruningPoint &point : points) {
+    if (point.num_images > 0) {
+      point.accuracy = float(point.num_correct) / float(point.num_images);
+    }
+  }
+
+  return points;
+}
+
+void PrunedTable::Score(const Image &image, std::vector<float> &scores) const {
+  if (image.GetSize() != image_size_) {
+    throw std::invalid_argument("Image size does not match the model");
+  }
+
+  scores.assign(log_priors_.begin(), log_priors_.end());
+
+  size_t num_labels = labels_.Size();
+  const float *pixel_features = log_features_.data();
+  const std::vector<std::vector<Pixel>> &pixel_grid = image.GetPixels();
+
+  // Checking the rows once lets every kept pixel be read without bounds checks
+  for (const std::vector<Pixel> &row : pixel_grid) {
+    if (row.size() != image_size_) {
+      throw std::invalid_argument("Pixel vector is not square");
+    }
+  }
+
+  for (const std::pair<size_t, size_t> &location : locations_) {
+    size_t shade = size_t(pixel_grid[location.first][location.second]);
+
+    if (shade >= num_shades_) {
+      throw std::invalid_argument("Image shade is not part of the model");
+    }
+
+    const float *shade_features = pixel_features + shade * num_labels;
+
+    for (size_t label = 0; label < num_labels; ++label) {
+      scores[label] += shade_features[label];
+    }
+
+    pixel_features += num_shades_ * num_labels;
+  }
+}
+
+char PrunedTable::Classify(const Image &image) const {
+  // Reused by every call on the thread so that classifying does not allocate
+  thread_local std::vector<float> scores;
+  Score(image, scores);
+
+  return labels_.LabelAt(ArgMax(scores));
+}
+
+size_t PrunedTable::Classify(std::istream &input, std::ostream &output,
+                             bool write_scores) const {
+  TraceScope trace("pruning", "ClassifyStream");
+
+  std::vector<float> scores;
+  char score_text[32];
+  Image image;
+  size_t num_images = 0;
+
+  while (DatasetReader::ReadImage(input, image)) {
+    Score(image, scores);
+    output << labels_.LabelAt(ArgMax(scores));
+
+    for (size_t label = 0; write_scores && label < scores.size(); ++label) {
+      std::snprintf(score_text, sizeof(score_text), "\t%.9g",
+                    double(scores[label]));
+      output << score_text;
+    }
+
+    output << '\n';
+    ++num_images;
+  }
+
+  output.flush();
+
+  return num_images;
+}
+
+std::ostream &operator<<(std::ostream &output, const PrunedTable &table) {
+  // Enough digits for every float to be read back exactly
+  std::streamsize precision = output.precision(9);
+
+  output << table.image_size_ << std::endl;
+  output << table.num_shades_ << std::endl;
+  output << table.labels_.Size() << std::endl;
+
+  for (char label : table.labels_.GetLabels()) {
+    output << label << std::endl;
+  }
+
+  output << std::endl;
+  output << table.pixels_.size() << std::endl;
+
+  for (size_t pixel : table.pixels_) {
+    output << pixel << std::endl;
+  }
+
+  for (float log_prior : table.log_priors_) {
+    output << log_prior << std::endl;
+  }
+
+  for (float log_feature : table.log_features_) {
+    output << log_feature << std::endl;
+  }
+
+  output.precision(precision);
+  return output;
+}
+
+std::istream &operator>>(std::istream &input, PrunedTable &table) {
+  std::string current_line;
+  PrunedTable loaded;
+
+  loaded.image_size_ = ReadSizeT(input);
+  loaded.num_shades_ = ReadSizeT(input);
+  size_t num_labels = ReadSizeT(input);
+
+  std::vector<char> labels;
+
+  for (size_t label = 0; label < num_labels; ++label) {
+    std::getline(input, current_line);
+
+    if (current_line.length() != 1) {
+      throw std::invalid_argument("Bad file provided");
+    }
+
+    labels.push_back(current_line[0]);
+  }
+
+  std::getline(input, current_line);
+  loaded.labels_ = LabelSet(labels);
+
+  // The tables are indexed by label, so the labels must already be in order
+  if (loaded.labels_.GetLabels() != labels) {
+    throw std::invalid_argument("Bad file provided");
+  }
+
+  size_t num_pixels = ReadSizeT(input);
+
+  for (size_t pixel = 0; pixel < num_pixels; ++pixel) {
+    loaded.pixels_.push_back(ReadSizeT(input));
+
+    if (loaded.pixels_.back() >= loaded.image_size_ * loaded.image_size_ ||
+        (pixel > 0 && loaded.pixels_[pixel] <= loaded.pixels_[pixel - 1])) {
+      throw std::invalid_argument("Bad file provided");
+    }
+  }
+
+  for (size_t label = 0; label < num_labels; ++label) {
+    loaded.log_priors_.push_back(ReadFloat(input));
+  }
+
+  size_t num_features = num_pixels * loaded.num_shades_ * num_labels;
+
+  for (size_t feature = 0; feature < num_features; ++feature) {
+    loaded.log_features_.push_back(ReadFloat(input));
+  }
+
+  loaded.LocatePixels();
+  table = loaded;
+  return input;
+}
+
+void PrunedTable::LocatePixels() {
+  locations_.clear();
+
+  for (size_t pixel : pixels_) {
+    locations_.emplace_back(pixel / image_size_, pixel % image_size_);
+  }
+}
+
+const std::vector<char> &PrunedTable::GetLabels() const {
+  return labels_.GetLabels();
+}
+
+size_t PrunedTable::GetImageSize() const { return image_size_; }
+
+const std::vector<size_t> &PrunedTable::GetPixels() const { return pixels_; }
+
+} // namespace naivebayes
@@ -0,0 +1,207 @@
+#include "core/row_decoder.h"
+
+#include <core/image.h>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NAIVEBAYES_ROW_DECODER_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NAIVEBAYES_ROW_DECODER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace naivebayes {
+
+namespace {
+
+const char kShadedChar = '#';
+const char kPartiallyShadedChar = '+';
+
+// The number of characters compared by one vector instruction
+const size_t kVectorWidth = 16;
+
+const uint8_t kShaded = uint8_t(Pixel::kShaded);
+const uint8_t kPartiallyShaded = uint8_t(Pixel::kPartiallyShaded);
+
+/**
+ * Decodes a single character of an ascii image
+ *
+ * @param pixel_char the character to decode
+ * @return the shade of the character
+ */
+inline uint8_t DecodeChar(char pixel_char) {
+  if (pixel_char == kShadedChar) {
+    return kShaded;
+  } else if (pixel_char == kPartiallyShadedChar) {
+    return kPartiallyShaded;
+  }
+
+  return uint8_t(Pixel::kUnshaded);
+}
+
+/**
+ * Packs one to four shades into a byte, the first shade in the lowest bits
+ *
+ * @param shades the shades to pack
+ * @param count the number of shades, at most four
+ * @return the packed byte
+ */
+inline uint8_t PackShades(const uint8_t *shades, size_t count) {
+  unsigned packed = 0;
+
+  for (size_t shade = 0; shade < count; ++shade) {
+    packed |= unsigned(shades[shade]) << (2 * shade);
+  }
+
+  return uint8_t(packed);
+}
+
+#ifdef NAIVEBAYES_ROW_DECODER_SSE2
+
+/**
+ * Spreads the 16 bits of a mask out to the even bits of a 32 bit word, so
+ * that bit i of the mask lands on bit 2i
+ *
+ * @param mask the bits to spread
+ * @return the spread bits
+ */
+inline uint32_t SpreadBits(uint32_t mask) {
+  mask = (mask | (mask << 8)) & 0x00FF00FFu;
+  mask = (mask | (mask << 4)) & 0x0F0F0F0Fu;
+  mask = (mask | (mask << 2)) & 0x33333333u;
+  mask = (mask | (mask << 1)) & 0x55555555u;
+
+  return mask;
+}
+
+/**
+ * Decodes 16 characters with SSE2
+ *
+ * @param text the characters to decode
+ * @param shades populated with the shade of each character
+ */
+inline void DecodeVector(const char *text, uint8_t *shades) {
+  const __m128i shaded_chars = _mm_set1_epi8(kShadedChar);
+  const __m128i partially_shaded_chars = _mm_set1_epi8(kPartiallyShadedChar);
+  const __m128i shaded = _mm_set1_epi8(char(kShaded));
+  const __m128i partially_shaded = _mm_set1_epi8(char(kPartiallyShaded));
+
+  __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+  __m128i vector_shades = _mm_or_si128(
+      _mm_and_si128(_mm_cmpeq_epi8(chars, shaded_chars), shaded),
+      _mm_and_si128(_mm_cmpeq_epi8(chars, partially_shaded_chars),
+                    partially_shaded));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(shades), vector_shades);
+}
+
+#elif defined(NAIVEBAYES_ROW_DECODER_NEON)
+
+/**
+ * Decodes 16 characters with NEON
+ *
+ * @param text the characters to decode
+ * @param shades populated with the shade of each character
+ */
+inline void DecodeVector(const char *text, uint8_t *shades) {
+  const uint8x16_t shaded_chars = vdupq_n_u8(uint8_t(kShadedChar));
+  const uint8x16_t partially_shaded_chars =
+      vdupq_n_u8(uint8_t(kPartiallyShadedChar));
+  const uint8x16_t shaded = vdupq_n_u8(kShaded);
+  const uint8x16_t partially_shaded = vdupq_n_u8(kPartiallyShaded);
+
+  uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t *>(text));
+  uint8x16_t vector_shades = vorrq_u8(
+      vandq_u8(vceqq_u8(chars, shaded_chars), shaded),
+      vandq_u8(vceqq_u8(chars, partially_shaded_chars), partially_shaded));
+  vst1q_u8(shades, vector_shades);
+}
+
+#endif
+
+} // namespace
+
+void DecodeRowScalar(const char *text, size_t length, uint8_t *shades) {
+  for (size_t col = 0; col < length; ++col) {
+    shades[col] = DecodeChar(text[col]);
+  }
+}
+
+void DecodeRowPackedScalar(const char *text, size_t length, uint8_t *packed) {
+  uint8_t shades[4];
+
+  for (size_t col = 0; col < length; col += 4) {
+    size_t count = length - col < 4 ? length - col : 4;
+    DecodeRowScalar(text + col, count, shades);
+    packed[col / 4] = PackShades(shades, count);
+  }
+}
+
+void DecodeRow(const char *text, size_t length, uint8_t *shades) {
+#if defined(NAIVEBAYES_ROW_DECODER_SSE2) || defined(NAIVEBAYES_ROW_DECODER_NEON)
+  if (length < kVectorWidth) {
+    DecodeRowScalar(text, length, shades);
+    return;
+  }
+
+  for (size_t col = 0; col + kVectorWidth <= length; col += kVectorWidth) {
+    DecodeVector(text + col, shades + col);
+  }
+
+  // The last partial vector overlaps the one before it, which is harmless
+  // since both write the same shades
+  if (length % kVectorWidth != 0) {
+    DecodeVector(text + length - kVectorWidth, shades + length - kVectorWidth);
+  }
+#else
+  DecodeRowScalar(text, length, shades);
+#endif
+}
+
+void DecodeRowPacked(const char *text, size_t length, uint8_t *packed) {
+  size_t col = 0;
+
+#if defined(NAIVEBAYES_ROW_DECODER_SSE2)
+  const __m128i shaded_chars = _mm_set1_epi8(kShadedChar);
+  const __m128i partially_shaded_chars = _mm_set1_epi8(kPartiallyShadedChar);
+
+  // A bitmask per shade, whose bits are interleaved into 2-bit shades
+  for (; col + kVectorWidth <= length; col += kVectorWidth) {
+    __m128i chars =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + col));
+    uint32_t shaded_mask =
+        uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, shaded_chars)));
+    uint32_t partially_shaded_mask = uint32_t(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chars, partially_shaded_chars)));
+    uint32_t packed_shades = (SpreadBits(shaded_mask) * kShaded) |
+                             (SpreadBits(partially_shaded_mask) *
+                              kPartiallyShaded);
+
+    for (size_t byte = 0; byte < kVectorWidth / 4; ++byte) {
+      packed[col / 4 + byte] = uint8_t(packed_shades >> (8 * byte));
+    }
+  }
+#elif defined(NAIVEBAYES_ROW_DECODER_NEON)
+  uint8_t shades[kVectorWidth];
+
+  for (; col + kVectorWidth <= length; col += kVectorWidth) {
+    DecodeVector(text + col, shades);
+
+    for (size_t byte = 0; byte < kVectorWidth / 4; ++byte) {
+      packed[col / 4 + byte] = PackShades(shades + 4 * byte, 4);
+    }
+  }
+#endif
+
+  DecodeRowPackedScalar(text + col, length - col, packed + col / 4);
+}
+
+bool IsRowDecoderVectorized() {
+#if defined(NAIVEBAYES_ROW_DECODER_SSE2) || defined(NAIVEBAYES_ROW_DECODER_NEON)
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace naivebayes
@@ -0,0 +1,85 @@
+#include "core/sketch_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace naivebayes {
+
+SketchGrid::SketchGrid(size_t num_pixels_per_side, double brush_radius)
+    : num_pixels_per_side_(num_pixels_per_side), brush_radius_(brush_radius),
+      pixel_grid_(num_pixels_per_side,
+                  std::vector<Pixel>(num_pixels_per_side, Pixel::kUnshaded)) {
+}
+
+void SketchGrid::Brush(double x, double y) { BrushSegment(x, y, x, y); }
+
+void SketchGrid::BrushSegment(double start_x, double start_y, double end_x,
+                              double end_y) {
+  size_t first_row, last_row, first_col, last_col;
+  PixelRange(std::min(start_y, end_y) - brush_radius_,
+             std::max(start_y, end_y) + brush_radius_, first_row, last_row);
+  PixelRange(std::min(start_x, end_x) - brush_radius_,
+             std::max(start_x, end_x) + brush_radius_, first_col, last_col);
+
+  double delta_x = end_x - start_x;
+  double delta_y = end_y - start_y;
+  double length_squared = delta_x * delta_x + delta_y * delta_y;
+  double radius_squared = brush_radius_ * brush_radius_;
+
+  for (size_t row = first_row; row < last_row; ++row) {
+    for (size_t col = first_col; col < last_col; ++col) {
+      double center_x = double(col) + 0.5;
+      double center_y = double(row) + 0.5;
+
+      // Projects the center onto the segment to find the closest point on it
+      double along = 0.0;
+
+      if (length_squared > 0.0) {
+        along = ((center_x - start_x) * delta_x +
+                 (center_y - start_y) * delta_y) /
+                length_squared;
+        along = std::max(0.0, std::min(1.0, along));
+      }
+
+      double offset_x = center_x - (start_x + along * delta_x);
+      double offset_y = center_y - (start_y + along * delta_y);
+
+      if (offset_x * offset_x + offset_y * offset_y <= radius_squared) {
+        pixel_grid_[row][col] = Pixel::kShaded;
+      }
+    }
+  }
+}
+
+void SketchGrid::PixelRange(double low, double high, size_t &first,
+                            size_t &last) const {
+  double side = double(num_pixels_per_side_);
+
+  // Pixel i is centered at i + 0.5, so it is in range for low <= i + 0.5
+  // and i + 0.5 <= high
+  double first_index = std::ceil(low - 0.5);
+  double last_index = std::floor(high - 0.5) + 1.0;
+
+  first = size_t(std::max(0.0, std::min(side, first_index)));
+  last = size_t(std::max(0.0, std::min(side, last_index)));
+
+  if (last < first) {
+    last = first;
+  }
+}
+
+void SketchGrid::Clear() {
+  for (std::vector<Pixel> &row : pixel_grid_) {
+    std::fill(row.begin(), row.end(), Pixel::kUnshaded);
+  }
+}
+
+const std::vector<std::vector<Pixel>> &SketchGrid::GetPixelGrid() const {
+  return pixel_grid_;
+}
+
+size_t SketchGrid::GetNumPixelsPerSide() const { return num_pixels_per_side_; }
+
+double SketchGrid::GetBrushRadius() const { return brush_radius_; }
+
+} // namespace naivebayes
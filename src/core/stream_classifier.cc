@@ -0,0 +1,267 @@
+#include "core/stream_classifier.h"
+
+#include <algorithm>
+#include <core/memory_accounting.h>
+#include <core/metrics.h>
+#include <core/parallel.h>
+#include <core/row_decoder.h>
+#include <core/tracer.h>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace naivebayes {
+
+namespace {
+
+// The number of bytes read from the input stream at a time
+const size_t kReadSize = size_t(1) << 20;
+
+/**
+ * Checks whether a range of bytes holds nothing but line breaks and spaces
+ *
+ * @param begin the first byte of the range
+ * @param end the byte just past the range
+ * @return true if there is nothing to classify in the range
+ */
+bool IsBlank(const char *begin, const char *end) {
+  return std::all_of(begin, end, [](char character) {
+    return character == '\n' || character == '\r' || character == ' ';
+  });
+}
+
+} // namespace
+
+StreamClassifier::StreamClassifier(const LogProbTable &table,
+                                   size_t num_threads, size_t batch_size)
+    : table_(table), scorer_(table),
+      num_threads_(ResolveNumThreads(num_threads)),
+      batch_size_(std::max<size_t>(1, batch_size)) {}
+
+size_t StreamClassifier::Classify(std::istream &input, std::ostream &output,
+                                  StreamFormat format,
+                                  bool write_scores) const {
+  static Counter &images_classified =
+      MetricsRegistry::Global().GetCounter("naivebayes_images_classified_total",
+                                           "Images classified from streams");
+  SubsystemScope subsystem(Subsystem::kEvaluator);
+
+  size_t image_size = table_.GetImageSize();
+
+  if (image_size == 0) {
+    throw std::invalid_argument("Cannot classify with an untrained model");
+  }
+
+  std::string buffer;
+  size_t begin = 0;
+  bool is_end_of_stream = false;
+  std::vector<size_t> image_offsets;
+  // Every chunk of a batch formats its predictions separately, so they can be
+  // written out in input order
+  std::vector<std::string> chunk_output(num_threads_);
+  size_t num_images = 0;
+
+  while (true) {
+    FindImages(buffer, begin, format, is_end_of_stream, image_offsets);
+    size_t batch_images = image_offsets.empty() ? 0 : image_offsets.size() - 1;
+
+    if (batch_images < batch_size_ && !is_end_of_stream) {
+      TraceScope trace("classifier", "ReadBlock");
+
+      // Drops the classified bytes so the buffer only grows to about a batch
+      buffer.erase(0, begin);
+      begin = 0;
+
+      size_t buffer_size = buffer.size();
+      buffer.resize(buffer_size + kReadSize);
+      input.read(&buffer[buffer_size], std::streamsize(kReadSize));
+      buffer.resize(buffer_size + size_t(input.gcount()));
+      is_end_of_stream = !input;
+      continue;
+    }
+
+    if (batch_images == 0) {
+      if (!IsBlank(buffer.data() + begin, buffer.data() + buffer.size())) {
+        throw std::invalid_argument("Stream ends with a truncated image");
+      }
+
+      break;
+    }
+
+    TraceScope trace("classifier", "ScoreBatch");
+
+    size_t num_chunks = ParallelFor(
+        batch_images, num_threads_,
+        [&](size_t chunk, size_t chunk_begin, size_t chunk_end) {
+          SubsystemScope chunk_subsystem(Subsystem::kEvaluator);
+          std::string &predictions = chunk_output[chunk];
+          size_t num_pixels = image_size * image_size;
+          size_t chunk_images = chunk_end - chunk_begin;
+          std::vector<uint8_t> pixels(chunk_images * num_pixels);
+          std::vector<float> scores;
+          std::vector<size_t> chunk_predictions;
+          char score_text[32];
+
+          predictions.clear();
+
+          for (size_t image = chunk_begin; image < chunk_end; ++image) {
+            try {
+              DecodeImage(buffer.data() + image_offsets[image],
+                          buffer.data() + image_offsets[image + 1], format,
+                          pixels.data() + (image - chunk_begin) * num_pixels);
+            } catch (const std::invalid_argument &error) {
+              throw std::invalid_argument(
+                  "Image " + std::to_string(num_images + image) + ": " +
+                  error.what());
+            }
+          }
+
+          size_t invalid_image = scorer_.FindInvalidImage(
+              pixels.data(), chunk_images, image_size, num_pixels);
+
+          if (invalid_image != chunk_images) {
+            throw std::invalid_argument(
+                "Image " +
+                std::to_string(num_images + chunk_begin + invalid_image) +
+                ": Image shade is not part of the model");
+          }
+
+          scorer_.ClassifyIndices(pixels.data(), chunk_images, image_size,
+                                  num_pixels, scores, chunk_predictions);
+          size_t num_labels = scorer_.GetLabelSet().Size();
+
+          for (size_t image = 0; image < chunk_images; ++image) {
+            predictions.push_back(
+                scorer_.GetLabelSet().LabelAt(chunk_predictions[image]));
+
+            for (size_t label = 0; write_scores && label < num_labels;
+                 ++label) {
+              std::snprintf(score_text, sizeof(score_text), "\t%.9g",
+                            double(scores[image * num_labels + label]));
+              predictions += score_text;
+            }
+
+            predictions.push_back('\n');
+          }
+        });
+
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      output.write(chunk_output[chunk].data(),
+                   std::streamsize(chunk_output[chunk].size()));
+    }
+
+    begin = image_offsets.back();
+    num_images += batch_images;
+    images_classified.Increment(batch_images);
+  }
+
+  output.flush();
+
+  return num_images;
+}
+
+void StreamClassifier::FindImages(const std::string &buffer, size_t begin,
+                                  StreamFormat format, bool is_end_of_stream,
+                                  std::vector<size_t> &image_offsets) const {
+  image_offsets.clear();
+  size_t image_size = table_.GetImageSize();
+
+  if (format == StreamFormat::kPacked) {
+    size_t record_size = (image_size * image_size + 3) / 4;
+    size_t num_records =
+        std::min(batch_size_, (buffer.size() - begin) / record_size);
+
+    for (size_t record = 0; record <= num_records; ++record) {
+      image_offsets.push_back(begin + record * record_size);
+    }
+
+    return;
+  }
+
+  const char *data = buffer.data();
+  size_t position = begin;
+
+  while (image_offsets.size() < batch_size_) {
+    // Blank lines between images are skipped
+    size_t start = position;
+
+    while (start < buffer.size() &&
+           (data[start] == '\n' || data[start] == '\r')) {
+      ++start;
+    }
+
+    size_t end = start;
+    bool is_complete = true;
+
+    // A label line followed by one line per row
+    for (size_t line = 0; line <= image_size && is_complete; ++line) {
+      const void *line_end =
+          std::memchr(data + end, '\n', buffer.size() - end);
+
+      if (line_end != nullptr) {
+        end = size_t(static_cast<const char *>(line_end) - data) + 1;
+      } else if (is_end_of_stream && line == image_size &&
+                 end < buffer.size()) {
+        // The last row of the stream may be missing its line break
+        end = buffer.size();
+      } else {
+        is_complete = false;
+      }
+    }
+
+    if (!is_complete) {
+      break;
+    }
+
+    image_offsets.push_back(start);
+    position = end;
+  }
+
+  if (!image_offsets.empty()) {
+    image_offsets.push_back(position);
+  }
+}
+
+void StreamClassifier::DecodeImage(const char *record, const char *record_end,
+                                   StreamFormat format,
+                                   uint8_t *pixels) const {
+  size_t image_size = table_.GetImageSize();
+
+  if (format == StreamFormat::kPacked) {
+    for (size_t pixel = 0; pixel < image_size * image_size; ++pixel) {
+      uint8_t packed = uint8_t(record[pixel / 4]);
+      pixels[pixel] = uint8_t((packed >> (2 * (pixel % 4))) & 3);
+    }
+
+    return;
+  }
+
+  // Skips the label line, which FindImages has checked is terminated
+  const char *line = static_cast<const char *>(std::memchr(
+      record, '\n', size_t(record_end - record)));
+  ++line;
+
+  for (size_t row = 0; row < image_size; ++row) {
+    const char *line_end = static_cast<const char *>(
+        std::memchr(line, '\n', size_t(record_end - line)));
+
+    if (line_end == nullptr) {
+      line_end = record_end;
+    }
+
+    size_t length = size_t(line_end - line);
+
+    if (length > 0 && line[length - 1] == '\r') {
+      --length;
+    }
+
+    if (length != image_size) {
+      throw std::invalid_argument("Image row does not match the model size");
+    }
+
+    DecodeRow(line, image_size, pixels + row * image_size);
+    line = line_end + 1;
+  }
+}
+
+} // namespace naivebayes
@@ -0,0 +1,151 @@
+#include "core/stroke_log.h"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace naivebayes {
+
+namespace {
+
+const char *const kEventNames[] = {"down", "drag", "predict", "clear"};
+
+/**
+ * Checks whether an event carries a brush position
+ *
+ * @param type the kind of event
+ * @return true for brush downs and drags
+ */
+bool IsBrushEvent(StrokeEventType type) {
+  return type == StrokeEventType::kBrushDown ||
+         type == StrokeEventType::kBrushDrag;
+}
+
+} // namespace
+
+StrokeRecorder::StrokeRecorder() : start_(std::chrono::steady_clock::now()) {}
+
+void StrokeRecorder::Record(StrokeEventType type, double x, double y) {
+  auto elapsed = std::chrono::steady_clock::now() - start_;
+  uint64_t time_us = uint64_t(
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+
+  events_.push_back({type, time_us, x, y});
+}
+
+const std::vector<StrokeEvent> &StrokeRecorder::GetEvents() const {
+  return events_;
+}
+
+void WriteStrokeLog(const std::vector<StrokeEvent> &events,
+                    std::ostream &output) {
+  std::streamsize precision = output.precision(9);
+
+  for (const StrokeEvent &event : events) {
+    output << event.time_us << " " << kEventNames[size_t(event.type)];
+
+    if (IsBrushEvent(event.type)) {
+      output << " " << event.x << " " << event.y;
+    }
+
+    output << "\n";
+  }
+
+  output.precision(precision);
+}
+
+std::vector<StrokeEvent> ReadStrokeLog(std::istream &input) {
+  std::vector<StrokeEvent> events;
+  std::string line;
+
+  while (std::getline(input, line)) {
+    std::istringstream line_stream(line);
+    std::string name;
+    StrokeEvent event = {StrokeEventType::kClear, 0, 0.0, 0.0};
+
+    if (!(line_stream >> event.time_us)) {
+      if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        continue;
+      }
+
+      throw std::invalid_argument("Stroke event is missing its time: " + line);
+    }
+
+    line_stream >> name;
+    size_t type = 0;
+
+    while (type < 4 && name != kEventNames[type]) {
+      ++type;
+    }
+
+    if (type == 4) {
+      throw std::invalid_argument("Unknown stroke event: " + line);
+    }
+
+    event.type = StrokeEventType(type);
+
+    if (IsBrushEvent(event.type) && !(line_stream >> event.x >> event.y)) {
+      throw std::invalid_argument("Brush event is missing its position: " +
+                                  line);
+    }
+
+    events.push_back(event);
+  }
+
+  return events;
+}
+
+StrokeReplayer::StrokeReplayer(SketchGrid &grid, Model &model)
+    : grid_(grid), model_(model), last_x_(0.0), last_y_(0.0) {}
+
+void StrokeReplayer::Apply(const StrokeEvent &event) {
+  switch (event.type) {
+  case StrokeEventType::kBrushDown: {
+    ScopedTimer timer(brush_latency_);
+    grid_.Brush(event.x, event.y);
+    break;
+  }
+  case StrokeEventType::kBrushDrag: {
+    ScopedTimer timer(brush_latency_);
+    grid_.BrushSegment(last_x_, last_y_, event.x, event.y);
+    break;
+  }
+  case StrokeEventType::kPredict: {
+    ScopedTimer timer(predict_latency_);
+    predictions_.push_back(model_.Predict(grid_.GetPixelGrid()));
+    break;
+  }
+  case StrokeEventType::kClear: {
+    ScopedTimer timer(clear_latency_);
+    grid_.Clear();
+    break;
+  }
+  }
+
+  if (IsBrushEvent(event.type)) {
+    last_x_ = event.x;
+    last_y_ = event.y;
+  }
+}
+
+void StrokeReplayer::Replay(const std::vector<StrokeEvent> &events) {
+  for (const StrokeEvent &event : events) {
+    Apply(event);
+  }
+}
+
+const Histogram &StrokeReplayer::GetLatency(StrokeEventType type) const {
+  switch (type) {
+  case StrokeEventType::kPredict:
+    return predict_latency_;
+  case StrokeEventType::kClear:
+    return clear_latency_;
+  default:
+    return brush_latency_;
+  }
+}
+
+const std::string &StrokeReplayer::GetPredictions() const {
+  return predictions_;
+}
+
+} // namespace naivebayes
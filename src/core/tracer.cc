@@ -0,0 +1,160 @@
+#include "core/tracer.h"
+
+namespace naivebayes {
+
+const size_t Tracer::kBlockSize;
+
+Tracer::Block::Block() : size(0), next(nullptr) {}
+
+Tracer::ThreadBuffer::ThreadBuffer(size_t thread_id)
+    : thread_id(thread_id), head(new Block()), tail(head) {}
+
+Tracer::BufferLease::~BufferLease() {
+  if (buffer != nullptr) {
+    std::lock_guard<std::mutex> lock(tracer->buffers_mutex_);
+    tracer->released_buffers_.push_back(buffer);
+  }
+}
+
+Tracer::Tracer()
+    : is_enabled_(false), start_(std::chrono::steady_clock::now()) {}
+
+Tracer::~Tracer() {
+  for (ThreadBuffer *buffer : buffers_) {
+    Block *block = buffer->head;
+
+    while (block != nullptr) {
+      Block *next = block->next.load();
+      delete block;
+      block = next;
+    }
+
+    delete buffer;
+  }
+}
+
+Tracer &Tracer::Global() {
+  static Tracer tracer;
+  return tracer;
+}
+
+void Tracer::Enable() { is_enabled_.store(true, std::memory_order_relaxed); }
+
+void Tracer::Disable() { is_enabled_.store(false, std::memory_order_relaxed); }
+
+bool Tracer::IsEnabled() const {
+  return is_enabled_.load(std::memory_order_relaxed);
+}
+
+void Tracer::Record(const char *category, const char *name, char phase) {
+  auto elapsed = std::chrono::steady_clock::now() - start_;
+  ThreadBuffer &buffer = GetThreadBuffer();
+  Block *block = buffer.tail;
+  size_t size = block->size.load(std::memory_order_relaxed);
+
+  if (size == kBlockSize) {
+    Block *next = new Block();
+    block->next.store(next, std::memory_order_release);
+    buffer.tail = next;
+    block = next;
+    size = 0;
+  }
+
+  block->events[size] = {
+      name, category, phase,
+      uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                   .count())};
+  block->size.store(size + 1, std::memory_order_release);
+}
+
+void Tracer::WriteChromeTrace(std::ostream &output) const {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  std::string separator;
+
+  output << "{\"traceEvents\": [";
+
+  for (const ThreadBuffer *buffer : buffers_) {
+    const Block *block = buffer->head;
+
+    while (block != nullptr) {
+      size_t size = block->size.load(std::memory_order_acquire);
+
+      for (size_t event = 0; event < size; ++event) {
+        const TraceEvent &trace_event = block->events[event];
+
+        // Chrome traces are in microseconds
+        output << separator << "{\"name\": \"" << trace_event.name
+               << "\", \"cat\": \"" << trace_event.category
+               << "\", \"ph\": \"" << trace_event.phase
+               << "\", \"ts\": " << trace_event.timestamp_ns / 1000 << "."
+               << trace_event.timestamp_ns % 1000 / 100
+               << ", \"pid\": 1, \"tid\": " << buffer->thread_id << "}";
+        separator = ",\n";
+      }
+
+      block = block->next.load(std::memory_order_acquire);
+    }
+  }
+
+  output << "], \"displayTimeUnit\": \"ms\"}" << std::endl;
+}
+
+size_t Tracer::GetNumEvents() const {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  size_t num_events = 0;
+
+  for (const ThreadBuffer *buffer : buffers_) {
+    const Block *block = buffer->head;
+
+    while (block != nullptr) {
+      num_events += block->size.load(std::memory_order_acquire);
+      block = block->next.load(std::memory_order_acquire);
+    }
+  }
+
+  return num_events;
+}
+
+size_t Tracer::GetNumBuffers() const {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  return buffers_.size();
+}
+
+Tracer::ThreadBuffer &Tracer::GetThreadBuffer() {
+  thread_local BufferLease lease = {nullptr, nullptr};
+
+  // Taking a buffer locks once per thread, every later event is free. The
+  // mutex also orders the events of a released buffer before those of the
+  // thread that takes it
+  if (lease.buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+
+    if (!released_buffers_.empty()) {
+      lease.buffer = released_buffers_.back();
+      released_buffers_.pop_back();
+    } else {
+      lease.buffer = new ThreadBuffer(buffers_.size() + 1);
+      buffers_.push_back(lease.buffer);
+    }
+
+    lease.tracer = this;
+  }
+
+  return *lease.buffer;
+}
+
+TraceScope::TraceScope(const char *category, const char *name)
+    : category_(category), name_(name),
+      is_recording_(Tracer::Global().IsEnabled()) {
+  if (is_recording_) {
+    Tracer::Global().Record(category_, name_, 'B');
+  }
+}
+
+TraceScope::~TraceScope() {
+  if (is_recording_) {
+    Tracer::Global().Record(category_, name_, 'E');
+  }
+}
+
+} // namespace naivebayes
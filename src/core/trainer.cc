@@ -1,46 +1,51 @@
 #include "core/trainer.h"
+#include <core/memory_accounting.h>
+#include <core/tracer.h>
 #include <iostream>
 
 namespace naivebayes {
-Trainer::Trainer() { features_ = BuildStructure(0, 0, std::vector<char>{}); }
+Trainer::Trainer() : laplace_(kDefaultLaplace) {
+  SubsystemScope subsystem(Subsystem::kTrainer);
+  features_ = BuildStructure(0, 0, 0);
+}
 
 Trainer::Trainer(size_t image_size, size_t num_shades,
-                 const std::vector<char> &labels) {
-
-  features_ = BuildStructure(image_size, num_shades, labels);
+                 const std::vector<char> &labels, float laplace)
+    : laplace_(laplace), labels_(labels) {
+  // Trainers are built inside the model's scope, so their tables are claimed
+  // here rather than being counted against the model
+  SubsystemScope subsystem(Subsystem::kTrainer);
+  features_ = BuildStructure(image_size, num_shades, labels_.Size());
 }
 
-std::vector<std::vector<std::vector<std::map<char, float>>>>
-Trainer::GetFeatures() const {
-  return features_;
-}
+const FeatureVector &Trainer::GetFeatures() const { return features_; }
 
-std::map<char, float> Trainer::GetPriors() const { return priors_; }
+const std::vector<float> &Trainer::GetPriors() const { return priors_; }
 
 std::istream &operator>>(std::istream &input, Trainer &trainer) {
-
+  SubsystemScope subsystem(Subsystem::kTrainer);
   std::string current_line;
   size_t size = trainer.GetNextSizeT(input);
   size_t shades = trainer.GetNextSizeT(input);
   size_t num_labels = trainer.GetNextSizeT(input);
 
   std::vector<char> labels = trainer.GetFileLabels(input, num_labels);
-  trainer.labels_ = labels;
+  trainer.labels_ = LabelSet(labels);
 
   std::getline(input, current_line);
 
-  std::map<char, float> priors = trainer.GetFilePriors(input, labels);
-  trainer.priors_ = priors;
-  trainer.features_ = trainer.BuildStructure(size, shades, labels);
+  trainer.priors_ = trainer.GetFilePriors(input, labels);
+  trainer.features_ =
+      trainer.BuildStructure(size, shades, trainer.labels_.Size());
   size_t features = 0;
 
   for (size_t row = 0; row < trainer.features_.size(); ++row) {
     for (size_t col = 0; col < trainer.features_[row].size(); ++col) {
       for (size_t pixel = 0; pixel < trainer.features_[row][col].size();
            ++pixel) {
-        for (auto &label_itr : trainer.features_[row][col][pixel]) {
+        for (float &feature : trainer.features_[row][col][pixel]) {
           std::getline(input, current_line);
-          label_itr.second = std::stof(current_line);
+          feature = std::stof(current_line);
           ++features;
         }
       }
@@ -62,15 +67,15 @@ void Trainer::ValidateInputSize(size_t size, size_t num_shades,
   }
 }
 
-std::map<char, float> Trainer::GetFilePriors(std::istream &input,
-                                             const std::vector<char> &labels) {
+std::vector<float> Trainer::GetFilePriors(std::istream &input,
+                                          const std::vector<char> &labels) {
   std::string current_line;
 
-  std::map<char, float> priors;
+  std::vector<float> priors(labels_.Size(), 0.0f);
 
   for (char label : labels) {
     std::getline(input, current_line);
-    priors[label] = std::stof(current_line);
+    priors[labels_.IndexOf(label)] = std::stof(current_line);
   }
 
   return priors;
@@ -97,20 +102,17 @@ size_t Trainer::GetNextSizeT(std::istream &input) {
 
 std::ostream &operator<<(std::ostream &output, const Trainer &trainer) {
 
-  std::vector<std::vector<std::vector<std::map<char, float>>>> features =
-      trainer.features_;
-
-  std::map<char, float> priors = trainer.priors_;
+  const FeatureVector &features = trainer.features_;
 
-  for (auto &prior_itr : priors) {
-    output << prior_itr.second << std::endl;
+  for (float prior : trainer.priors_) {
+    output << prior << std::endl;
   }
 
   for (size_t row = 0; row < features.size(); ++row) {
     for (size_t col = 0; col < features[row].size(); ++col) {
       for (size_t pixel = 0; pixel < features[row][col].size(); ++pixel) {
-        for (const auto &label_itr : features[row][col][pixel]) {
-          output << label_itr.second << std::endl;
+        for (float feature : features[row][col][pixel]) {
+          output << feature << std::endl;
         }
       }
     }
@@ -121,37 +123,93 @@ std::ostream &operator<<(std::ostream &output, const Trainer &trainer) {
 
 void Trainer::CalculateFeatures(
     const std::map<char, std::vector<Image *>> &image_map) {
+  TraceScope trace("trainer", "CalculateFeatures");
+  SubsystemScope subsystem(Subsystem::kTrainer);
 
   for (size_t row = 0; row < features_.size(); ++row) {
     for (size_t col = 0; col < features_[row].size(); ++col) {
       for (size_t pixel = 0; pixel < features_[row][col].size(); ++pixel) {
-        for (auto &label_itr : features_[row][col][pixel]) {
+        for (size_t label = 0; label < labels_.Size(); ++label) {
 
-          const std::vector<Image *> &images = image_map.at(label_itr.first);
+          const std::vector<Image *> &images =
+              image_map.at(labels_.LabelAt(label));
           Pixel current_pixel = kPixelMap.at(pixel);
 
           size_t num_images =
               CountImagesWithPixel(row, col, current_pixel, images);
 
           float feature =
-              float(kLaplace + num_images) /
-              float(size_t(Pixel::kNumShades) * kLaplace + images.size());
+              float(laplace_ + num_images) /
+              float(size_t(Pixel::kNumShades) * laplace_ + images.size());
 
-          label_itr.second = feature;
+          features_[row][col][pixel][label] = feature;
         }
       }
     }
   }
 }
 
+void Trainer::CalculateFeatures(const FeatureCounts &counts) {
+  TraceScope trace("trainer", "CalculateFeatures");
+  SubsystemScope subsystem(Subsystem::kTrainer);
+
+  if (counts.GetImageSize() != features_.size()) {
+    throw std::invalid_argument("Counts size does not match the trainer");
+  }
+
+  // Translate each label to its index in the counts once up front
+  std::vector<size_t> count_indices;
+
+  for (char label : labels_.GetLabels()) {
+    count_indices.push_back(counts.GetLabelSet().IndexOf(label));
+  }
+
+  for (size_t row = 0; row < features_.size(); ++row) {
+    for (size_t col = 0; col < features_[row].size(); ++col) {
+      size_t position = row * features_.size() + col;
+
+      for (size_t pixel = 0; pixel < features_[row][col].size(); ++pixel) {
+        for (size_t label = 0; label < labels_.Size(); ++label) {
+
+          size_t count_label = count_indices[label];
+          size_t num_images =
+              counts.GetCountByIndex(count_label, position, pixel);
+          size_t label_total = counts.GetLabelTotalByIndex(count_label);
+
+          features_[row][col][pixel][label] =
+              float(laplace_ + num_images) /
+              float(size_t(Pixel::kNumShades) * laplace_ + label_total);
+        }
+      }
+    }
+  }
+}
+
+void Trainer::CalculatePriors(const FeatureCounts &counts) {
+  TraceScope trace("trainer", "CalculatePriors");
+  SubsystemScope subsystem(Subsystem::kTrainer);
+
+  priors_.assign(labels_.Size(), 0.0f);
+
+  for (size_t label = 0; label < labels_.Size(); ++label) {
+    priors_[label] =
+        float(laplace_ + counts.GetLabelTotal(labels_.LabelAt(label))) /
+        float(counts.GetLabelSet().Size() * laplace_ + counts.GetTotal());
+  }
+}
+
 void Trainer::CalculatePriors(
     const std::map<char, std::vector<Image *>> &image_map,
     size_t total_num_images) {
+  TraceScope trace("trainer", "CalculatePriors");
+  SubsystemScope subsystem(Subsystem::kTrainer);
+
+  priors_.assign(labels_.Size(), 0.0f);
 
   for (auto &image_itr : image_map) {
-    priors_[image_itr.first] =
-        float(kLaplace + image_itr.second.size()) /
-        float(image_map.size() * kLaplace + total_num_images);
+    priors_[labels_.IndexOf(image_itr.first)] =
+        float(laplace_ + image_itr.second.size()) /
+        float(image_map.size() * laplace_ + total_num_images);
   }
 }
 
@@ -171,20 +229,23 @@ size_t Trainer::CountImagesWithPixel(size_t row, size_t col, Pixel pixel,
 void Trainer::ClearValues() { features_.clear(); }
 
 FeatureVector Trainer::BuildStructure(size_t image_size, size_t num_shades,
-                                      const std::vector<char> &all_labels) {
-
-  std::map<char, float> labels;
-
-  for (char label : all_labels) {
-    labels[label] = 0.0f;
-  }
+                                      size_t num_labels) {
 
-  std::vector<std::map<char, float>> shades(num_shades, labels);
-  std::vector<std::vector<std::map<char, float>>> trainer_y(image_size, shades);
+  std::vector<float> labels(num_labels, 0.0f);
+  std::vector<std::vector<float>> shades(num_shades, labels);
+  std::vector<std::vector<std::vector<float>>> trainer_y(image_size, shades);
   FeatureVector trainer(image_size, trainer_y);
 
   return trainer;
 }
 
-std::vector<char> Trainer::GetLabels() const { return labels_; }
+const std::vector<char> &Trainer::GetLabels() const {
+  return labels_.GetLabels();
+}
+
+const LabelSet &Trainer::GetLabelSet() const { return labels_; }
+
+size_t Trainer::GetImageSize() const { return features_.size(); }
+
+float Trainer::GetLaplace() const { return laplace_; }
 } // namespace naivebayes
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include <visualizer/naive_bayes_app.h>
 
+#include <cstdlib>
+#include <fstream>
+
 namespace naivebayes {
 
 namespace visualizer {
@@ -10,8 +13,13 @@ NaiveBayesApp::NaiveBayesApp()
   ci::app::setWindowSize((int)kWindowSize, (int)kWindowSize);
 
   model_ = Model();
+#ifdef NAIVEBAYES_HAS_EMBEDDED_MODEL
+  model_.Load(GetEmbeddedModel());
+#else
   model_.Load("C:\\Users\\asawh\\Cinder\\my-projects\\naive-bayes-amit-"
               "sawhney\\saved\\saved_model.txt");
+#endif
+  model_.EnablePredictionCache(kPredictionCacheSize);
 }
 
 void NaiveBayesApp::draw() {
@@ -32,28 +40,46 @@ void NaiveBayesApp::draw() {
 }
 
 void NaiveBayesApp::mouseDown(ci::app::MouseEvent event) {
+  glm::vec2 brush_coords = sketchpad_.ToSketchCoords(event.getPos());
+  recorder_.Record(StrokeEventType::kBrushDown, brush_coords.x,
+                   brush_coords.y);
   sketchpad_.HandleBrush(event.getPos());
 }
 
 void NaiveBayesApp::mouseDrag(ci::app::MouseEvent event) {
-  sketchpad_.HandleBrush(event.getPos());
+  glm::vec2 brush_coords = sketchpad_.ToSketchCoords(event.getPos());
+  recorder_.Record(StrokeEventType::kBrushDrag, brush_coords.x,
+                   brush_coords.y);
+  sketchpad_.HandleDrag(event.getPos());
 }
 
 void NaiveBayesApp::keyDown(ci::app::KeyEvent event) {
   switch (event.getCode()) {
     case ci::app::KeyEvent::KEY_RETURN: {
-      std::vector<std::vector<Pixel>> pixels = sketchpad_.GetPixelGrid();
+      recorder_.Record(StrokeEventType::kPredict);
+      const std::vector<std::vector<Pixel>> &pixels =
+          sketchpad_.GetPixelGrid();
     
       // Convert char prediction and convert to numeric type
       current_prediction_ = model_.Predict(pixels) - '0';
       break;
   }
     case ci::app::KeyEvent::KEY_DELETE:
+      recorder_.Record(StrokeEventType::kClear);
       sketchpad_.Clear();
       break;
   }
 }
 
+void NaiveBayesApp::cleanup() {
+  const char *stroke_log_path = std::getenv("NAIVEBAYES_STROKE_LOG");
+
+  if (stroke_log_path != nullptr) {
+    std::ofstream stroke_log(stroke_log_path);
+    WriteStrokeLog(recorder_.GetEvents(), stroke_log);
+  }
+}
+
 } // namespace visualizer
 
 } // namespace naivebayes
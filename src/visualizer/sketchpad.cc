@@ -11,18 +11,15 @@ Sketchpad::Sketchpad(const vec2 &top_left_corner, size_t num_pixels_per_side,
     : top_left_corner_(top_left_corner),
       num_pixels_per_side_(num_pixels_per_side),
       pixel_side_length_(sketchpad_size / num_pixels_per_side),
-      brush_radius_(brush_radius) {
-
-  pixel_grid_ = std::vector<std::vector<Pixel>>(
-      num_pixels_per_side_,
-      std::vector<Pixel>(num_pixels_per_side_, Pixel::kUnshaded));
-}
+      grid_(num_pixels_per_side, brush_radius), last_brush_coords_(0, 0) {}
 
 void Sketchpad::Draw() const {
+  const std::vector<std::vector<Pixel>> &pixel_grid = grid_.GetPixelGrid();
+
   for (size_t row = 0; row < num_pixels_per_side_; ++row) {
     for (size_t col = 0; col < num_pixels_per_side_; ++col) {
       
-      if (pixel_grid_[row][col] == Pixel::kShaded) {
+      if (pixel_grid[row][col] == Pixel::kShaded) {
         ci::gl::color(ci::Color::gray(0.3f));
       } else {
         ci::gl::color(ci::Color("white"));
@@ -44,29 +41,26 @@ void Sketchpad::Draw() const {
 }
 
 void Sketchpad::HandleBrush(const vec2 &brush_screen_coords) {
-  vec2 brush_sketchpad_coords =
-      (brush_screen_coords - top_left_corner_) / (float)pixel_side_length_;
+  last_brush_coords_ = ToSketchCoords(brush_screen_coords);
+  grid_.Brush(last_brush_coords_.x, last_brush_coords_.y);
+}
 
-  for (size_t row = 0; row < num_pixels_per_side_; ++row) {
-    for (size_t col = 0; col < num_pixels_per_side_; ++col) {
-      vec2 pixel_center = {col + 0.5, row + 0.5};
+void Sketchpad::HandleDrag(const vec2 &brush_screen_coords) {
+  vec2 brush_sketchpad_coords = ToSketchCoords(brush_screen_coords);
 
-      if (glm::distance(brush_sketchpad_coords, pixel_center) <=
-          brush_radius_) {
-        pixel_grid_[row][col] = Pixel::kShaded;
-      }
-    }
-  }
+  grid_.BrushSegment(last_brush_coords_.x, last_brush_coords_.y,
+                     brush_sketchpad_coords.x, brush_sketchpad_coords.y);
+  last_brush_coords_ = brush_sketchpad_coords;
 }
 
-void Sketchpad::Clear() {
-  pixel_grid_ = std::vector<std::vector<Pixel>>(
-      num_pixels_per_side_,
-      std::vector<Pixel>(num_pixels_per_side_, Pixel::kUnshaded));
+vec2 Sketchpad::ToSketchCoords(const vec2 &screen_coords) const {
+  return (screen_coords - top_left_corner_) / (float)pixel_side_length_;
 }
 
-std::vector<std::vector<Pixel>> Sketchpad::GetPixelGrid() const {
-  return pixel_grid_;
+void Sketchpad::Clear() { grid_.Clear(); }
+
+const std::vector<std::vector<Pixel>> &Sketchpad::GetPixelGrid() const {
+  return grid_.GetPixelGrid();
 }
 
 } // namespace visualizer
@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include <core/batch_scorer.h>
+
+#include "test_helpers.h"
+
+using naivebayes::BatchScorer;
+using naivebayes::Image;
+using naivebayes::LogProbTable;
+
+/**
+ * Trains a model on 4x4 images of more labels than fit in one label block
+ *
+ * @param num_labels the number of labels to train
+ * @return the compiled table of the model
+ */
+LogProbTable TrainScorerTable(size_t num_labels) {
+  const std::string shades = " +#";
+  std::vector<Image> images;
+
+  for (size_t image = 0; image < num_labels * 3; ++image) {
+    std::vector<std::string> ascii_image(4, std::string(4, ' '));
+
+    for (size_t row = 0; row < 4; ++row) {
+      for (size_t col = 0; col < 4; ++col) {
+        ascii_image[row][col] = shades[(image * 5 + row * 7 + col * image) % 3];
+      }
+    }
+
+    images.emplace_back(ascii_image, char('A' + image % num_labels));
+  }
+
+  return TrainTable(images);
+}
+
+/**
+ * Builds a batch of images of one shade per byte with a padded row stride
+ *
+ * @param num_images the number of images
+ * @return the pixels, 6 bytes per row and 30 bytes per image
+ */
+std::vector<uint8_t> BuildScorerBatch(size_t num_images) {
+  std::vector<uint8_t> pixels(num_images * 30, 7);
+
+  for (size_t image = 0; image < num_images; ++image) {
+    for (size_t row = 0; row < 4; ++row) {
+      for (size_t col = 0; col < 4; ++col) {
+        pixels[image * 30 + row * 6 + col] =
+            uint8_t((image * 11 + row * 3 + col * col) % 3);
+      }
+    }
+  }
+
+  return pixels;
+}
+
+TEST_CASE("Batch scorer equals per image scoring", "[batch]") {
+
+  for (size_t num_labels : {2, 16, 21}) {
+    LogProbTable table = TrainScorerTable(num_labels);
+    std::vector<uint8_t> pixels = BuildScorerBatch(150);
+
+    SECTION("Scores are identical for every tile shape with " +
+            std::to_string(num_labels) + " labels") {
+      for (size_t image_tile : {1, 7, 64}) {
+        for (size_t row_tile : {1, 3, 4}) {
+          BatchScorer scorer(table, image_tile, row_tile);
+          std::vector<float> scores;
+          scorer.Score(pixels.data(), 150, 6, 30, scores);
+
+          REQUIRE(scores.size() == 150 * num_labels);
+
+          std::vector<float> image_scores;
+
+          for (size_t image = 0; image < 150; ++image) {
+            table.Score(pixels.data() + image * 30, 6, image_scores);
+
+            REQUIRE(std::equal(image_scores.begin(), image_scores.end(),
+                               scores.begin() + image * num_labels));
+          }
+        }
+      }
+    }
+
+    SECTION("Predictions equal per image classification with " +
+            std::to_string(num_labels) + " labels") {
+      BatchScorer scorer(table);
+      std::vector<float> scores;
+      std::vector<size_t> predictions;
+      scorer.ClassifyIndices(pixels.data(), 150, 6, 30, scores, predictions);
+
+      std::vector<float> image_scores;
+
+      for (size_t image = 0; image < 150; ++image) {
+        REQUIRE(predictions[image] ==
+                table.ClassifyIndex(pixels.data() + image * 30, 6,
+                                    image_scores));
+      }
+    }
+  }
+}
+
+TEST_CASE("Batch scorer rejects invalid shades", "[batch]") {
+  LogProbTable table = TrainScorerTable(3);
+  BatchScorer scorer(table);
+  std::vector<uint8_t> pixels = BuildScorerBatch(10);
+  pixels[6 * 30 + 2 * 6 + 3] = 3;
+
+  SECTION("The first invalid image is found") {
+    REQUIRE(scorer.FindInvalidImage(pixels.data(), 10, 6, 30) == 6);
+    REQUIRE(scorer.FindInvalidImage(pixels.data(), 6, 6, 30) == 6);
+  }
+
+  SECTION("Scoring a batch with an invalid image throws") {
+    std::vector<float> scores;
+
+    REQUIRE_THROWS_AS(scorer.Score(pixels.data(), 10, 6, 30, scores),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+
+#include <core/c_api.h>
+#include <core/model.h>
+#include <sstream>
+
+using naivebayes::Model;
+
+TEST_CASE("C interface", "[capi]") {
+  std::stringstream training_stream("0\n###\n# #\n###\n"
+                                    "1\n # \n # \n # \n"
+                                    "1\n ##\n # \n # \n");
+  Model model;
+  training_stream >> model;
+  model.Train();
+
+  std::stringstream saved_stream;
+  saved_stream << model;
+  std::string saved_model = saved_stream.str();
+
+  naivebayes_model *handle = nullptr;
+  REQUIRE(naivebayes_model_load_buffer(saved_model.data(), saved_model.size(),
+                                       &handle) == NAIVEBAYES_OK);
+
+  SECTION("Model dimensions are exposed") {
+    REQUIRE(naivebayes_model_image_size(handle) == 3);
+    REQUIRE(naivebayes_model_num_labels(handle) == 2);
+    REQUIRE(naivebayes_model_label(handle, 1) == '1');
+    REQUIRE(naivebayes_model_label(handle, 2) == '\0');
+  }
+
+  SECTION("Single images are predicted with a row stride") {
+    // Each row is padded to 4 bytes
+    const uint8_t zero[] = {2, 2, 2, 9, 2, 0, 2, 9, 2, 2, 2, 9};
+    const uint8_t one[] = {0, 2, 0, 9, 0, 2, 0, 9, 0, 2, 0, 9};
+    char label = 0;
+
+    REQUIRE(naivebayes_predict(handle, zero, 4, &label) == NAIVEBAYES_OK);
+    REQUIRE(label == model.Predict({"###", "# #", "###"}));
+    REQUIRE(naivebayes_predict(handle, one, 4, &label) == NAIVEBAYES_OK);
+    REQUIRE(label == '1');
+  }
+
+  SECTION("Batches of images are predicted with an image stride") {
+    const uint8_t images[] = {2, 2, 2, 2, 0, 2, 2, 2, 2, 7,
+                              0, 2, 0, 0, 2, 0, 0, 2, 0, 7};
+    char labels[2] = {0, 0};
+
+    REQUIRE(naivebayes_predict_batch(handle, images, 2, 3, 10, labels) ==
+            NAIVEBAYES_OK);
+    REQUIRE(labels[0] == '0');
+    REQUIRE(labels[1] == '1');
+  }
+
+  SECTION("Invalid pixels are reported") {
+    const uint8_t image[] = {2, 2, 2, 2, 5, 2, 2, 2, 2};
+    char label = 0;
+
+    REQUIRE(naivebayes_predict(handle, image, 3, &label) ==
+            NAIVEBAYES_INVALID_ARGUMENT);
+    REQUIRE(std::string(naivebayes_last_error()).find("shade") !=
+            std::string::npos);
+    REQUIRE(naivebayes_predict(handle, image, 2, &label) ==
+            NAIVEBAYES_INVALID_ARGUMENT);
+    REQUIRE(naivebayes_predict(handle, nullptr, 3, &label) ==
+            NAIVEBAYES_INVALID_ARGUMENT);
+  }
+
+  SECTION("Invalid models are rejected") {
+    std::string truncated = saved_model.substr(0, saved_model.size() / 2);
+    naivebayes_model *truncated_handle = nullptr;
+
+    REQUIRE(naivebayes_model_load_buffer(truncated.data(), truncated.size(),
+                                         &truncated_handle) ==
+            NAIVEBAYES_INVALID_MODEL);
+    REQUIRE(truncated_handle == nullptr);
+    REQUIRE(naivebayes_model_load("missing_model.txt", &truncated_handle) ==
+            NAIVEBAYES_IO_ERROR);
+  }
+
+  naivebayes_model_free(handle);
+}
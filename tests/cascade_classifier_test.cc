@@ -0,0 +1,136 @@
+#include <catch2/catch.hpp>
+
+#include <core/cascade_classifier.h>
+#include <limits>
+
+#include "test_helpers.h"
+
+using naivebayes::CascadeClassifier;
+using naivebayes::CascadeReport;
+using naivebayes::Image;
+using naivebayes::LogProbTable;
+using naivebayes::Pixel;
+
+/**
+ * Builds 8x8 images of three labels: a vertical bar, a horizontal bar and a
+ * filled square, with noise that makes some of them ambiguous
+ *
+ * @param num_images the number of images
+ * @param seed varies the noise between datasets
+ * @return the labeled images
+ */
+std::vector<Image> BuildCascadeImages(size_t num_images, size_t seed) {
+  std::vector<Image> images;
+
+  for (size_t image = 0; image < num_images; ++image) {
+    char label = char('0' + image % 3);
+    std::vector<std::string> ascii_image(8, std::string(8, ' '));
+
+    for (size_t row = 0; row < 8; ++row) {
+      for (size_t col = 0; col < 8; ++col) {
+        bool is_shaded = (label == '0' && col >= 3 && col <= 4) ||
+                         (label == '1' && row >= 3 && row <= 4) ||
+                         (label == '2' && row >= 2 && row <= 5 && col >= 2 &&
+                          col <= 5);
+        size_t noise = (image * 131 + row * 17 + col * 29 + seed * 7) % 11;
+
+        if (noise < image % 4) {
+          is_shaded = !is_shaded;
+        }
+
+        ascii_image[row][col] = is_shaded ? '#' : (noise == 10 ? '+' : ' ');
+      }
+    }
+
+    images.emplace_back(ascii_image, label);
+  }
+
+  return images;
+}
+
+TEST_CASE("Cascade downsampling", "[cascade]") {
+
+  SECTION("Squares are pooled to their rounded average shade") {
+    Image image({"##  ", "#+ +", "++  ", "+   "}, '3');
+    Image pooled = CascadeClassifier::Downsample(image, 2);
+
+    REQUIRE(pooled.GetSize() == 2);
+    REQUIRE(pooled.GetLabel() == '3');
+    REQUIRE(pooled.GetPixels() ==
+            std::vector<std::vector<Pixel>>{
+                {Pixel::kShaded, Pixel::kUnshaded},
+                {Pixel::kPartiallyShaded, Pixel::kUnshaded}});
+  }
+
+  SECTION("Pool factors that do not divide the image are rejected") {
+    Image image({"###", "###", "###"}, '3');
+
+    REQUIRE_THROWS_AS(CascadeClassifier::Downsample(image, 2),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(CascadeClassifier::Downsample(image, 0),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Cascade classification", "[cascade]") {
+  std::vector<Image> training_images = BuildCascadeImages(300, 1);
+  std::vector<Image> calibration_images = BuildCascadeImages(150, 2);
+  std::vector<Image> testing_images = BuildCascadeImages(150, 3);
+
+  LogProbTable full_table = TrainTable(training_images);
+  LogProbTable coarse_table =
+      CascadeClassifier::TrainCoarseTable(training_images, 2);
+
+  SECTION("The coarse model is trained on pooled images") {
+    REQUIRE(coarse_table.GetImageSize() == 4);
+    REQUIRE(coarse_table.GetLabels() == full_table.GetLabels());
+  }
+
+  SECTION("An infinite threshold always runs the full model") {
+    CascadeClassifier cascade(full_table, coarse_table, 2,
+                              std::numeric_limits<float>::infinity());
+    CascadeReport report = cascade.Evaluate(testing_images);
+
+    REQUIRE(report.num_full == 150);
+    REQUIRE(report.num_coarse == 0);
+    REQUIRE(report.num_disagreements == 0);
+    REQUIRE(report.num_cascade_correct == report.num_full_correct);
+  }
+
+  SECTION("A zero threshold always uses the coarse model") {
+    CascadeClassifier cascade(full_table, coarse_table, 2, 0.0f);
+    CascadeReport report = cascade.Evaluate(testing_images);
+
+    REQUIRE(report.num_coarse == 150);
+    REQUIRE(report.num_full == 0);
+  }
+
+  SECTION("Calibration keeps the cascade within the agreement target") {
+    CascadeClassifier cascade(full_table, coarse_table, 2);
+    float threshold = cascade.Calibrate(calibration_images, 0.98);
+
+    REQUIRE(threshold == cascade.GetMarginThreshold());
+
+    CascadeReport report = cascade.Evaluate(calibration_images);
+
+    REQUIRE(report.num_disagreements <= 3);
+    // A calibration that sends every image to the full model is no cascade
+    REQUIRE(report.num_coarse > 0);
+    REQUIRE(report.num_coarse + report.num_full == 150);
+  }
+
+  SECTION("Full agreement only lets through images the models agree on") {
+    CascadeClassifier cascade(full_table, coarse_table, 2);
+    cascade.Calibrate(calibration_images, 1.0);
+
+    REQUIRE(cascade.Evaluate(calibration_images).num_disagreements == 0);
+  }
+
+  SECTION("Mismatched models are rejected") {
+    REQUIRE_THROWS_AS(CascadeClassifier(full_table, coarse_table, 4),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(CascadeClassifier(full_table, full_table, 1, 0.0f)
+                          .Classify(Image({"#"}, '0')),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,119 @@
+#include <catch2/catch.hpp>
+
+#include <core/dataset_reader.h>
+#include <core/model.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using naivebayes::DatasetReader;
+using naivebayes::FeatureCounts;
+using naivebayes::Model;
+
+const std::string kReaderTestFile = "dataset_reader_test_images.txt";
+
+/**
+ * Builds an ascii dataset of images with varied labels and pixels
+ *
+ * @param num_images the number of images in the dataset
+ * @param image_size the size of each image
+ * @return the dataset contents
+ */
+std::string BuildReaderDataset(size_t num_images, size_t image_size) {
+  const std::string shades = " +#";
+  std::string dataset;
+
+  for (size_t image = 0; image < num_images; ++image) {
+    dataset += char('0' + image * 7 % 10);
+    dataset += '\n';
+
+    for (size_t row = 0; row < image_size; ++row) {
+      for (size_t col = 0; col < image_size; ++col) {
+        dataset += shades[(image * 31 + row * 5 + col * 3) % shades.size()];
+      }
+      dataset += '\n';
+    }
+  }
+
+  return dataset;
+}
+
+/**
+ * Serializes counts so that two sets of counts can be compared
+ *
+ * @param counts the counts to serialize
+ * @return the serialized counts
+ */
+std::string SerializeCounts(const FeatureCounts &counts) {
+  std::stringstream stream;
+  stream << counts;
+  return stream.str();
+}
+
+TEST_CASE("Dataset reader constructor", "[constructor][reader]") {
+
+  SECTION("Missing files are rejected") {
+    REQUIRE_THROWS_AS(DatasetReader("missing_dataset_file.txt"),
+                      std::invalid_argument);
+  }
+
+  SECTION("Image size is read from the first image") {
+    std::ofstream(kReaderTestFile) << BuildReaderDataset(3, 5);
+
+    DatasetReader reader(kReaderTestFile);
+
+    REQUIRE(reader.GetImageSize() == 5);
+    std::remove(kReaderTestFile.c_str());
+  }
+}
+
+TEST_CASE("Dataset reader byte ranges", "[reader]") {
+  std::ofstream(kReaderTestFile) << BuildReaderDataset(10, 4);
+  DatasetReader reader(kReaderTestFile);
+
+  std::vector<std::pair<size_t, size_t>> ranges = reader.SplitRanges(3);
+
+  REQUIRE(ranges.size() == 3);
+  REQUIRE(ranges.front().first == 0);
+  REQUIRE(ranges.back().second == reader.GetFileSize());
+
+  for (size_t range = 1; range < ranges.size(); ++range) {
+    REQUIRE(ranges[range].first == ranges[range - 1].second);
+  }
+
+  std::remove(kReaderTestFile.c_str());
+}
+
+TEST_CASE("Dataset reader counts", "[reader][counts]") {
+  std::string dataset = BuildReaderDataset(57, 4);
+  std::ofstream(kReaderTestFile) << dataset;
+
+  std::stringstream dataset_stream(dataset);
+  Model model;
+  dataset_stream >> model;
+  std::string expected = SerializeCounts(model.CountFeatures());
+
+  DatasetReader reader(kReaderTestFile);
+
+  SECTION("Any number of ranges counts every image exactly once") {
+    for (size_t num_threads = 1; num_threads <= 16; ++num_threads) {
+      REQUIRE(SerializeCounts(reader.CountFeatures(num_threads)) == expected);
+    }
+  }
+
+  SECTION("More ranges than images still counts every image") {
+    REQUIRE(SerializeCounts(reader.CountFeatures(500)) == expected);
+  }
+
+  std::remove(kReaderTestFile.c_str());
+}
+
+TEST_CASE("Dataset reader rejects truncated images", "[reader]") {
+  std::string dataset = BuildReaderDataset(4, 4);
+  std::ofstream(kReaderTestFile) << dataset.substr(0, dataset.size() - 6);
+
+  DatasetReader reader(kReaderTestFile);
+
+  REQUIRE_THROWS_AS(reader.CountFeatures(1), std::invalid_argument);
+  std::remove(kReaderTestFile.c_str());
+}
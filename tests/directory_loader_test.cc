@@ -0,0 +1,172 @@
+#include <catch2/catch.hpp>
+
+#include <core/directory_loader.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+using naivebayes::DirectoryLoader;
+using naivebayes::FeatureCounts;
+using naivebayes::Image;
+using naivebayes::IoBackend;
+
+const std::string kLoaderTestDirectory = "directory_loader_test_images";
+
+/**
+ * Writes one image file per image into the test directory
+ *
+ * @param num_images the number of image files to write
+ * @param image_size the size of each image
+ * @return the paths of the files written, in sorted order
+ */
+std::vector<std::string> WriteImageFiles(size_t num_images,
+                                         size_t image_size) {
+#ifdef _WIN32
+  _mkdir(kLoaderTestDirectory.c_str());
+#else
+  mkdir(kLoaderTestDirectory.c_str(), 0755);
+#endif
+
+  const std::string shades = " +#";
+  std::vector<std::string> file_paths;
+
+  for (size_t image = 0; image < num_images; ++image) {
+    char file_name[32];
+    std::snprintf(file_name, sizeof(file_name), "/%05zu.txt", image);
+    file_paths.push_back(kLoaderTestDirectory + file_name);
+
+    std::ofstream file(file_paths.back(), std::ios::binary);
+    file << char('0' + image * 7 % 10) << '\n';
+
+    for (size_t row = 0; row < image_size; ++row) {
+      for (size_t col = 0; col < image_size; ++col) {
+        file << shades[(image * 31 + row * 5 + col * 3) % shades.size()];
+      }
+      file << '\n';
+    }
+  }
+
+  return file_paths;
+}
+
+/**
+ * Removes the image files and the test directory
+ *
+ * @param file_paths the files to remove
+ */
+void RemoveImageFiles(const std::vector<std::string> &file_paths) {
+  for (const std::string &file_path : file_paths) {
+    std::remove(file_path.c_str());
+  }
+
+#ifdef _WIN32
+  _rmdir(kLoaderTestDirectory.c_str());
+#else
+  rmdir(kLoaderTestDirectory.c_str());
+#endif
+}
+
+TEST_CASE("Directory loader decodes single image files", "[directory]") {
+
+  SECTION("Files decode to the same image as the ascii constructor") {
+    Image image = DirectoryLoader::DecodeImage("7\n#+ \n # \n  +\n");
+
+    REQUIRE(image.GetLabel() == '7');
+    REQUIRE(image.GetPixels() == Image({"#+ ", " # ", "  +"}, '7').GetPixels());
+  }
+
+  SECTION("Carriage returns and trailing blank lines are ignored") {
+    Image image = DirectoryLoader::DecodeImage("1\r\n##\r\n +\r\n\r\n\n");
+
+    REQUIRE(image.GetLabel() == '1');
+    REQUIRE(image.GetPixels() == Image({"##", " +"}, '1').GetPixels());
+  }
+
+  SECTION("Malformed files are rejected") {
+    REQUIRE_THROWS_AS(DirectoryLoader::DecodeImage(""), std::invalid_argument);
+    REQUIRE_THROWS_AS(DirectoryLoader::DecodeImage("1\n"),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(DirectoryLoader::DecodeImage("1\n##\n#\n"),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Directory loader reads directories", "[directory]") {
+  std::vector<std::string> file_paths = WriteImageFiles(300, 5);
+  std::ofstream(kLoaderTestDirectory + "/notes.md") << "not an image\n";
+
+  SECTION("Only files with the extension are loaded, in sorted order") {
+    DirectoryLoader loader(kLoaderTestDirectory);
+
+    REQUIRE(loader.GetFilePaths() == file_paths);
+  }
+
+  SECTION("Both backends load the same images") {
+    DirectoryLoader thread_pool_loader(kLoaderTestDirectory, ".txt",
+                                       IoBackend::kThreadPool, 64);
+    DirectoryLoader auto_loader(kLoaderTestDirectory, ".txt", IoBackend::kAuto,
+                                64);
+    std::vector<Image> thread_pool_images = thread_pool_loader.LoadImages(3);
+    std::vector<Image> auto_images = auto_loader.LoadImages(3);
+
+    REQUIRE(thread_pool_images.size() == 300);
+    REQUIRE(auto_images.size() == 300);
+
+    for (size_t image = 0; image < 300; ++image) {
+      std::ifstream file(file_paths[image]);
+      std::stringstream contents;
+      contents << file.rdbuf();
+      Image expected = DirectoryLoader::DecodeImage(contents.str());
+
+      REQUIRE(thread_pool_images[image].GetLabel() == expected.GetLabel());
+      REQUIRE(thread_pool_images[image].GetPixels() == expected.GetPixels());
+      REQUIRE(auto_images[image].GetLabel() == expected.GetLabel());
+      REQUIRE(auto_images[image].GetPixels() == expected.GetPixels());
+    }
+  }
+
+  SECTION("Counts equal counting the loaded images") {
+    DirectoryLoader loader(kLoaderTestDirectory, ".txt", IoBackend::kAuto, 7);
+
+    FeatureCounts expected;
+
+    for (const Image &image : loader.LoadImages(1)) {
+      expected.AddImage(image);
+    }
+
+    std::stringstream expected_stream;
+    expected_stream << expected;
+    std::stringstream counts_stream;
+    counts_stream << loader.CountFeatures(4);
+
+    REQUIRE(counts_stream.str() == expected_stream.str());
+  }
+
+  SECTION("Malformed files name the file that failed") {
+    std::ofstream(file_paths[42]) << "3\n##\n#\n";
+
+    try {
+      DirectoryLoader(kLoaderTestDirectory).LoadImages(2);
+      FAIL("The malformed file was loaded");
+    } catch (const std::invalid_argument &error) {
+      REQUIRE(std::string(error.what()).find(file_paths[42]) !=
+              std::string::npos);
+    }
+  }
+
+  std::remove((kLoaderTestDirectory + "/notes.md").c_str());
+  RemoveImageFiles(file_paths);
+}
+
+TEST_CASE("Directory loader rejects missing directories", "[directory]") {
+  REQUIRE_THROWS_AS(DirectoryLoader("directory_loader_missing_directory"),
+                    std::invalid_argument);
+  REQUIRE_FALSE(DirectoryLoader::IsDirectory("directory_loader_missing"));
+}
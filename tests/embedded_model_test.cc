@@ -0,0 +1,84 @@
+#include <catch2/catch.hpp>
+
+#include <core/embedded_model.h>
+#include <core/log_prob_table.h>
+#include <core/model.h>
+#include <sstream>
+
+#include "test_helpers.h"
+
+using naivebayes::EmbeddedModel;
+using naivebayes::Image;
+using naivebayes::LogProbTable;
+using naivebayes::Model;
+
+TEST_CASE("Embedded models", "[embedded]") {
+  std::stringstream training_stream(kSmallTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+
+  LogProbTable table(*model.GetTrainer());
+  EmbeddedModel embedded = {table.GetImageSize(),
+                            table.GetNumShades(),
+                            table.GetLabels().size(),
+                            table.GetLabels().data(),
+                            table.GetLogPriors().data(),
+                            table.GetLogFeatures().data()};
+
+  SECTION("Embedded tables score the same as the trainer") {
+    LogProbTable embedded_table(embedded);
+    Image image({"#+#", "  #", "## "}, '0');
+
+    std::vector<float> scores;
+    std::vector<float> embedded_scores;
+    table.Score(image, scores);
+    embedded_table.Score(image, embedded_scores);
+
+    REQUIRE(embedded_table.GetLabels() == table.GetLabels());
+    REQUIRE(embedded_scores == scores);
+  }
+
+  SECTION("Models predict from an embedded model") {
+    Model embedded_model;
+    embedded_model.Load(embedded);
+
+    REQUIRE(embedded_model.GetTrainer() == nullptr);
+    REQUIRE(embedded_model.GetVersion() != 0);
+    REQUIRE(embedded_model.Predict({"###", "# #", "###"}) ==
+            model.Predict({"###", "# #", "###"}));
+    REQUIRE(embedded_model.Predict({" # ", "## ", " # "}) == '1');
+  }
+
+  SECTION("Incomplete embedded models are rejected") {
+    embedded.log_features = nullptr;
+
+    REQUIRE_THROWS_AS(LogProbTable(embedded), std::invalid_argument);
+  }
+
+  SECTION("Unsorted labels are rejected") {
+    const char unsorted_labels[] = {'1', '0'};
+    embedded.labels = unsorted_labels;
+
+    REQUIRE_THROWS_AS(LogProbTable(embedded), std::invalid_argument);
+  }
+
+  SECTION("Generated source defines aligned constexpr tables") {
+    std::stringstream source;
+    naivebayes::WriteEmbeddedModel(table, "GetDigitsModel", source);
+
+    REQUIRE(source.str().find("alignas(64) constexpr float kLogFeatures[]") !=
+            std::string::npos);
+    REQUIRE(source.str().find("constexpr char kLabels[] = {48, 49, };") !=
+            std::string::npos);
+    REQUIRE(source.str().find("const EmbeddedModel &GetDigitsModel()") !=
+            std::string::npos);
+  }
+
+  SECTION("Function names must be identifiers") {
+    std::stringstream source;
+
+    REQUIRE_THROWS_AS(naivebayes::WriteEmbeddedModel(table, "1 model", source),
+                      std::invalid_argument);
+  }
+}
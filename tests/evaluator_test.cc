@@ -0,0 +1,229 @@
+#include <catch2/catch.hpp>
+
+#include <core/dataset_reader.h>
+#include <core/evaluator.h>
+#include <core/model.h>
+#include <sstream>
+
+#include "test_helpers.h"
+
+using naivebayes::DatasetReader;
+using naivebayes::Evaluator;
+using naivebayes::FeatureCounts;
+using naivebayes::Image;
+using naivebayes::LogProbTable;
+using naivebayes::Model;
+using naivebayes::ModelEvaluation;
+
+const std::string kEvaluatorTrainingSet =
+    kSmallTrainingSet + "1\n + \n + \n + \n";
+
+const std::string kEvaluatorTestingSet = "0\n###\n# #\n###\n"
+                                         "1\n # \n # \n # \n"
+                                         "0\n+++\n+ +\n+++\n"
+                                         "1\n## \n # \n###\n"
+                                         "0\n #+\n# #\n+# \n";
+
+/**
+ * Counts the correct predictions of a model one image at a time
+ *
+ * @param model the trained model
+ * @param testing_set the ascii dataset of testing images
+ * @return the number of correctly predicted images
+ */
+size_t CountCorrectPredictions(Model &model, const std::string &testing_set) {
+  std::stringstream testing_stream(testing_set);
+  Image image;
+  size_t num_correct = 0;
+
+  while (DatasetReader::ReadImage(testing_stream, image)) {
+    if (model.Predict(image.GetPixels()) == image.GetLabel()) {
+      ++num_correct;
+    }
+  }
+
+  return num_correct;
+}
+
+TEST_CASE("Dataset stream image reader", "[reader][evaluator]") {
+  std::stringstream testing_stream(kEvaluatorTestingSet + "\n");
+  Image image;
+  size_t num_images = 0;
+
+  while (DatasetReader::ReadImage(testing_stream, image)) {
+    REQUIRE(image.GetSize() == 3);
+    ++num_images;
+  }
+
+  REQUIRE(num_images == 5);
+}
+
+TEST_CASE("Evaluator scores several models in one pass", "[evaluator]") {
+  std::stringstream training_stream(kEvaluatorTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+
+  LogProbTable table(*model.GetTrainer());
+  size_t expected_correct =
+      CountCorrectPredictions(model, kEvaluatorTestingSet);
+
+  SECTION("Accuracy matches predicting one image at a time") {
+    for (size_t batch_size = 1; batch_size <= 6; ++batch_size) {
+      std::stringstream testing_stream(kEvaluatorTestingSet);
+      Evaluator evaluator(3, batch_size);
+
+      std::vector<ModelEvaluation> evaluations =
+          evaluator.Evaluate(testing_stream, {&table, &table});
+
+      REQUIRE(evaluations.size() == 2);
+      REQUIRE(evaluations[0].num_images == 5);
+      REQUIRE(evaluations[0].num_correct == expected_correct);
+      REQUIRE(evaluations[1].num_correct == expected_correct);
+      REQUIRE(evaluations[0].confusion_matrix.at('0').size() > 0);
+    }
+  }
+
+  SECTION("Malformed testing images are rejected") {
+    std::stringstream testing_stream("0\n###\n# #\n");
+    Evaluator evaluator;
+
+    REQUIRE_THROWS_AS(evaluator.Evaluate(testing_stream, {&table}),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Laplace smoothing sweep", "[evaluator][laplace]") {
+  std::stringstream training_stream(kEvaluatorTrainingSet);
+  Model counted_model;
+  training_stream >> counted_model;
+  FeatureCounts counts = counted_model.CountFeatures();
+
+  SECTION("Every smoothing value matches a model trained with it") {
+    std::vector<float> laplace_values{0.1f, 1.0f, 5.0f};
+
+    std::stringstream testing_stream(kEvaluatorTestingSet);
+    std::vector<ModelEvaluation> evaluations =
+        Evaluator(2).SweepLaplace(counts, laplace_values, testing_stream);
+
+    REQUIRE(evaluations.size() == laplace_values.size());
+
+    for (size_t value = 0; value < laplace_values.size(); ++value) {
+      Model model;
+      model.Train(counts, laplace_values[value]);
+
+      REQUIRE(evaluations[value].num_correct ==
+              CountCorrectPredictions(model, kEvaluatorTestingSet));
+    }
+  }
+
+  SECTION("Smoothing values must be positive") {
+    std::stringstream testing_stream(kEvaluatorTestingSet);
+
+    REQUIRE_THROWS_AS(Evaluator().SweepLaplace(counts, {0.0f}, testing_stream),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Learning curve", "[evaluator][curve]") {
+
+  SECTION("Every point matches a model trained on the first images") {
+    std::stringstream training_stream(kEvaluatorTrainingSet);
+    std::stringstream testing_stream(kEvaluatorTestingSet);
+
+    // Batches of three images end between the first two checkpoints
+    std::vector<naivebayes::LearningCurvePoint> curve =
+        Evaluator(2, 3).LearningCurve(training_stream, {4, 2, 100, 2},
+                                      testing_stream);
+
+    REQUIRE(curve.size() == 3);
+    REQUIRE(curve[0].num_training_images == 2);
+    REQUIRE(curve[1].num_training_images == 4);
+    REQUIRE(curve[2].num_training_images == 5);
+
+    for (const naivebayes::LearningCurvePoint &point : curve) {
+      // Every image of the training set is a label line and three rows,
+      // taking 14 characters with their newlines
+      std::stringstream prefix_stream(
+          kEvaluatorTrainingSet.substr(0, point.num_training_images * 14));
+      Model model;
+      prefix_stream >> model;
+      model.Train();
+
+      REQUIRE(point.evaluation.num_images == 5);
+      REQUIRE(point.evaluation.num_correct ==
+              CountCorrectPredictions(model, kEvaluatorTestingSet));
+    }
+  }
+
+  SECTION("Curves are written as CSV") {
+    std::vector<naivebayes::LearningCurvePoint> curve{
+        {10, ModelEvaluation{4, 3, 0.75f, {}}},
+        {20, ModelEvaluation{4, 4, 1.0f, {}}}};
+
+    std::stringstream output;
+    Evaluator::WriteLearningCurve(output, curve);
+
+    REQUIRE(output.str() == "training_images,testing_images,correct,accuracy\n"
+                            "10,4,3,0.75\n"
+                            "20,4,4,1\n");
+  }
+
+  SECTION("Checkpoints must be positive") {
+    std::stringstream training_stream(kEvaluatorTrainingSet);
+    std::stringstream testing_stream(kEvaluatorTestingSet);
+
+    REQUIRE_THROWS_AS(
+        Evaluator().LearningCurve(training_stream, {0, 2}, testing_stream),
+        std::invalid_argument);
+  }
+}
+
+TEST_CASE("Evaluator compares models side by side", "[evaluator][compare]") {
+  std::stringstream training_stream(kEvaluatorTrainingSet);
+  Model counted_model;
+  training_stream >> counted_model;
+  FeatureCounts counts = counted_model.CountFeatures();
+
+  Model smooth_model;
+  smooth_model.Train(counts, 1.0f);
+  Model sharp_model;
+  sharp_model.Train(counts, 0.01f);
+
+  LogProbTable smooth_table(*smooth_model.GetTrainer());
+  LogProbTable sharp_table(*sharp_model.GetTrainer());
+
+  std::stringstream testing_stream(kEvaluatorTestingSet);
+  naivebayes::ComparisonReport report =
+      Evaluator(2, 2).Compare(testing_stream, {&smooth_table, &sharp_table});
+
+  SECTION("Disagreements match predicting one image at a time") {
+    std::stringstream image_stream(kEvaluatorTestingSet);
+    Image image;
+    size_t expected_disagreements = 0;
+
+    while (DatasetReader::ReadImage(image_stream, image)) {
+      if (smooth_model.Predict(image.GetPixels()) !=
+          sharp_model.Predict(image.GetPixels())) {
+        ++expected_disagreements;
+      }
+    }
+
+    REQUIRE(report.disagreements.size() == 2);
+    REQUIRE(report.disagreements[0][0] == 0);
+    REQUIRE(report.disagreements[0][1] == expected_disagreements);
+    REQUIRE(report.disagreements[1][0] == expected_disagreements);
+  }
+
+  SECTION("Report lists every label and model") {
+    std::stringstream output;
+    Evaluator::PrintComparison(output, report, {"smooth", "sharp"});
+
+    std::string printed = output.str();
+
+    REQUIRE(printed.find("smooth  |  sharp  |  Delta") != std::string::npos);
+    REQUIRE(printed.find("\n0  |  ") != std::string::npos);
+    REQUIRE(printed.find("\n1  |  ") != std::string::npos);
+    REQUIRE(printed.find("\nAll  |  ") != std::string::npos);
+  }
+}
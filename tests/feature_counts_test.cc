@@ -0,0 +1,279 @@
+#include <catch2/catch.hpp>
+
+#include <core/feature_counts.h>
+#include <core/model.h>
+#include <sstream>
+
+#include "test_helpers.h"
+
+using naivebayes::CountingBackend;
+using naivebayes::FeatureCounts;
+using naivebayes::Image;
+using naivebayes::Model;
+
+TEST_CASE("Feature counts constructors", "[constructor][counts]") {
+
+  SECTION("Default counts are empty") {
+    FeatureCounts counts;
+
+    REQUIRE(counts.GetTotal() == 0);
+    REQUIRE(counts.GetLabels().empty());
+  }
+
+  SECTION("Labels are sorted and start at zero") {
+    FeatureCounts counts(2, 3, {'1', '0'});
+
+    REQUIRE(counts.GetLabels() == std::vector<char>{'0', '1'});
+    REQUIRE(counts.GetCount('1', 1, 1, 2) == 0);
+    REQUIRE(counts.GetLabelTotal('0') == 0);
+  }
+}
+
+TEST_CASE("Feature counts add images", "[counts]") {
+
+  SECTION("Pixels are counted per label and shade") {
+    FeatureCounts counts;
+
+    counts.AddImage(Image({"#+", "  "}, '1'));
+    counts.AddImage(Image({"##", "  "}, '1'));
+    counts.AddImage(Image({"  ", "++"}, '0'));
+
+    REQUIRE(counts.GetLabels() == std::vector<char>{'0', '1'});
+    REQUIRE(counts.GetTotal() == 3);
+    REQUIRE(counts.GetLabelTotal('1') == 2);
+    REQUIRE(counts.GetCount('1', 0, 0, 2) == 2);
+    REQUIRE(counts.GetCount('1', 0, 1, 1) == 1);
+    REQUIRE(counts.GetCount('1', 0, 1, 2) == 1);
+    REQUIRE(counts.GetCount('0', 1, 0, 1) == 1);
+    REQUIRE(counts.GetCount('0', 0, 0, 0) == 1);
+  }
+
+  SECTION("Mismatched image sizes are rejected") {
+    FeatureCounts counts;
+    counts.AddImage(Image({"#+", "  "}, '1'));
+
+    REQUIRE_THROWS_AS(counts.AddImage(Image({"###", "   ", "   "}, '1')),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Feature counts merge", "[counts][merge]") {
+
+  SECTION("Merged shards equal counting everything at once") {
+    FeatureCounts first_shard;
+    first_shard.AddImage(Image({"#+", "  "}, '1'));
+
+    FeatureCounts second_shard;
+    second_shard.AddImage(Image({"  ", "++"}, '0'));
+    second_shard.AddImage(Image({"##", "  "}, '1'));
+
+    FeatureCounts all_images;
+    all_images.AddImage(Image({"#+", "  "}, '1'));
+    all_images.AddImage(Image({"  ", "++"}, '0'));
+    all_images.AddImage(Image({"##", "  "}, '1'));
+
+    FeatureCounts merged = FeatureCounts::Merge({first_shard, second_shard});
+
+    std::stringstream merged_stream;
+    merged_stream << merged;
+    std::stringstream expected_stream;
+    expected_stream << all_images;
+
+    REQUIRE(merged_stream.str() == expected_stream.str());
+  }
+
+  SECTION("Shards of different sizes cannot be merged") {
+    FeatureCounts first_shard;
+    first_shard.AddImage(Image({"#+", "  "}, '1'));
+
+    FeatureCounts second_shard;
+    second_shard.AddImage(Image({"###", "   ", "   "}, '1'));
+
+    REQUIRE_THROWS_AS(first_shard += second_shard, std::invalid_argument);
+  }
+}
+
+TEST_CASE("Feature counts subtraction", "[counts][subtract]") {
+
+  SECTION("Removing a shard leaves the other shard") {
+    FeatureCounts first_shard;
+    first_shard.AddImage(Image({"#+", "  "}, '1'));
+
+    FeatureCounts second_shard;
+    second_shard.AddImage(Image({"  ", "++"}, '0'));
+    second_shard.AddImage(Image({"##", "  "}, '1'));
+
+    FeatureCounts remaining = FeatureCounts::Merge({first_shard, second_shard});
+    remaining -= first_shard;
+
+    REQUIRE(remaining.GetLabels() == std::vector<char>{'0', '1'});
+    REQUIRE(remaining.GetTotal() == 2);
+    REQUIRE(remaining.GetLabelTotal('1') == 1);
+    REQUIRE(remaining.GetCount('1', 0, 1, 1) == 0);
+    REQUIRE(remaining.GetCount('1', 0, 1, 2) == 1);
+  }
+
+  SECTION("Counts that were never added cannot be removed") {
+    FeatureCounts counts;
+    counts.AddImage(Image({"#+", "  "}, '1'));
+
+    FeatureCounts other_label;
+    other_label.AddImage(Image({"#+", "  "}, '0'));
+
+    REQUIRE_THROWS_AS(counts -= other_label, std::invalid_argument);
+  }
+}
+
+TEST_CASE("Feature counts serialization", "[counts][istream][ostream]") {
+
+  SECTION("Counts are written in the expected format") {
+    FeatureCounts counts(1, 3, {'0', '1'});
+    counts.AddImage(Image({"#"}, '1'));
+
+    std::stringstream output;
+    output << counts;
+
+    REQUIRE(output.str() == "1\n3\n2\n0\n1\n\n0\n1\n0\n0\n0\n0\n0\n1\n");
+  }
+
+  SECTION("Counts survive a round trip") {
+    FeatureCounts counts;
+    counts.AddImage(Image({"#+", "  "}, '1'));
+    counts.AddImage(Image({"  ", "++"}, '0'));
+
+    std::stringstream stream;
+    stream << counts;
+
+    FeatureCounts loaded;
+    stream >> loaded;
+
+    REQUIRE(loaded.GetTotal() == 2);
+    REQUIRE(loaded.GetCount('1', 0, 1, 1) == 1);
+    REQUIRE(loaded.GetCount('0', 1, 1, 1) == 1);
+  }
+
+  SECTION("Truncated counts are rejected") {
+    std::stringstream stream("1\n3\n2\n0\n1\n\n0\n1\n0\n");
+
+    FeatureCounts loaded;
+
+    REQUIRE_THROWS_AS(stream >> loaded, std::invalid_argument);
+  }
+}
+
+TEST_CASE("Model trained from merged counts", "[counts][train]") {
+  // Every image of the set takes 14 characters
+  std::string first_half = kSmallTrainingSet.substr(0, 28);
+  std::string second_half = kSmallTrainingSet.substr(28);
+
+  std::stringstream whole_stream(kSmallTrainingSet);
+  Model whole_model;
+  whole_stream >> whole_model;
+  whole_model.Train();
+
+  std::stringstream first_stream(first_half);
+  Model first_model;
+  first_stream >> first_model;
+
+  std::stringstream second_stream(second_half);
+  Model second_model;
+  second_stream >> second_model;
+
+  Model merged_model;
+  merged_model.Train(FeatureCounts::Merge(
+      {first_model.CountFeatures(), second_model.CountFeatures()}));
+
+  REQUIRE(merged_model.GetTrainer()->GetFeatures() ==
+          whole_model.GetTrainer()->GetFeatures());
+  REQUIRE(merged_model.GetTrainer()->GetPriors() ==
+          whole_model.GetTrainer()->GetPriors());
+}
+
+TEST_CASE("Feature counts bit sliced backend", "[counts][bitsliced]") {
+  const std::string shades = " +#";
+  std::vector<Image> images;
+
+  // Enough images of the most common label to fill several bit slices
+  for (size_t image = 0; image < 300; ++image) {
+    std::vector<std::string> ascii_image(5, std::string(5, ' '));
+
+    for (size_t pixel = 0; pixel < 25; ++pixel) {
+      ascii_image[pixel / 5][pixel % 5] =
+          shades[(image * image * 7 + pixel * 13 + image / 3) % 3];
+    }
+
+    images.emplace_back(ascii_image, char('0' + image % 7 % 4));
+  }
+
+  std::vector<const Image *> image_pointers;
+
+  for (const Image &image : images) {
+    image_pointers.push_back(&image);
+  }
+
+  SECTION("Counts equal the scalar backend") {
+    FeatureCounts scalar_counts;
+    scalar_counts.AddImages(image_pointers, CountingBackend::kScalar);
+    FeatureCounts bit_sliced_counts;
+    bit_sliced_counts.AddImages(image_pointers, CountingBackend::kBitSliced);
+
+    std::stringstream scalar_stream;
+    scalar_stream << scalar_counts;
+    std::stringstream bit_sliced_stream;
+    bit_sliced_stream << bit_sliced_counts;
+
+    REQUIRE(bit_sliced_stream.str() == scalar_stream.str());
+    REQUIRE(bit_sliced_counts.GetTotal() == 300);
+  }
+
+  SECTION("Batches of every size up to a full slice equal the scalar backend") {
+    for (size_t num_images = 1; num_images <= 65; ++num_images) {
+      std::vector<const Image *> batch(image_pointers.begin(),
+                                       image_pointers.begin() + num_images);
+
+      FeatureCounts scalar_counts;
+      scalar_counts.AddImages(batch, CountingBackend::kScalar);
+      FeatureCounts bit_sliced_counts(5, 3, {'9'});
+      bit_sliced_counts.AddImages(batch);
+      bit_sliced_counts.AddImages(batch);
+      scalar_counts.AddImages(batch, CountingBackend::kScalar);
+
+      for (char label : scalar_counts.GetLabels()) {
+        REQUIRE(bit_sliced_counts.GetLabelTotal(label) ==
+                scalar_counts.GetLabelTotal(label));
+
+        for (size_t pixel = 0; pixel < 25; ++pixel) {
+          for (size_t shade = 0; shade < 3; ++shade) {
+            REQUIRE(bit_sliced_counts.GetCount(label, pixel / 5, pixel % 5,
+                                               shade) ==
+                    scalar_counts.GetCount(label, pixel / 5, pixel % 5, shade));
+          }
+        }
+      }
+    }
+  }
+
+  SECTION("Mismatched image sizes are rejected") {
+    Image larger({"###", "   ", "   "}, '1');
+    std::vector<const Image *> batch{image_pointers[0], &larger};
+    FeatureCounts counts;
+
+    REQUIRE_THROWS_AS(counts.AddImages(batch), std::invalid_argument);
+  }
+
+  SECTION("Models trained with either backend are identical") {
+    std::stringstream training_stream(WriteAsciiDataset(images));
+    std::stringstream second_stream(training_stream.str());
+    Model scalar_model;
+    training_stream >> scalar_model;
+    scalar_model.Train(CountingBackend::kScalar);
+    Model bit_sliced_model;
+    second_stream >> bit_sliced_model;
+    bit_sliced_model.Train(CountingBackend::kBitSliced);
+
+    REQUIRE(bit_sliced_model.GetTrainer()->GetFeatures() ==
+            scalar_model.GetTrainer()->GetFeatures());
+    REQUIRE(bit_sliced_model.GetTrainer()->GetPriors() ==
+            scalar_model.GetTrainer()->GetPriors());
+  }
+}
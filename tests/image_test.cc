@@ -1,6 +1,7 @@
 #include <catch2/catch.hpp>
 
 #include "core/image.h"
+#include <type_traits>
 
 using naivebayes::Pixel;
 using naivebayes::Image;
@@ -116,6 +117,20 @@ TEST_CASE("Training Image Move Constructor", "[constructor][move]") {
     REQUIRE(copy_image.GetSize() == 0);
     REQUIRE(copy_image.GetPixels().empty());
   }
+
+  SECTION("Pixels are transferred rather than copied") {
+    Image copy_image({"##", "++"}, '1');
+    const Pixel *pixel_data = copy_image.GetPixels()[0].data();
+
+    Image image = std::move(copy_image);
+
+    REQUIRE(image.GetPixels()[0].data() == pixel_data);
+  }
+
+  SECTION("Moves cannot throw") {
+    REQUIRE(std::is_nothrow_move_constructible<Image>::value);
+    REQUIRE(std::is_nothrow_move_assignable<Image>::value);
+  }
 }
 
 TEST_CASE("Training Image Copy Assignment operator",
@@ -233,6 +248,16 @@ TEST_CASE("Training Image Move Assignment operator") {
     REQUIRE(copy_image.GetSize() == 0);
     REQUIRE(copy_image.GetPixels().empty());
   }
+
+  SECTION("Self move assignment keeps the Training Image") {
+    Image image({"##", "++"}, '1');
+    Image &same_image = image;
+
+    image = std::move(same_image);
+
+    REQUIRE(image.GetLabel() == '1');
+    REQUIRE(image.GetSize() == 2);
+  }
 }
 
 TEST_CASE("Get Pixel Status", "[pixels]") {
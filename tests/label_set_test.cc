@@ -0,0 +1,55 @@
+#include <catch2/catch.hpp>
+
+#include <core/label_set.h>
+
+using naivebayes::LabelSet;
+
+TEST_CASE("Label set constructors", "[constructor][labels]") {
+
+  SECTION("Default label set is empty") {
+    LabelSet labels;
+
+    REQUIRE(labels.Empty());
+    REQUIRE(labels.Size() == 0);
+    REQUIRE_FALSE(labels.Contains('0'));
+  }
+
+  SECTION("Labels are sorted and deduplicated") {
+    LabelSet labels({'2', '0', '2', '1'});
+
+    REQUIRE(labels.GetLabels() == std::vector<char>{'0', '1', '2'});
+    REQUIRE(labels.IndexOf('0') == 0);
+    REQUIRE(labels.IndexOf('2') == 2);
+    REQUIRE(labels.LabelAt(1) == '1');
+  }
+}
+
+TEST_CASE("Label set lookups", "[labels]") {
+
+  SECTION("Adding a label shifts the labels after it") {
+    LabelSet labels({'0', '2'});
+
+    REQUIRE(labels.Add('1') == 1);
+    REQUIRE(labels.IndexOf('2') == 2);
+    REQUIRE(labels.Add('1') == 1);
+    REQUIRE(labels.Size() == 3);
+  }
+
+  SECTION("Labels outside of the ascii range are supported") {
+    LabelSet labels({char(-56), 'a'});
+
+    REQUIRE(labels.Contains(char(-56)));
+    REQUIRE(labels.LabelAt(labels.IndexOf(char(-56))) == char(-56));
+  }
+
+  SECTION("Unknown labels are rejected") {
+    LabelSet labels({'0'});
+
+    REQUIRE_THROWS_AS(labels.IndexOf('1'), std::out_of_range);
+    REQUIRE_THROWS_AS(labels.LabelAt(1), std::out_of_range);
+  }
+
+  SECTION("Label sets with the same labels are equal") {
+    REQUIRE(LabelSet({'1', '0'}) == LabelSet({'0', '1'}));
+  }
+}
@@ -0,0 +1,104 @@
+#include <catch2/catch.hpp>
+
+#include <core/log_prob_table.h>
+#include <core/model.h>
+#include <sstream>
+
+#include "test_helpers.h"
+
+using naivebayes::EarlyExitStats;
+using naivebayes::Image;
+using naivebayes::LogProbTable;
+using naivebayes::Model;
+
+const std::string kTableTrainingSet =
+    kSmallTrainingSet + "1\n + \n + \n + \n";
+
+TEST_CASE("Log prob table default constructor", "[constructor][table]") {
+  LogProbTable table;
+
+  REQUIRE(table.GetLabels().empty());
+  REQUIRE(table.GetImageSize() == 0);
+}
+
+TEST_CASE("Log prob table scoring", "[table]") {
+  std::stringstream training_stream(kTableTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+
+  LogProbTable table(*model.GetTrainer());
+
+  SECTION("Table dimensions match the trainer") {
+    REQUIRE(table.GetLabels() == std::vector<char>{'0', '1'});
+    REQUIRE(table.GetImageSize() == 3);
+    REQUIRE(table.GetNumShades() == 3);
+  }
+
+  SECTION("Scores equal the model likelihoods") {
+    Image image({"#+#", "# #", "#+#"}, '0');
+
+    std::vector<float> scores;
+    table.Score(image, scores);
+
+    REQUIRE(scores.size() == 2);
+    REQUIRE(scores[0] == model.CalculateLikelihood('0', image));
+    REQUIRE(scores[1] == model.CalculateLikelihood('1', image));
+  }
+
+  SECTION("Classifications equal the model predictions") {
+    std::vector<std::vector<std::string>> images{
+        {"#+#", "# #", "#+#"}, {" + ", " + ", " + "}, {"###", "   ", "###"}};
+
+    for (const std::vector<std::string> &ascii_image : images) {
+      REQUIRE(table.Classify(Image(ascii_image, 0)) ==
+              model.Predict(ascii_image));
+    }
+  }
+
+  SECTION("Images of the wrong size are rejected") {
+    std::vector<float> scores;
+
+    REQUIRE_THROWS_AS(table.Score(Image({"##", "##"}, '0'), scores),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Log prob table early exit classification", "[table][earlyexit]") {
+  std::stringstream training_stream(kTableTrainingSet +
+                                    "2\n## \n ##\n  #\n"
+                                    "3\n   \n+++\n   \n");
+  Model model;
+  training_stream >> model;
+  model.Train();
+
+  LogProbTable table(*model.GetTrainer());
+
+  SECTION("Predictions equal exhaustive scoring for every image") {
+    std::string shades = " +#";
+    EarlyExitStats stats = {0, 0, 0};
+
+    // Every possible 3x3 image, counting up in base 3
+    for (size_t code = 0; code < 19683; ++code) {
+      std::vector<std::string> ascii_image(3, std::string(3, ' '));
+      size_t remaining = code;
+
+      for (size_t pixel = 0; pixel < 9; ++pixel) {
+        ascii_image[pixel / 3][pixel % 3] = shades[remaining % 3];
+        remaining /= 3;
+      }
+
+      Image image(ascii_image, '0');
+      REQUIRE(table.ClassifyEarlyExit(image, &stats) == table.Classify(image));
+    }
+
+    REQUIRE(stats.num_images == 19683);
+    REQUIRE(stats.features_total == 19683 * 4 * 9);
+    REQUIRE(stats.features_scored < stats.features_total);
+  }
+
+  SECTION("Images of the wrong size are rejected") {
+    REQUIRE_THROWS_AS(table.ClassifyEarlyExit(Image({"##", "##"}, '0')),
+                      std::invalid_argument);
+  }
+}
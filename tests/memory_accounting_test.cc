@@ -0,0 +1,52 @@
+#include <catch2/catch.hpp>
+
+#include <core/memory_accounting.h>
+
+using naivebayes::AllocationTracker;
+using naivebayes::Subsystem;
+using naivebayes::SubsystemScope;
+
+TEST_CASE("Subsystem scopes", "[memory]") {
+
+  SECTION("Allocations default to other") {
+    REQUIRE(AllocationTracker::GetCurrentSubsystem() == Subsystem::kOther);
+  }
+
+  SECTION("Nested scopes restore the outer subsystem") {
+    SubsystemScope model_scope(Subsystem::kModel);
+
+    {
+      SubsystemScope trainer_scope(Subsystem::kTrainer);
+      REQUIRE(AllocationTracker::GetCurrentSubsystem() == Subsystem::kTrainer);
+    }
+
+    REQUIRE(AllocationTracker::GetCurrentSubsystem() == Subsystem::kModel);
+  }
+}
+
+TEST_CASE("Allocation accounting", "[memory]") {
+  size_t evaluator = size_t(Subsystem::kEvaluator);
+  AllocationTracker::Snapshot before = AllocationTracker::GetSnapshot();
+
+  AllocationTracker::RecordAllocation(Subsystem::kEvaluator, 100);
+  AllocationTracker::RecordAllocation(Subsystem::kEvaluator, 50);
+  AllocationTracker::RecordDeallocation(Subsystem::kEvaluator, 100);
+
+  AllocationTracker::Snapshot after = AllocationTracker::GetSnapshot();
+
+  REQUIRE(after[evaluator].allocations - before[evaluator].allocations == 2);
+  REQUIRE(after[evaluator].deallocations - before[evaluator].deallocations ==
+          1);
+  REQUIRE(after[evaluator].bytes_allocated -
+              before[evaluator].bytes_allocated ==
+          150);
+  REQUIRE(after[evaluator].live_bytes - before[evaluator].live_bytes == 50);
+  REQUIRE(after[evaluator].peak_live_bytes >=
+          before[evaluator].live_bytes + 150);
+
+  AllocationTracker::RecordDeallocation(Subsystem::kEvaluator, 50);
+}
+
+TEST_CASE("Peak resident set size", "[memory]") {
+  REQUIRE(AllocationTracker::GetPeakRss() > 0);
+}
@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include <core/metrics.h>
+#include <core/model.h>
+#include <sstream>
+
+#include "test_helpers.h"
+
+using naivebayes::Histogram;
+using naivebayes::MetricsFormat;
+using naivebayes::MetricsRegistry;
+
+TEST_CASE("Histogram buckets", "[metrics][histogram]") {
+
+  SECTION("Small values have a bucket each") {
+    for (uint64_t value = 0; value < Histogram::kSubBuckets; ++value) {
+      REQUIRE(Histogram::BucketUpperBound(Histogram::BucketIndex(value)) ==
+              value);
+    }
+  }
+
+  SECTION("Every value is at most its bucket's upper bound") {
+    for (uint64_t value : {16ull, 17ull, 100ull, 1000ull, 123456789ull,
+                           ~0ull}) {
+      size_t index = Histogram::BucketIndex(value);
+
+      REQUIRE(index < Histogram::kNumBuckets);
+      REQUIRE(value <= Histogram::BucketUpperBound(index));
+      REQUIRE(value > Histogram::BucketUpperBound(index - 1));
+    }
+  }
+}
+
+TEST_CASE("Histogram quantiles", "[metrics][histogram]") {
+  Histogram histogram;
+
+  SECTION("Empty histograms have no quantiles") {
+    REQUIRE(histogram.Quantile(0.5) == 0);
+  }
+
+  SECTION("Quantiles are within a bucket of the exact value") {
+    for (uint64_t value = 1; value <= 1000; ++value) {
+      histogram.Record(value);
+    }
+
+    REQUIRE(histogram.GetCount() == 1000);
+    REQUIRE(histogram.GetSum() == 500500);
+    REQUIRE(histogram.Quantile(0.5) >= 500);
+    REQUIRE(histogram.Quantile(0.5) <= 500 + 500 / Histogram::kSubBuckets);
+    REQUIRE(histogram.Quantile(0.99) >= 990);
+    REQUIRE(histogram.Quantile(1.0) >= 1000);
+  }
+}
+
+TEST_CASE("Metrics registry export", "[metrics]") {
+  MetricsRegistry registry;
+  registry.GetCounter("images_total", "Images").Increment(3);
+  registry.GetGauge("labels", "Labels").Set(10);
+  registry.GetHistogram("latency_ns", "Latency").Record(5);
+
+  SECTION("Metrics are shared by name") {
+    registry.GetCounter("images_total").Increment();
+
+    REQUIRE(registry.GetCounter("images_total").Get() == 4);
+  }
+
+  SECTION("Metrics are exported as JSON") {
+    std::stringstream output;
+    registry.Export(output, MetricsFormat::kJson);
+
+    REQUIRE(output.str() ==
+            "{\"counters\": {\"images_total\": 3}, \"gauges\": {\"labels\": "
+            "10}, \"histograms\": {\"latency_ns\": {\"count\": 1, \"sum\": 5, "
+            "\"p50\": 5, \"p99\": 5, \"p999\": 5}}}\n");
+  }
+
+  SECTION("Metrics are exported as Prometheus text") {
+    std::stringstream output;
+    registry.Export(output, MetricsFormat::kPrometheus);
+
+    std::string counter_text = "# TYPE images_total counter\nimages_total 3\n";
+
+    REQUIRE(output.str().find(counter_text) != std::string::npos);
+    REQUIRE(output.str().find("latency_ns{quantile=\"0.99\"} 5\n") !=
+            std::string::npos);
+    REQUIRE(output.str().find("latency_ns_count 1\n") != std::string::npos);
+  }
+}
+
+TEST_CASE("Model reports metrics", "[metrics][model]") {
+  MetricsRegistry &registry = MetricsRegistry::Global();
+  uint64_t predictions =
+      registry.GetCounter("naivebayes_predictions_total").Get();
+
+  std::stringstream training_stream(kSmallTrainingSet);
+  naivebayes::Model model;
+  training_stream >> model;
+  model.Train();
+  model.Predict(std::vector<std::string>{"#+#", "# #", "#+#"});
+
+  REQUIRE(registry.GetCounter("naivebayes_predictions_total").Get() ==
+          predictions + 1);
+  REQUIRE(registry.GetGauge("naivebayes_model_labels").Get() == 2);
+  REQUIRE(registry.GetHistogram("naivebayes_train_duration_ns").GetCount() > 0);
+}
@@ -2,6 +2,9 @@
 
 #include <core/model.h>
 #include <fstream>
+#include <sstream>
+
+#include "test_helpers.h"
 
 using naivebayes::Model;
 
@@ -53,7 +56,7 @@ TEST_CASE("Model Move Constructor", "[constructor][move]") {
 
     model.Train();
 
-    REQUIRE(model.GetTrainer()->GetFeatures()[0][0][0].at('0') ==
+    REQUIRE(model.GetTrainer()->GetFeatures()[0][0][0].at(0) ==
             Approx(0.16666667f));
     REQUIRE(copy_model.GetTrainer() == nullptr);
   }
@@ -127,9 +130,67 @@ TEST_CASE("Model move assignment operator", "[constructor][move][operator]") {
     model.Train();
 
     REQUIRE(model.GetTrainer() != nullptr);
-    REQUIRE(model.GetTrainer()->GetFeatures()[0][0][0].at('0') ==
+    REQUIRE(model.GetTrainer()->GetFeatures()[0][0][0].at(0) ==
             Approx(0.16666666667f));
   }
+
+  SECTION("Self move assignment keeps the Model") {
+    std::stringstream training_stream("0\n###\n# #\n###\n"
+                                      "1\n # \n # \n # \n");
+    Model model;
+    training_stream >> model;
+    model.Train();
+
+    Model &same_model = model;
+    model = std::move(same_model);
+
+    REQUIRE(model.GetTrainer() != nullptr);
+    REQUIRE(model.Predict({"###", "# #", "###"}) == '0');
+  }
+}
+
+TEST_CASE("Model ownership", "[constructor][copy][move]") {
+  std::stringstream training_stream("0\n###\n# #\n###\n"
+                                    "1\n # \n # \n # \n");
+  Model source;
+  training_stream >> source;
+  source.Train();
+
+  SECTION("Copies own a trainer of their own") {
+    Model *original = new Model(source);
+    Model copy(*original);
+
+    REQUIRE(copy.GetTrainer() != original->GetTrainer());
+
+    delete original;
+
+    REQUIRE(copy.GetTrainer()->GetLabels() == std::vector<char>{'0', '1'});
+    REQUIRE(copy.Predict({" # ", " # ", " # "}) == '1');
+  }
+
+  SECTION("Moved from models give up their trainer") {
+    Model target;
+    target = std::move(source);
+
+    REQUIRE(source.GetTrainer() == nullptr);
+    REQUIRE(target.GetTrainer() != nullptr);
+  }
+
+  SECTION("Retraining replaces the trainer") {
+    source.Train();
+
+    REQUIRE(source.GetTrainer()->GetPriors() ==
+            std::vector<float>{0.5f, 0.5f});
+  }
+
+  SECTION("Training images are viewed in place") {
+    const std::vector<naivebayes::Image *> &images =
+        source.GetTrainingImages('1');
+
+    REQUIRE(images.size() == 1);
+    REQUIRE(&images == &source.GetTrainingImages('1'));
+    REQUIRE_THROWS_AS(source.GetTrainingImages('7'), std::out_of_range);
+  }
 }
 
 TEST_CASE("Model istream operator", "[operator]") {
@@ -182,60 +243,60 @@ TEST_CASE("Model training", "[train][trainer]") {
     naivebayes::Trainer trainer(3, 3, {'0', '1'});
     naivebayes::FeatureVector expected_values = trainer.GetFeatures();
 
-    expected_values[0][0][0]['0'] = 0.166667f;
-    expected_values[0][0][0]['1'] = 0.333333f;
-    expected_values[0][0][1]['0'] = 0.333333f;
-    expected_values[0][0][1]['1'] = 0.416667f;
-    expected_values[0][0][2]['0'] = 0.5f;
-    expected_values[0][0][2]['1'] = 0.25f;
-    expected_values[0][1][0]['0'] = 0.166667f;
-    expected_values[0][1][0]['1'] = 0.0833333f;
-    expected_values[0][1][1]['0'] = 0.5f;
-    expected_values[0][1][1]['1'] = 0.333333f;
-    expected_values[0][1][2]['0'] = 0.333333f;
-    expected_values[0][1][2]['1'] = 0.583333f;
-    expected_values[0][2][0]['0'] = 0.166667f;
-    expected_values[0][2][0]['1'] = 0.833333f;
-    expected_values[0][2][1]['0'] = 0.333333f;
-    expected_values[0][2][1]['1'] = 0.0833333f;
-    expected_values[0][2][2]['0'] = 0.5f;
-    expected_values[0][2][2]['1'] = 0.0833333f;
-    expected_values[1][0][0]['0'] = 0.166667f;
-    expected_values[1][0][0]['1'] = 0.833333f;
-    expected_values[1][0][1]['0'] = 0.5f;
-    expected_values[1][0][1]['1'] = 0.0833333f;
-    expected_values[1][0][2]['0'] = 0.333333f;
-    expected_values[1][0][2]['1'] = 0.0833333f;
-    expected_values[1][1][0]['0'] = 0.666667f;
-    expected_values[1][1][0]['1'] = 0.0833333f;
-    expected_values[1][1][1]['0'] = 0.166667f;
-    expected_values[1][1][1]['1'] = 0.583333f;
-    expected_values[1][1][2]['0'] = 0.166667f;
-    expected_values[1][1][2]['1'] = 0.333333f;
-    expected_values[1][2][0]['0'] = 0.166667f;
-    expected_values[1][2][0]['1'] = 0.833333f;
-    expected_values[1][2][1]['0'] = 0.5f;
-    expected_values[1][2][1]['1'] = 0.0833333f;
-    expected_values[1][2][2]['0'] = 0.333333f;
-    expected_values[1][2][2]['1'] = 0.0833333f;
-    expected_values[2][0][0]['0'] = 0.166667f;
-    expected_values[2][0][0]['1'] = 0.583333f;
-    expected_values[2][0][1]['0'] = 0.333333f;
-    expected_values[2][0][1]['1'] = 0.166667f;
-    expected_values[2][0][2]['0'] = 0.5f;
-    expected_values[2][0][2]['1'] = 0.25f;
-    expected_values[2][1][0]['0'] = 0.166667f;
-    expected_values[2][1][0]['1'] = 0.0833333f;
-    expected_values[2][1][1]['0'] = 0.5f;
-    expected_values[2][1][1]['1'] = 0.333333f;
-    expected_values[2][1][2]['0'] = 0.333333f;
-    expected_values[2][1][2]['1'] = 0.583333f;
-    expected_values[2][2][0]['0'] = 0.166667f;
-    expected_values[2][2][0]['1'] = 0.583333f;
-    expected_values[2][2][1]['0'] = 0.333333f;
-    expected_values[2][2][1]['1'] = 0.166667f;
-    expected_values[2][2][2]['0'] = 0.5f;
-    expected_values[2][2][2]['1'] = 0.25f;
+    expected_values[0][0][0][0] = 0.166667f;
+    expected_values[0][0][0][1] = 0.333333f;
+    expected_values[0][0][1][0] = 0.333333f;
+    expected_values[0][0][1][1] = 0.416667f;
+    expected_values[0][0][2][0] = 0.5f;
+    expected_values[0][0][2][1] = 0.25f;
+    expected_values[0][1][0][0] = 0.166667f;
+    expected_values[0][1][0][1] = 0.0833333f;
+    expected_values[0][1][1][0] = 0.5f;
+    expected_values[0][1][1][1] = 0.333333f;
+    expected_values[0][1][2][0] = 0.333333f;
+    expected_values[0][1][2][1] = 0.583333f;
+    expected_values[0][2][0][0] = 0.166667f;
+    expected_values[0][2][0][1] = 0.833333f;
+    expected_values[0][2][1][0] = 0.333333f;
+    expected_values[0][2][1][1] = 0.0833333f;
+    expected_values[0][2][2][0] = 0.5f;
+    expected_values[0][2][2][1] = 0.0833333f;
+    expected_values[1][0][0][0] = 0.166667f;
+    expected_values[1][0][0][1] = 0.833333f;
+    expected_values[1][0][1][0] = 0.5f;
+    expected_values[1][0][1][1] = 0.0833333f;
+    expected_values[1][0][2][0] = 0.333333f;
+    expected_values[1][0][2][1] = 0.0833333f;
+    expected_values[1][1][0][0] = 0.666667f;
+    expected_values[1][1][0][1] = 0.0833333f;
+    expected_values[1][1][1][0] = 0.166667f;
+    expected_values[1][1][1][1] = 0.583333f;
+    expected_values[1][1][2][0] = 0.166667f;
+    expected_values[1][1][2][1] = 0.333333f;
+    expected_values[1][2][0][0] = 0.166667f;
+    expected_values[1][2][0][1] = 0.833333f;
+    expected_values[1][2][1][0] = 0.5f;
+    expected_values[1][2][1][1] = 0.0833333f;
+    expected_values[1][2][2][0] = 0.333333f;
+    expected_values[1][2][2][1] = 0.0833333f;
+    expected_values[2][0][0][0] = 0.166667f;
+    expected_values[2][0][0][1] = 0.583333f;
+    expected_values[2][0][1][0] = 0.333333f;
+    expected_values[2][0][1][1] = 0.166667f;
+    expected_values[2][0][2][0] = 0.5f;
+    expected_values[2][0][2][1] = 0.25f;
+    expected_values[2][1][0][0] = 0.166667f;
+    expected_values[2][1][0][1] = 0.0833333f;
+    expected_values[2][1][1][0] = 0.5f;
+    expected_values[2][1][1][1] = 0.333333f;
+    expected_values[2][1][2][0] = 0.333333f;
+    expected_values[2][1][2][1] = 0.583333f;
+    expected_values[2][2][0][0] = 0.166667f;
+    expected_values[2][2][0][1] = 0.583333f;
+    expected_values[2][2][1][0] = 0.333333f;
+    expected_values[2][2][1][1] = 0.166667f;
+    expected_values[2][2][2][0] = 0.5f;
+    expected_values[2][2][2][1] = 0.25f;
 
     naivebayes::FeatureVector model_trainer = model.GetTrainer()->GetFeatures();
 
@@ -246,10 +307,11 @@ TEST_CASE("Model training", "[train][trainer]") {
         for (size_t pixel = 0; pixel < model_trainer[row][col].size();
              ++pixel) {
 
-          for (auto &label_itr : model_trainer[row][col][pixel]) {
+          for (size_t label = 0; label < model_trainer[row][col][pixel].size();
+               ++label) {
 
-            REQUIRE(expected_values[row][col][pixel][label_itr.first] ==
-                    Approx(model_trainer[row][col][pixel][label_itr.first]));
+            REQUIRE(expected_values[row][col][pixel][label] ==
+                    Approx(model_trainer[row][col][pixel][label]));
           }
         }
       }
@@ -264,17 +326,13 @@ TEST_CASE("Model training", "[train][trainer]") {
 
     model.Train();
 
-    naivebayes::Trainer trainer(3, 3, {'0', '1'});
-    std::map<char, float> expected_values = trainer.GetPriors();
-
-    expected_values['0'] = 0.285714f;
-    expected_values['1'] = 0.714286f;
+    std::vector<float> expected_values{0.285714f, 0.714286f};
 
-    std::map<char, float> priors = model.GetTrainer()->GetPriors();
+    std::vector<float> priors = model.GetTrainer()->GetPriors();
 
     REQUIRE(priors.size() == 2);
-    REQUIRE(expected_values.at('0') == Approx(priors.at('0')));
-    REQUIRE(expected_values.at('1') == Approx(priors.at('1')));
+    REQUIRE(expected_values.at(0) == Approx(priors.at(0)));
+    REQUIRE(expected_values.at(1) == Approx(priors.at(1)));
   }
 }
 
@@ -299,8 +357,8 @@ TEST_CASE("Saving and loading model", "[save][trainer][ostream]") {
 
     REQUIRE(model.GetTrainer()->GetFeatures().size() ==
             saved_model.GetTrainer()->GetFeatures().size());
-    REQUIRE(model.GetTrainer()->GetFeatures()[0][0][0].at('0') ==
-            model.GetTrainer()->GetFeatures()[0][0][0].at('0'));
+    REQUIRE(model.GetTrainer()->GetFeatures()[0][0][0].at(0) ==
+            model.GetTrainer()->GetFeatures()[0][0][0].at(0));
   }
 }
 
@@ -449,4 +507,81 @@ TEST_CASE("Model prediction works", "[prediction]") {
 
     REQUIRE(accuracy > 0.7f);
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Model cross validation", "[crossvalidate]") {
+  std::string dataset = kSmallTrainingSet +
+                        "1\n + \n + \n + \n"
+                        "0\n#+#\n+ +\n###\n"
+                        "1\n # \n # \n # \n";
+
+  std::stringstream dataset_stream(dataset);
+  Model model;
+  dataset_stream >> model;
+
+  SECTION("Invalid numbers of folds are rejected") {
+    REQUIRE_THROWS_AS(model.CrossValidate(1), std::invalid_argument);
+    REQUIRE_THROWS_AS(model.CrossValidate(8), std::invalid_argument);
+  }
+
+  SECTION("Models without images are rejected") {
+    REQUIRE_THROWS_AS(Model().CrossValidate(2), std::invalid_argument);
+
+    std::stringstream empty_stream;
+    Model empty_model;
+
+    REQUIRE_THROWS_AS(empty_stream >> empty_model, std::invalid_argument);
+  }
+
+  SECTION("Every image is held out exactly once") {
+    naivebayes::CrossValidationReport report = model.CrossValidate(3);
+
+    REQUIRE(report.folds.size() == 3);
+
+    size_t num_images = 0;
+
+    for (const naivebayes::FoldResult &fold : report.folds) {
+      num_images += fold.num_images;
+    }
+
+    REQUIRE(num_images == 7);
+    REQUIRE(report.confusion_matrix.size() == 2);
+  }
+
+  SECTION("Leave one out matches retraining without each image") {
+    std::map<char, std::vector<naivebayes::Image *>> image_map =
+        model.GetTrainingImageMap();
+
+    std::vector<naivebayes::Image *> images;
+
+    for (const auto &itr : image_map) {
+      images.insert(images.end(), itr.second.begin(), itr.second.end());
+    }
+
+    size_t num_correct = 0;
+
+    for (size_t held_out = 0; held_out < images.size(); ++held_out) {
+      naivebayes::FeatureCounts counts(3, 3, {'0', '1'});
+
+      for (size_t image = 0; image < images.size(); ++image) {
+        if (image != held_out) {
+          counts.AddImage(*images[image]);
+        }
+      }
+
+      Model fold_model;
+      fold_model.Train(counts);
+
+      if (fold_model.Predict(images[held_out]->GetPixels()) ==
+          images[held_out]->GetLabel()) {
+        ++num_correct;
+      }
+    }
+
+    naivebayes::CrossValidationReport report =
+        model.CrossValidate(images.size(), 4);
+
+    REQUIRE(report.pooled_accuracy ==
+            Approx(float(num_correct) / float(images.size())));
+  }
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include <core/model.h>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+#include "test_helpers.h"
+
+// Replaces the global allocator for the test binary, counting the heap
+// allocations made by the current thread while counting is switched on
+
+namespace {
+
+thread_local bool is_counting = false;
+thread_local size_t num_allocations = 0;
+
+void *CountedAllocate(size_t size) {
+  if (is_counting) {
+    ++num_allocations;
+  }
+
+  void *memory = std::malloc(size == 0 ? 1 : size);
+
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return memory;
+}
+
+/**
+ * Counts the heap allocations made by the calling thread while it is alive
+ */
+class AllocationCounter {
+
+public:
+  AllocationCounter() {
+    num_allocations = 0;
+    is_counting = true;
+  }
+
+  ~AllocationCounter() { is_counting = false; }
+
+  size_t GetCount() const { return num_allocations; }
+};
+
+} // namespace
+
+void *operator new(size_t size) { return CountedAllocate(size); }
+
+void *operator new[](size_t size) { return CountedAllocate(size); }
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete[](void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, size_t) noexcept { std::free(memory); }
+
+void operator delete[](void *memory, size_t) noexcept { std::free(memory); }
+
+using naivebayes::Image;
+using naivebayes::Model;
+using naivebayes::Pixel;
+
+TEST_CASE("Predicting allocates nothing once warm", "[allocation]") {
+  std::stringstream training_stream(kSmallTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+
+  std::vector<std::vector<Pixel>> zero =
+      Image({"###", "# #", "###"}, '0').GetPixels();
+  std::vector<std::vector<Pixel>> one =
+      Image({" # ", " # ", " # "}, '1').GetPixels();
+
+  SECTION("Uncached predictions") {
+    char warm_up = model.Predict(zero);
+
+    AllocationCounter counter;
+    char first_prediction = model.Predict(zero);
+    char second_prediction = model.Predict(one);
+
+    REQUIRE(counter.GetCount() == 0);
+    REQUIRE(first_prediction == warm_up);
+    REQUIRE(second_prediction == '1');
+  }
+
+  SECTION("Cache hits") {
+    model.EnablePredictionCache(4);
+    model.Predict(zero);
+    model.Predict(zero);
+
+    AllocationCounter counter;
+    model.Predict(zero);
+
+    REQUIRE(counter.GetCount() == 0);
+  }
+
+  SECTION("Early exit classification") {
+    naivebayes::LogProbTable table(*model.GetTrainer());
+    Image image(3, '0', zero);
+    naivebayes::EarlyExitStats stats = {0, 0, 0};
+    char warm_up = table.ClassifyEarlyExit(image, &stats);
+
+    AllocationCounter counter;
+    char prediction = table.ClassifyEarlyExit(image, &stats);
+
+    REQUIRE(counter.GetCount() == 0);
+    REQUIRE(prediction == warm_up);
+  }
+
+  SECTION("The counter sees allocations") {
+    AllocationCounter counter;
+    std::vector<int> *allocated = new std::vector<int>(4);
+    delete allocated;
+
+    REQUIRE(counter.GetCount() == 2);
+  }
+}
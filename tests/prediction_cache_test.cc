@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include <core/model.h>
+#include <core/prediction_cache.h>
+#include <sstream>
+
+#include "test_helpers.h"
+
+using naivebayes::Image;
+using naivebayes::Model;
+using naivebayes::Pixel;
+using naivebayes::PredictionCache;
+
+TEST_CASE("Prediction cache lookups", "[cache]") {
+  std::vector<std::vector<Pixel>> first_grid =
+      Image({"#+#", "# #", "#+#"}, '0').GetPixels();
+  std::vector<std::vector<Pixel>> second_grid =
+      Image({" ##", "  #", " ##"}, '1').GetPixels();
+
+  SECTION("Cached predictions are returned") {
+    PredictionCache cache(2);
+    char prediction = 0;
+
+    REQUIRE_FALSE(cache.Lookup(1, first_grid, prediction));
+    cache.Insert(1, first_grid, '0');
+
+    REQUIRE(cache.Lookup(1, first_grid, prediction));
+    REQUIRE(prediction == '0');
+    REQUIRE(cache.GetHits() == 1);
+    REQUIRE(cache.GetMisses() == 1);
+  }
+
+  SECTION("Predictions of other model versions are not returned") {
+    PredictionCache cache(2);
+    char prediction = 0;
+    cache.Insert(1, first_grid, '0');
+
+    REQUIRE_FALSE(cache.Lookup(2, first_grid, prediction));
+  }
+
+  SECTION("The least recently used prediction is evicted") {
+    PredictionCache cache(1);
+    char prediction = 0;
+
+    cache.Insert(1, first_grid, '0');
+    cache.Insert(1, second_grid, '1');
+
+    REQUIRE(cache.GetSize() == 1);
+    REQUIRE(cache.GetEvictions() == 1);
+    REQUIRE_FALSE(cache.Lookup(1, first_grid, prediction));
+    REQUIRE(cache.Lookup(1, second_grid, prediction));
+    REQUIRE(prediction == '1');
+  }
+
+  SECTION("Images with different pixels have different keys") {
+    REQUIRE(PredictionCache::PackKey(1, first_grid) !=
+            PredictionCache::PackKey(1, second_grid));
+  }
+}
+
+TEST_CASE("Model prediction cache", "[cache][model]") {
+  std::stringstream training_stream(kSmallTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+  model.EnablePredictionCache(16);
+
+  std::vector<std::string> ascii_image{"#+#", "# #", "#+#"};
+
+  SECTION("Repeated images are predicted from the cache") {
+    char prediction = model.Predict(ascii_image);
+
+    REQUIRE(model.Predict(ascii_image) == prediction);
+    REQUIRE(model.GetPredictionCache()->GetHits() == 1);
+    REQUIRE(model.GetPredictionCache()->GetMisses() == 1);
+  }
+
+  SECTION("Retraining invalidates the cache") {
+    model.Predict(ascii_image);
+    uint64_t version = model.GetVersion();
+
+    model.Train();
+
+    REQUIRE(model.GetVersion() != version);
+    REQUIRE(model.GetPredictionCache()->GetSize() == 0);
+  }
+}
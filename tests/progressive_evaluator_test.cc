@@ -0,0 +1,300 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <core/progressive_evaluator.h>
+#include <set>
+
+#include "test_helpers.h"
+
+using naivebayes::Image;
+using naivebayes::LogProbTable;
+using naivebayes::ProgressiveEvaluation;
+using naivebayes::ProgressiveEvaluator;
+using naivebayes::ProgressiveStop;
+
+/**
+ * Builds square images of vertical bars, one bar position per label, with
+ * noise that makes some of them ambiguous. Label i shades the i-th band of
+ * image_size / num_labels columns
+ *
+ * @param num_images the number of images, cycling through the labels
+ * @param image_size the width and height of every image
+ * @param num_labels the number of labels, from '0' up
+ * @param seed varies the noise between datasets
+ * @return the labeled images
+ */
+std::vector<Image> BuildBarImages(size_t num_images, size_t image_size,
+                                  size_t num_labels, size_t seed) {
+  std::vector<Image> images;
+  size_t band_width = image_size / num_labels;
+
+  for (size_t image = 0; image < num_images; ++image) {
+    size_t label = image % num_labels;
+    std::vector<std::string> ascii_image(image_size,
+                                         std::string(image_size, ' '));
+
+    for (size_t row = 0; row < image_size; ++row) {
+      for (size_t col = 0; col < image_size; ++col) {
+        bool is_shaded = col / band_width == label;
+        size_t noise = (image * 131 + row * 17 + col * 29 + seed * 7) % 11;
+
+        // Up to three in eleven pixels are flipped, more in some images
+        if (noise < image % 4) {
+          is_shaded = !is_shaded;
+        }
+
+        ascii_image[row][col] = is_shaded ? '#' : (noise == 10 ? '+' : ' ');
+      }
+    }
+
+    images.emplace_back(ascii_image, char('0' + label));
+  }
+
+  return images;
+}
+
+TEST_CASE("Progressive evaluator options", "[constructor][progressive]") {
+
+  SECTION("Defaults use 95% confidence") {
+    ProgressiveEvaluator evaluator;
+
+    REQUIRE(evaluator.GetOptions().confidence == 0.95);
+    REQUIRE(evaluator.GetOptions().is_stratified);
+  }
+
+  SECTION("Invalid confidence levels and widths are rejected") {
+    REQUIRE_THROWS_AS(ProgressiveEvaluator({1.0, 0.01, 100, true, 0}),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(ProgressiveEvaluator({0.95, 0.0, 100, true, 0}),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Wilson score intervals", "[progressive][wilson]") {
+  double lower = 0.0;
+  double upper = 0.0;
+
+  SECTION("Half of the trials succeeding is centered on a half") {
+    ProgressiveEvaluator::WilsonInterval(5, 10, 1.96, lower, upper);
+
+    REQUIRE(lower == Approx(0.2366).epsilon(0.001));
+    REQUIRE(upper == Approx(0.7634).epsilon(0.001));
+  }
+
+  SECTION("No successes still has a positive upper bound") {
+    ProgressiveEvaluator::WilsonInterval(0, 10, 1.96, lower, upper);
+
+    REQUIRE(lower == 0.0);
+    REQUIRE(upper == Approx(0.2775).epsilon(0.001));
+  }
+
+  SECTION("No trials cover every proportion") {
+    ProgressiveEvaluator::WilsonInterval(0, 0, 1.96, lower, upper);
+
+    REQUIRE(lower == 0.0);
+    REQUIRE(upper == 1.0);
+  }
+}
+
+TEST_CASE("Exact sign test", "[progressive][sign]") {
+
+  SECTION("An even split is no evidence either way") {
+    REQUIRE(ProgressiveEvaluator::SignTestPValue(0, 0) == 1.0);
+    REQUIRE(ProgressiveEvaluator::SignTestPValue(5, 5) == Approx(1.0));
+  }
+
+  SECTION("Few disagreements are weak evidence") {
+    // A normal approximation would call four to none significant
+    REQUIRE(ProgressiveEvaluator::SignTestPValue(4, 0) == Approx(0.125));
+    REQUIRE(ProgressiveEvaluator::SignTestPValue(0, 4) == Approx(0.125));
+    REQUIRE(ProgressiveEvaluator::SignTestPValue(9, 1) ==
+            Approx(0.021484375));
+  }
+
+  SECTION("Long runs do not underflow") {
+    REQUIRE(ProgressiveEvaluator::SignTestPValue(1500, 1500) == Approx(1.0));
+    REQUIRE(ProgressiveEvaluator::SignTestPValue(1200, 1800) < 1e-20);
+  }
+}
+
+TEST_CASE("Progressive checkpoints", "[progressive][checkpoints]") {
+  REQUIRE(ProgressiveEvaluator::Checkpoints(50, 1000) ==
+          std::vector<size_t>{50, 100, 200, 400, 800, 1000});
+  REQUIRE(ProgressiveEvaluator::Checkpoints(50, 400) ==
+          std::vector<size_t>{50, 100, 200, 400});
+  REQUIRE(ProgressiveEvaluator::Checkpoints(0, 3) ==
+          std::vector<size_t>{1, 2, 3});
+  REQUIRE(ProgressiveEvaluator::Checkpoints(50, 20) ==
+          std::vector<size_t>{20});
+  REQUIRE(ProgressiveEvaluator::Checkpoints(50, 0).empty());
+}
+
+TEST_CASE("Progressive scoring order", "[progressive][order]") {
+  std::vector<Image> images = BuildBarImages(90, 4, 2, 1);
+
+  // A third of the images have a third label
+  for (size_t image = 0; image < 90; image += 3) {
+    images[image] = Image(4, '2', images[image].GetPixels());
+  }
+
+  SECTION("Orders are permutations that depend only on the seed") {
+    for (bool is_stratified : {false, true}) {
+      std::vector<size_t> order =
+          ProgressiveEvaluator::ScoringOrder(images, is_stratified, 7);
+
+      REQUIRE(std::set<size_t>(order.begin(), order.end()).size() == 90);
+      REQUIRE(*std::max_element(order.begin(), order.end()) == 89);
+      REQUIRE(order ==
+              ProgressiveEvaluator::ScoringOrder(images, is_stratified, 7));
+      REQUIRE(order !=
+              ProgressiveEvaluator::ScoringOrder(images, is_stratified, 8));
+    }
+  }
+
+  SECTION("Stratified prefixes hold each label in proportion") {
+    std::vector<size_t> order =
+        ProgressiveEvaluator::ScoringOrder(images, true, 7);
+    size_t num_third_label = 0;
+
+    for (size_t prefix = 0; prefix < order.size(); ++prefix) {
+      num_third_label += images[order[prefix]].GetLabel() == '2' ? 1 : 0;
+
+      REQUIRE(num_third_label * 3 <= prefix + 1 + 3);
+      REQUIRE(num_third_label * 3 + 3 >= prefix + 1);
+    }
+  }
+}
+
+/**
+ * Builds 3x3 images whose label is told by the left column to one model and
+ * by the right column to the other
+ *
+ * @param is_left_column whether the left column tells the labels apart
+ * @return the training images of the model
+ */
+std::vector<Image> BuildColumnImages(bool is_left_column) {
+  std::vector<Image> images;
+
+  for (size_t image = 0; image < 40; ++image) {
+    char label = char('0' + image % 2);
+    // The other column is shaded in half of the images of each label
+    bool is_telling_shaded = label == '0';
+    bool is_other_shaded = image % 4 < 2;
+    std::vector<std::string> ascii_image(3, "   ");
+
+    for (std::string &row : ascii_image) {
+      row[0] = (is_left_column ? is_telling_shaded : is_other_shaded) ? '#'
+                                                                      : ' ';
+      row[2] = (is_left_column ? is_other_shaded : is_telling_shaded) ? '#'
+                                                                      : ' ';
+    }
+
+    images.emplace_back(ascii_image, label);
+  }
+
+  return images;
+}
+
+TEST_CASE("Progressive evaluation of equally accurate models",
+          "[progressive][baseline]") {
+  LogProbTable left_table = TrainTable(BuildColumnImages(true));
+  LogProbTable right_table = TrainTable(BuildColumnImages(false));
+
+  // Each model gets a hundred images right that the other gets wrong
+  std::vector<Image> testing_images;
+  const std::vector<std::pair<std::string, char>> kinds{
+      {"# #", '0'}, {"   ", '1'}, {"#  ", '0'}, {"  #", '0'}};
+
+  for (const std::pair<std::string, char> &kind : kinds) {
+    for (size_t image = 0; image < 100; ++image) {
+      testing_images.emplace_back(
+          std::vector<std::string>(3, kind.first), kind.second);
+    }
+  }
+
+  ProgressiveEvaluation full =
+      ProgressiveEvaluator({0.95, 1e-9, 20, false, 0})
+          .Evaluate(testing_images, right_table, &left_table);
+
+  REQUIRE(full.num_images == 400);
+  REQUIRE(full.num_correct == 300);
+  REQUIRE(full.num_baseline_correct == 300);
+  REQUIRE(full.num_candidate_only == 100);
+  REQUIRE(full.num_baseline_only == 100);
+
+  SECTION("False rejections stay within the requested error rate") {
+    size_t num_rejections = 0;
+
+    for (uint64_t seed = 0; seed < 500; ++seed) {
+      ProgressiveEvaluation evaluation =
+          ProgressiveEvaluator({0.95, 1e-9, 20, false, seed})
+              .Evaluate(testing_images, right_table, &left_table);
+
+      num_rejections +=
+          evaluation.stop == ProgressiveStop::kWorseThanBaseline ? 1 : 0;
+    }
+
+    REQUIRE(num_rejections <= 25);
+  }
+}
+
+TEST_CASE("Progressive evaluation", "[progressive]") {
+  std::vector<Image> training_images = BuildBarImages(200, 4, 2, 1);
+  std::vector<Image> testing_images = BuildBarImages(1000, 4, 2, 2);
+  LogProbTable table = TrainTable(training_images);
+
+  SECTION("A wide target stops once the minimum images are scored") {
+    ProgressiveEvaluator evaluator({0.95, 0.9, 50, true, 1});
+    ProgressiveEvaluation evaluation =
+        evaluator.Evaluate(testing_images, table);
+
+    REQUIRE(evaluation.stop == ProgressiveStop::kConverged);
+    REQUIRE(evaluation.num_images == 50);
+    REQUIRE(evaluation.num_available == 1000);
+    REQUIRE(evaluation.accuracy_lower <= evaluation.accuracy);
+    REQUIRE(evaluation.accuracy_upper >= evaluation.accuracy);
+  }
+
+  SECTION("An unreachable target scores every image") {
+    ProgressiveEvaluator evaluator({0.95, 1e-9, 50, false, 1});
+    ProgressiveEvaluation evaluation =
+        evaluator.Evaluate(testing_images, table);
+    size_t num_correct = 0;
+
+    for (const Image &image : testing_images) {
+      num_correct += table.Classify(image) == image.GetLabel() ? 1 : 0;
+    }
+
+    REQUIRE(evaluation.stop == ProgressiveStop::kExhausted);
+    REQUIRE(evaluation.num_images == 1000);
+    REQUIRE(evaluation.num_correct == num_correct);
+  }
+
+  SECTION("A worse candidate is rejected early") {
+    // Trained on the wrong labels, so it is right where the baseline is wrong
+    std::vector<Image> swapped_images;
+
+    for (const Image &image : training_images) {
+      swapped_images.emplace_back(4, image.GetLabel() == '0' ? '1' : '0',
+                                  image.GetPixels());
+    }
+
+    LogProbTable worse_table = TrainTable(swapped_images);
+    ProgressiveEvaluator evaluator({0.95, 1e-9, 50, true, 1});
+    ProgressiveEvaluation evaluation =
+        evaluator.Evaluate(testing_images, worse_table, &table);
+
+    REQUIRE(evaluation.stop == ProgressiveStop::kWorseThanBaseline);
+    REQUIRE(evaluation.num_images < 1000);
+    REQUIRE(evaluation.p_value < 0.05);
+    REQUIRE(evaluation.difference < 0.0);
+    REQUIRE(evaluation.num_baseline_correct > evaluation.num_correct);
+  }
+
+  SECTION("Images of the wrong size are rejected") {
+    std::vector<Image> wrong_size{Image({"##", "##"}, '0')};
+
+    REQUIRE_THROWS_AS(ProgressiveEvaluator().Evaluate(wrong_size, table),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,244 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <core/dataset_reader.h>
+#include <core/model.h>
+#include <core/pruned_table.h>
+#include <sstream>
+
+using naivebayes::Image;
+using naivebayes::LogProbTable;
+using naivebayes::Model;
+using naivebayes::PixelRanking;
+using naivebayes::PrunedTable;
+using naivebayes::PruningPoint;
+
+// The center pixel tells the labels apart best, and the top left pixel is the
+// same in every image
+const std::string kPruningTrainingSet = "0\n#  \n # \n   \n"
+                                        "0\n# #\n # \n   \n"
+                                        "1\n#  \n   \n  +\n"
+                                        "1\n# #\n   \n +#\n"
+                                        "0\n#  \n # \n #+\n"
+                                        "1\n#  \n   \n # \n";
+
+const std::string kPruningTestingSet = "0\n#  \n # \n + \n"
+                                       "1\n# #\n   \n  #\n"
+                                       "0\n#  \n#  \n   \n"
+                                       "1\n # \n   \n#  \n";
+
+TEST_CASE("Pixel ranking", "[pruning][ranking]") {
+  std::stringstream training_stream(kPruningTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+  LogProbTable table(*model.GetTrainer());
+
+  for (PixelRanking ranking :
+       {PixelRanking::kMutualInformation, PixelRanking::kMaxDivergence}) {
+    std::vector<double> pixel_scores = PrunedTable::ScorePixels(table, ranking);
+    std::vector<size_t> ranked_pixels = PrunedTable::RankPixels(table, ranking);
+
+    REQUIRE(pixel_scores.size() == 9);
+    REQUIRE(ranked_pixels.size() == 9);
+    REQUIRE(ranked_pixels[0] == 4);
+
+    // A pixel with the same shade in every image tells nothing apart
+    REQUIRE(pixel_scores[0] == Approx(0.0).margin(1e-6));
+    REQUIRE(pixel_scores[4] > pixel_scores[8]);
+    REQUIRE(pixel_scores[8] > pixel_scores[0]);
+  }
+}
+
+TEST_CASE("Pruned table scoring", "[pruning]") {
+  std::stringstream training_stream(kPruningTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+  LogProbTable table(*model.GetTrainer());
+
+  std::vector<Image> images{Image({"#  ", " # ", " + "}, '0'),
+                            Image({"# #", "   ", "  #"}, '1'),
+                            Image({" + ", "#  ", "+ #"}, '1')};
+
+  SECTION("Keeping every pixel scores the same as the full table") {
+    PrunedTable pruned(table, 9);
+
+    for (const Image &image : images) {
+      std::vector<float> full_scores;
+      std::vector<float> pruned_scores;
+      table.Score(image, full_scores);
+      pruned.Score(image, pruned_scores);
+
+      REQUIRE(pruned_scores == full_scores);
+      REQUIRE(pruned.Classify(image) == table.Classify(image));
+    }
+  }
+
+  SECTION("Only the highest ranked pixels are kept, in row major order") {
+    PrunedTable pruned(table, 3, PixelRanking::kMaxDivergence);
+    std::vector<size_t> ranked_pixels =
+        PrunedTable::RankPixels(table, PixelRanking::kMaxDivergence);
+    std::vector<size_t> expected_pixels(ranked_pixels.begin(),
+                                        ranked_pixels.begin() + 3);
+    std::sort(expected_pixels.begin(), expected_pixels.end());
+
+    REQUIRE(pruned.GetPixels() == expected_pixels);
+    REQUIRE(pruned.GetLabels() == table.GetLabels());
+  }
+
+  SECTION("A single discriminative pixel still separates the labels") {
+    PrunedTable pruned(table, 1);
+
+    REQUIRE(pruned.GetPixels() == std::vector<size_t>{4});
+    REQUIRE(pruned.Classify(images[0]) == '0');
+    REQUIRE(pruned.Classify(images[1]) == '1');
+  }
+
+  SECTION("Invalid prunings and images are rejected") {
+    REQUIRE_THROWS_AS(PrunedTable(table, 10), std::invalid_argument);
+
+    std::vector<float> scores;
+
+    REQUIRE_THROWS_AS(PrunedTable(table, 4).Score(Image({"##", "##"}, '0'),
+                                                  scores),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Pruned table serialization", "[pruning][istream][ostream]") {
+  std::stringstream training_stream(kPruningTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+  LogProbTable table(*model.GetTrainer());
+  PrunedTable pruned(table, 5);
+
+  SECTION("Pruned tables survive a round trip exactly") {
+    std::stringstream stream;
+    stream << pruned;
+
+    PrunedTable loaded;
+    stream >> loaded;
+
+    Image image({"# +", " # ", "+ #"}, '0');
+    std::vector<float> scores;
+    std::vector<float> loaded_scores;
+    pruned.Score(image, scores);
+    loaded.Score(image, loaded_scores);
+
+    REQUIRE(loaded.GetPixels() == pruned.GetPixels());
+    REQUIRE(loaded.GetImageSize() == 3);
+    REQUIRE(loaded_scores == scores);
+  }
+
+  SECTION("Truncated tables are rejected") {
+    std::stringstream stream;
+    stream << pruned;
+    std::string saved = stream.str();
+    std::stringstream truncated(saved.substr(0, saved.size() / 2));
+
+    PrunedTable loaded;
+
+    REQUIRE_THROWS_AS(truncated >> loaded, std::invalid_argument);
+  }
+
+  SECTION("Unpruned models are rejected") {
+    std::stringstream stream;
+    stream << *model.GetTrainer();
+
+    PrunedTable loaded;
+
+    REQUIRE_THROWS_AS(stream >> loaded, std::invalid_argument);
+  }
+
+  SECTION("Pixels outside of the image are rejected") {
+    std::stringstream stream("3\n3\n1\n0\n\n1\n9\n0\n0\n0\n0\n");
+
+    PrunedTable loaded;
+
+    REQUIRE_THROWS_AS(stream >> loaded, std::invalid_argument);
+  }
+}
+
+TEST_CASE("Pruning evaluation", "[pruning][evaluate]") {
+  std::stringstream training_stream(kPruningTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+  LogProbTable table(*model.GetTrainer());
+
+  std::stringstream testing_stream(kPruningTestingSet);
+  std::vector<PruningPoint> points =
+      PrunedTable::EvaluatePruning(table, testing_stream, {9, 1, 4});
+
+  REQUIRE(points.size() == 3);
+  REQUIRE(points[0].num_pixels == 9);
+  REQUIRE(points[0].num_disagreements == 0);
+
+  for (const PruningPoint &point : points) {
+    PrunedTable pruned(table, point.num_pixels);
+    std::stringstream image_stream(kPruningTestingSet);
+    Image image;
+    size_t num_correct = 0;
+
+    while (naivebayes::DatasetReader::ReadImage(image_stream, image)) {
+      num_correct += pruned.Classify(image) == image.GetLabel() ? 1 : 0;
+    }
+
+    REQUIRE(point.num_images == 4);
+    REQUIRE(point.num_correct == num_correct);
+    REQUIRE(point.accuracy == float(num_correct) / 4.0f);
+  }
+}
+
+TEST_CASE("Pruned table stream classification", "[pruning][stream]") {
+  std::stringstream training_stream(kPruningTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+  LogProbTable table(*model.GetTrainer());
+
+  std::stringstream saved_stream;
+  saved_stream << PrunedTable(table, 4);
+  PrunedTable pruned;
+  saved_stream >> pruned;
+
+  SECTION("Every image gets its predicted label on its own line") {
+    std::stringstream testing_stream(kPruningTestingSet);
+    std::stringstream output;
+    std::stringstream image_stream(kPruningTestingSet);
+    std::string expected;
+    Image image;
+
+    while (naivebayes::DatasetReader::ReadImage(image_stream, image)) {
+      expected += std::string(1, pruned.Classify(image)) + "\n";
+    }
+
+    REQUIRE(pruned.Classify(testing_stream, output) == 4);
+    REQUIRE(output.str() == expected);
+  }
+
+  SECTION("Scores follow the label, separated by tabs") {
+    std::stringstream testing_stream("0\n#  \n # \n + \n");
+    std::stringstream output;
+    pruned.Classify(testing_stream, output, true);
+
+    std::vector<float> scores;
+    pruned.Score(Image({"#  ", " # ", " + "}, '0'), scores);
+    std::string line = output.str();
+
+    REQUIRE(line[0] == '0');
+    REQUIRE(std::count(line.begin(), line.end(), '\t') == 2);
+    REQUIRE(std::stof(line.substr(line.find('\t') + 1)) ==
+            Approx(scores[0]));
+  }
+
+  SECTION("Images of the wrong size are rejected") {
+    std::stringstream testing_stream("0\n##\n##\n");
+    std::stringstream output;
+
+    REQUIRE_THROWS_AS(pruned.Classify(testing_stream, output),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,123 @@
+#include <catch2/catch.hpp>
+
+#include <core/image.h>
+#include <core/row_decoder.h>
+#include <string>
+#include <vector>
+
+using naivebayes::DecodeRow;
+using naivebayes::DecodeRowPacked;
+using naivebayes::DecodeRowPackedScalar;
+using naivebayes::DecodeRowScalar;
+using naivebayes::Image;
+using naivebayes::Pixel;
+
+/**
+ * Decodes a row with every decoder and counts how many disagree with the
+ * scalar reference
+ *
+ * @param row the characters of the row
+ * @return the number of decoders whose output differs
+ */
+size_t CountDecoderMismatches(const std::string &row) {
+  std::vector<uint8_t> expected(row.size());
+  DecodeRowScalar(row.data(), row.size(), expected.data());
+
+  std::vector<uint8_t> expected_packed((row.size() + 3) / 4, 0);
+
+  for (size_t col = 0; col < row.size(); ++col) {
+    expected_packed[col / 4] |= uint8_t(expected[col] << (2 * (col % 4)));
+  }
+
+  // Filled with a byte no decoder writes, so untouched output is caught
+  std::vector<uint8_t> shades(row.size(), 0xAA);
+  std::vector<uint8_t> packed(expected_packed.size(), 0xAA);
+  std::vector<uint8_t> scalar_packed(expected_packed.size(), 0xAA);
+
+  DecodeRow(row.data(), row.size(), shades.data());
+  DecodeRowPacked(row.data(), row.size(), packed.data());
+  DecodeRowPackedScalar(row.data(), row.size(), scalar_packed.data());
+
+  return size_t(shades != expected) + size_t(packed != expected_packed) +
+         size_t(scalar_packed != expected_packed);
+}
+
+TEST_CASE("Scalar row decoder", "[decoder]") {
+
+  SECTION("Characters map to their shades") {
+    std::string row = "# +x#";
+    std::vector<uint8_t> shades(row.size());
+    DecodeRowScalar(row.data(), row.size(), shades.data());
+
+    REQUIRE(shades == std::vector<uint8_t>{2, 0, 1, 0, 2});
+  }
+
+  SECTION("Packed shades put the first pixel in the lowest bits") {
+    std::string row = "+ #++";
+    std::vector<uint8_t> packed(2);
+    DecodeRowPackedScalar(row.data(), row.size(), packed.data());
+
+    REQUIRE(packed == std::vector<uint8_t>{0x61, 0x01});
+  }
+}
+
+TEST_CASE("Vectorized row decoder equals the scalar decoder", "[decoder]") {
+
+  SECTION("Every byte at every position of every length up to 64") {
+    size_t mismatches = 0;
+
+    for (size_t length = 0; length <= 64; ++length) {
+      for (size_t position = 0; position < length; ++position) {
+        for (int byte = 0; byte < 256; ++byte) {
+          std::string row(length, position % 2 == 0 ? '#' : '+');
+          row[position] = char(byte);
+          mismatches += CountDecoderMismatches(row);
+        }
+      }
+    }
+
+    REQUIRE(mismatches == 0);
+  }
+
+  SECTION("Every pattern of 8 characters across a vector boundary") {
+    const std::string characters = " +#.";
+    size_t mismatches = 0;
+
+    for (size_t code = 0; code < 65536; ++code) {
+      std::string row(28, ' ');
+      size_t remaining = code;
+
+      for (size_t col = 12; col < 20; ++col) {
+        row[col] = characters[remaining % 4];
+        remaining /= 4;
+      }
+
+      mismatches += CountDecoderMismatches(row);
+    }
+
+    REQUIRE(mismatches == 0);
+  }
+}
+
+TEST_CASE("Images decode rows with the vectorized decoder", "[decoder]") {
+  std::vector<std::string> ascii_image;
+
+  for (size_t row = 0; row < 28; ++row) {
+    std::string line;
+
+    for (size_t col = 0; col < 28; ++col) {
+      line += " +#"[(row * 7 + col * 3) % 3];
+    }
+
+    ascii_image.push_back(line);
+  }
+
+  Image image(ascii_image, '4');
+
+  for (size_t row = 0; row < 28; ++row) {
+    for (size_t col = 0; col < 28; ++col) {
+      REQUIRE(image.GetPixelStatusByLocation(row, col) ==
+              Pixel((row * 7 + col * 3) % 3));
+    }
+  }
+}
@@ -0,0 +1,113 @@
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <core/sketch_grid.h>
+
+using naivebayes::Pixel;
+using naivebayes::SketchGrid;
+
+/**
+ * Shades every pixel within the brush radius of a point by checking every
+ * pixel of the grid, like the original sketchpad did
+ */
+std::vector<std::vector<Pixel>> BrushEveryPixel(size_t size, double radius,
+                                                double x, double y) {
+  std::vector<std::vector<Pixel>> pixels(
+      size, std::vector<Pixel>(size, Pixel::kUnshaded));
+
+  for (size_t row = 0; row < size; ++row) {
+    for (size_t col = 0; col < size; ++col) {
+      double offset_x = x - (double(col) + 0.5);
+      double offset_y = y - (double(row) + 0.5);
+
+      if (offset_x * offset_x + offset_y * offset_y <= radius * radius) {
+        pixels[row][col] = Pixel::kShaded;
+      }
+    }
+  }
+
+  return pixels;
+}
+
+TEST_CASE("Sketch grid constructor", "[constructor][sketch]") {
+  SketchGrid grid(4);
+
+  REQUIRE(grid.GetNumPixelsPerSide() == 4);
+  REQUIRE(grid.GetBrushRadius() == Approx(1.15));
+  REQUIRE(grid.GetPixelGrid() ==
+          std::vector<std::vector<Pixel>>(
+              4, std::vector<Pixel>(4, Pixel::kUnshaded)));
+}
+
+TEST_CASE("Sketch grid brush", "[sketch]") {
+
+  SECTION("Bounding box brushing matches checking every pixel") {
+    for (double y = -2.0; y <= 10.0; y += 0.37) {
+      for (double x = -2.0; x <= 10.0; x += 0.41) {
+        SketchGrid grid(8);
+        grid.Brush(x, y);
+
+        REQUIRE(grid.GetPixelGrid() == BrushEveryPixel(8, 1.15, x, y));
+      }
+    }
+  }
+
+  SECTION("A brush at a pixel center shades its neighbors") {
+    SketchGrid grid(3);
+    grid.Brush(1.5, 1.5);
+
+    REQUIRE(grid.GetPixelGrid()[1][1] == Pixel::kShaded);
+    REQUIRE(grid.GetPixelGrid()[0][1] == Pixel::kShaded);
+    REQUIRE(grid.GetPixelGrid()[0][0] == Pixel::kUnshaded);
+  }
+
+  SECTION("Clearing unshades every pixel") {
+    SketchGrid grid(3);
+    grid.Brush(1.5, 1.5);
+    grid.Clear();
+
+    REQUIRE(grid.GetPixelGrid()[1][1] == Pixel::kUnshaded);
+  }
+}
+
+TEST_CASE("Sketch grid segments", "[sketch]") {
+
+  SECTION("Segments leave no gaps between distant drag events") {
+    SketchGrid grid(28);
+    grid.BrushSegment(2.5, 14.5, 25.5, 14.5);
+
+    for (size_t col = 2; col <= 25; ++col) {
+      REQUIRE(grid.GetPixelGrid()[14][col] == Pixel::kShaded);
+    }
+
+    REQUIRE(grid.GetPixelGrid()[14][0] == Pixel::kUnshaded);
+    REQUIRE(grid.GetPixelGrid()[12][14] == Pixel::kUnshaded);
+  }
+
+  SECTION("Segments cover every brush stamp along them") {
+    SketchGrid grid(16);
+    grid.BrushSegment(1.2, 3.7, 13.9, 11.1);
+
+    for (double step = 0.0; step <= 1.0; step += 0.01) {
+      std::vector<std::vector<Pixel>> stamp =
+          BrushEveryPixel(16, 1.15, 1.2 + step * 12.7, 3.7 + step * 7.4);
+
+      for (size_t row = 0; row < 16; ++row) {
+        for (size_t col = 0; col < 16; ++col) {
+          if (stamp[row][col] == Pixel::kShaded) {
+            REQUIRE(grid.GetPixelGrid()[row][col] == Pixel::kShaded);
+          }
+        }
+      }
+    }
+  }
+
+  SECTION("Segments outside the grid shade nothing") {
+    SketchGrid grid(4);
+    grid.BrushSegment(-10.0, -10.0, -5.0, -3.0);
+
+    REQUIRE(grid.GetPixelGrid() ==
+            std::vector<std::vector<Pixel>>(
+                4, std::vector<Pixel>(4, Pixel::kUnshaded)));
+  }
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include <core/model.h>
+#include <core/stream_classifier.h>
+#include <sstream>
+
+#include "test_helpers.h"
+
+using naivebayes::Image;
+using naivebayes::LogProbTable;
+using naivebayes::Model;
+using naivebayes::StreamClassifier;
+using naivebayes::StreamFormat;
+
+TEST_CASE("Stream classification", "[stream]") {
+  std::stringstream training_stream(kSmallTrainingSet);
+  Model model;
+  training_stream >> model;
+  model.Train();
+
+  LogProbTable table(*model.GetTrainer());
+  std::vector<std::vector<std::string>> images{
+      {"###", "# #", "###"}, {" # ", " # ", " # "}, {"#+#", "   ", "#+#"},
+      {" ##", "## ", " # "}, {"   ", "   ", "   "}};
+
+  std::string ascii_stream;
+  std::string expected;
+
+  for (const std::vector<std::string> &image : images) {
+    ascii_stream += "?\n" + image[0] + "\n" + image[1] + "\n" + image[2] + "\n";
+    expected += std::string(1, model.Predict(image)) + "\n";
+  }
+
+  SECTION("Predictions are written in input order for any batching") {
+    for (size_t batch_size = 1; batch_size <= 6; ++batch_size) {
+      for (size_t num_threads = 1; num_threads <= 3; ++num_threads) {
+        StreamClassifier classifier(table, num_threads, batch_size);
+        std::stringstream input(ascii_stream);
+        std::stringstream output;
+
+        REQUIRE(classifier.Classify(input, output, StreamFormat::kAscii,
+                                    false) == images.size());
+        REQUIRE(output.str() == expected);
+      }
+    }
+  }
+
+  SECTION("Blank lines, carriage returns and a missing final newline") {
+    std::stringstream input("\n?\r\n###\r\n# #\r\n###\r\n\n?\n # \n # \n # ");
+    std::stringstream output;
+
+    StreamClassifier classifier(table, 1, 4);
+
+    REQUIRE(classifier.Classify(input, output, StreamFormat::kAscii, false) ==
+            2);
+    REQUIRE(output.str() == expected.substr(0, 4));
+  }
+
+  SECTION("Scores follow the label in label order") {
+    std::stringstream input("?\n###\n# #\n###\n");
+    std::stringstream output;
+
+    StreamClassifier classifier(table);
+    classifier.Classify(input, output, StreamFormat::kAscii, true);
+
+    std::vector<float> scores;
+    table.Score(Image({"###", "# #", "###"}, '?'), scores);
+
+    std::stringstream line(output.str());
+    char label;
+    float first_score;
+    float second_score;
+    line >> label >> first_score >> second_score;
+
+    REQUIRE(label == expected[0]);
+    REQUIRE(first_score == scores[0]);
+    REQUIRE(second_score == scores[1]);
+  }
+
+  SECTION("Packed images match ascii images") {
+    std::string packed_stream;
+
+    for (const std::vector<std::string> &image : images) {
+      std::vector<std::vector<naivebayes::Pixel>> pixels =
+          Image(image, '?').GetPixels();
+      std::string record(3, '\0');
+
+      for (size_t pixel = 0; pixel < 9; ++pixel) {
+        record[pixel / 4] |=
+            char(size_t(pixels[pixel / 3][pixel % 3]) << (2 * (pixel % 4)));
+      }
+
+      packed_stream += record;
+    }
+
+    StreamClassifier classifier(table, 2, 2);
+    std::stringstream input(packed_stream);
+    std::stringstream output;
+
+    REQUIRE(classifier.Classify(input, output, StreamFormat::kPacked,
+                                false) == images.size());
+    REQUIRE(output.str() == expected);
+  }
+
+  SECTION("Malformed images are rejected") {
+    StreamClassifier classifier(table, 1, 1);
+    std::stringstream output;
+
+    std::stringstream wrong_width("?\n###\n# #\n###\n?\n####\n# #\n###\n");
+    REQUIRE_THROWS_AS(classifier.Classify(wrong_width, output,
+                                          StreamFormat::kAscii, false),
+                      std::invalid_argument);
+    REQUIRE(output.str() == expected.substr(0, 2));
+
+    std::stringstream truncated("?\n###\n# #\n");
+    REQUIRE_THROWS_AS(
+        classifier.Classify(truncated, output, StreamFormat::kAscii, false),
+        std::invalid_argument);
+  }
+}
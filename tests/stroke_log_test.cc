@@ -0,0 +1,89 @@
+#include <catch2/catch.hpp>
+
+#include <core/stroke_log.h>
+#include <sstream>
+
+using naivebayes::Model;
+using naivebayes::SketchGrid;
+using naivebayes::StrokeEvent;
+using naivebayes::StrokeEventType;
+using naivebayes::StrokeRecorder;
+using naivebayes::StrokeReplayer;
+
+TEST_CASE("Stroke recorder", "[strokes]") {
+  StrokeRecorder recorder;
+  recorder.Record(StrokeEventType::kBrushDown, 1.5, 2.25);
+  recorder.Record(StrokeEventType::kPredict);
+
+  const std::vector<StrokeEvent> &events = recorder.GetEvents();
+
+  REQUIRE(events.size() == 2);
+  REQUIRE(events[0].type == StrokeEventType::kBrushDown);
+  REQUIRE(events[0].x == 1.5);
+  REQUIRE(events[0].y == 2.25);
+  REQUIRE(events[1].type == StrokeEventType::kPredict);
+  REQUIRE(events[1].time_us >= events[0].time_us);
+}
+
+TEST_CASE("Stroke logs", "[strokes][istream][ostream]") {
+
+  SECTION("Logs are written in the expected format") {
+    std::stringstream log;
+    naivebayes::WriteStrokeLog({{StrokeEventType::kBrushDown, 10, 1.5, 2.0},
+                                {StrokeEventType::kBrushDrag, 25, 3.0, 2.0},
+                                {StrokeEventType::kPredict, 40, 0.0, 0.0},
+                                {StrokeEventType::kClear, 52, 0.0, 0.0}},
+                               log);
+
+    REQUIRE(log.str() == "10 down 1.5 2\n25 drag 3 2\n40 predict\n52 clear\n");
+  }
+
+  SECTION("Logs survive a round trip") {
+    std::stringstream log("10 down 1.5 2\n\n25 drag 3 2.125\n40 predict\n");
+    std::vector<StrokeEvent> events = naivebayes::ReadStrokeLog(log);
+
+    REQUIRE(events.size() == 3);
+    REQUIRE(events[1].type == StrokeEventType::kBrushDrag);
+    REQUIRE(events[1].time_us == 25);
+    REQUIRE(events[1].y == 2.125);
+    REQUIRE(events[2].type == StrokeEventType::kPredict);
+  }
+
+  SECTION("Unknown events are rejected") {
+    std::stringstream log("10 erase 1 1\n");
+
+    REQUIRE_THROWS_AS(naivebayes::ReadStrokeLog(log), std::invalid_argument);
+  }
+
+  SECTION("Brush events without a position are rejected") {
+    std::stringstream log("10 down\n");
+
+    REQUIRE_THROWS_AS(naivebayes::ReadStrokeLog(log), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Stroke replay", "[strokes]") {
+  std::stringstream training_stream("0\n###\n# #\n###\n"
+                                    "1\n # \n # \n # \n");
+  Model model;
+  training_stream >> model;
+  model.Train();
+
+  SketchGrid grid(3, 0.5);
+  StrokeReplayer replayer(grid, model);
+
+  // Draws a vertical line down the middle column, then clears it
+  std::stringstream log("0 down 1.5 0.5\n"
+                        "5 drag 1.5 2.5\n"
+                        "9 predict\n"
+                        "12 clear\n"
+                        "15 predict\n");
+  replayer.Replay(naivebayes::ReadStrokeLog(log));
+
+  REQUIRE(replayer.GetPredictions().size() == 2);
+  REQUIRE(replayer.GetPredictions()[0] == '1');
+  REQUIRE(grid.GetPixelGrid()[1][1] == naivebayes::Pixel::kUnshaded);
+  REQUIRE(replayer.GetLatency(StrokeEventType::kBrushDrag).GetCount() == 2);
+  REQUIRE(replayer.GetLatency(StrokeEventType::kPredict).GetCount() == 2);
+  REQUIRE(replayer.GetLatency(StrokeEventType::kClear).GetCount() == 1);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <core/image.h>
+#include <core/log_prob_table.h>
+#include <core/model.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Four 3x3 images of two labels, small enough to check counts by hand
+const std::string kSmallTrainingSet = "0\n#+#\n# #\n#+#\n"
+                                      "1\n ##\n  #\n ##\n"
+                                      "1\n # \n## \n # \n"
+                                      "0\n###\n+ +\n###\n";
+
+/**
+ * Writes images as an ascii dataset, each label followed by its rows
+ *
+ * @param images the images to write
+ * @return the ascii dataset
+ */
+inline std::string WriteAsciiDataset(
+    const std::vector<naivebayes::Image> &images) {
+  std::stringstream dataset;
+
+  for (const naivebayes::Image &image : images) {
+    dataset << image.GetLabel() << '\n';
+
+    for (const std::vector<naivebayes::Pixel> &row : image.GetPixels()) {
+      for (naivebayes::Pixel pixel : row) {
+        dataset << " +#"[size_t(pixel)];
+      }
+      dataset << '\n';
+    }
+  }
+
+  return dataset.str();
+}
+
+/**
+ * Trains a model on an ascii dataset and compiles it
+ *
+ * @param dataset the ascii dataset of training images
+ * @return the compiled model
+ */
+inline naivebayes::LogProbTable TrainTable(const std::string &dataset) {
+  std::stringstream training_stream(dataset);
+  naivebayes::Model model;
+  training_stream >> model;
+  model.Train();
+
+  return naivebayes::LogProbTable(*model.GetTrainer());
+}
+
+/**
+ * Trains a model on a set of images and compiles it
+ *
+ * @param images the training images
+ * @return the compiled model
+ */
+inline naivebayes::LogProbTable
+TrainTable(const std::vector<naivebayes::Image> &images) {
+  return TrainTable(WriteAsciiDataset(images));
+}
@@ -0,0 +1,106 @@
+#include <catch2/catch.hpp>
+
+#include <core/model.h>
+#include <core/tracer.h>
+#include <sstream>
+#include <thread>
+
+#include "test_helpers.h"
+
+using naivebayes::TraceScope;
+using naivebayes::Tracer;
+
+TEST_CASE("Tracer records stages", "[tracer]") {
+  Tracer &tracer = Tracer::Global();
+
+  SECTION("Nothing is recorded while tracing is disabled") {
+    tracer.Disable();
+    size_t num_events = tracer.GetNumEvents();
+
+    { TraceScope trace("test", "Disabled"); }
+
+    REQUIRE(tracer.GetNumEvents() == num_events);
+  }
+
+  SECTION("Stages record a begin and end event") {
+    tracer.Enable();
+    size_t num_events = tracer.GetNumEvents();
+
+    { TraceScope trace("test", "Stage"); }
+
+    tracer.Disable();
+
+    REQUIRE(tracer.GetNumEvents() == num_events + 2);
+  }
+
+  SECTION("Stages that outgrow a block are all recorded") {
+    tracer.Enable();
+    size_t num_events = tracer.GetNumEvents();
+
+    for (size_t stage = 0; stage < 5000; ++stage) {
+      TraceScope trace("test", "Many");
+    }
+
+    tracer.Disable();
+
+    REQUIRE(tracer.GetNumEvents() == num_events + 10000);
+  }
+
+  SECTION("Every thread records into its own buffer") {
+    tracer.Enable();
+    size_t num_events = tracer.GetNumEvents();
+
+    std::thread first([] { TraceScope trace("test", "FirstThread"); });
+    std::thread second([] { TraceScope trace("test", "SecondThread"); });
+    first.join();
+    second.join();
+
+    tracer.Disable();
+
+    std::stringstream output;
+    tracer.WriteChromeTrace(output);
+
+    REQUIRE(tracer.GetNumEvents() == num_events + 4);
+    REQUIRE(output.str().find("\"name\": \"FirstThread\"") !=
+            std::string::npos);
+    REQUIRE(output.str().find("\"name\": \"SecondThread\"") !=
+            std::string::npos);
+  }
+
+  SECTION("Threads that have exited hand their buffers on") {
+    tracer.Enable();
+    size_t num_events = tracer.GetNumEvents();
+
+    // Starts the buffer pool with one released buffer
+    std::thread([] { TraceScope trace("test", "FirstWorker"); }).join();
+    size_t num_buffers = tracer.GetNumBuffers();
+
+    for (size_t worker = 0; worker < 50; ++worker) {
+      std::thread([] { TraceScope trace("test", "Worker"); }).join();
+    }
+
+    tracer.Disable();
+
+    REQUIRE(tracer.GetNumEvents() == num_events + 102);
+    REQUIRE(tracer.GetNumBuffers() == num_buffers);
+  }
+
+  SECTION("Model training is traced") {
+    tracer.Enable();
+
+    std::stringstream training_stream(kSmallTrainingSet);
+    naivebayes::Model model;
+    training_stream >> model;
+    model.Train();
+
+    tracer.Disable();
+
+    std::stringstream output;
+    tracer.WriteChromeTrace(output);
+
+    REQUIRE(output.str().find("{\"traceEvents\": [") == 0);
+    REQUIRE(output.str().find("\"name\": \"CalculateFeatures\", \"cat\": "
+                              "\"trainer\", \"ph\": \"B\"") !=
+            std::string::npos);
+  }
+}
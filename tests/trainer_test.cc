@@ -33,7 +33,7 @@ TEST_CASE("Trainer standard constructor", "[constructor]") {
   }
 
   SECTION("Trainer values are initialized to 0") {
-    Trainer trainer(1, 1, {});
+    Trainer trainer(1, 1, {'0'});
 
     REQUIRE(trainer.GetFeatures()[0][0][0][0] == 0.0f);
   }
@@ -73,8 +73,8 @@ TEST_CASE("Istream operator overload", "[istream]") {
     for (size_t width = 0; width < image_size; ++width) {
       for (size_t height = 0; height < image_size; ++height) {
         for (size_t pixel = 0; pixel < num_pixels; ++pixel) {
-          for (auto itr : test_trainer[width][height][pixel]) {
-            REQUIRE(itr.second == Approx(0.05555));
+          for (float feature : test_trainer[width][height][pixel]) {
+            REQUIRE(feature == Approx(0.05555));
           }
         }
       }
@@ -159,3 +159,27 @@ TEST_CASE("Clear values", "[trainer]") {
     REQUIRE(trainer.GetFeatures().empty());
   }
 }
+
+TEST_CASE("Trainer Laplace smoothing", "[trainer][laplace]") {
+
+  SECTION("Smoothing defaults to 1") {
+    Trainer trainer(1, 3, {'0'});
+
+    REQUIRE(trainer.GetLaplace() == 1.0f);
+  }
+
+  SECTION("Smoothing is applied to features and priors") {
+    naivebayes::FeatureCounts counts;
+    counts.AddImage(naivebayes::Image({"#"}, '0'));
+    counts.AddImage(naivebayes::Image({"#"}, '0'));
+    counts.AddImage(naivebayes::Image({"+"}, '1'));
+
+    Trainer trainer(1, 3, {'0', '1'}, 2.0f);
+    trainer.CalculateFeatures(counts);
+    trainer.CalculatePriors(counts);
+
+    REQUIRE(trainer.GetFeatures()[0][0][2].at(0) == Approx(4.0f / 8.0f));
+    REQUIRE(trainer.GetFeatures()[0][0][0].at(1) == Approx(2.0f / 7.0f));
+    REQUIRE(trainer.GetPriors().at(0) == Approx(4.0f / 7.0f));
+  }
+}